@@ -2,8 +2,8 @@
  * @file admin_controller.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.3.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -13,6 +13,7 @@
 #pragma once
 #include "crow.h"
 #include "middleware/auth_middleware.hpp" // WICHTIG: Middleware einbinden
+#include "middleware/compression_middleware.hpp"
 
 // Namespace rz::controller
 namespace rz {
@@ -21,7 +22,7 @@ namespace controller {
 class AdminController {
 public:
   // Wir akzeptieren jetzt spezifisch die App MIT AuthMiddleware
-  static void registerRoutes(crow::App<rz::middleware::AuthMiddleware> &app);
+  static void registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app);
 };
 
 } // namespace controller
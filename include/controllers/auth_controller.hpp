@@ -2,8 +2,8 @@
  * @file auth_controller.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Auth Controller with Notification Service injection
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.3.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -13,6 +13,7 @@
 #pragma once
 #include "crow.h"
 #include "middleware/auth_middleware.hpp"
+#include "middleware/compression_middleware.hpp"
 
 // Forward Declaration
 namespace rz {
@@ -38,7 +39,7 @@ public:
      * @param app Crow App instance
      */
     // KORRIGIERT: Voll qualifizierter Namespace für AuthMiddleware
-    void registerRoutes(crow::App<rz::middleware::AuthMiddleware>& app);
+    void registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware>& app);
 
 private:
     service::NotificationService* m_notifyService;
@@ -2,8 +2,8 @@
  * @file event_controller.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Event Controller Header
- * @version 0.3.4
- * @date 2026-01-03
+ * @version 0.4.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -13,6 +13,7 @@
 #pragma once
 #include "crow.h"
 #include "middleware/auth_middleware.hpp"
+#include "middleware/compression_middleware.hpp"
 
 // Forward Declaration
 namespace rz {
@@ -27,7 +28,7 @@ namespace controller {
 
 class EventController {
 public:
-  static void registerRoutes(crow::App<rz::middleware::AuthMiddleware>& app, service::NotificationService* notifyService);
+  static void registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware>& app, service::NotificationService* notifyService);
 };
 
 } // namespace controller
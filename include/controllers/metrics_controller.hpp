@@ -0,0 +1,35 @@
+/**
+ * @file metrics_controller.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Prometheus /metrics endpoint
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+#include "middleware/auth_middleware.hpp"
+#include "middleware/compression_middleware.hpp"
+
+namespace rz {
+namespace controller {
+
+/**
+ * @brief GET /metrics in Prometheus text format.
+ *
+ * Only active if CAKE_METRICS_TOKEN is set; the scraper sends it as
+ * "Authorization: Bearer <token>". Registers scrape-time collectors for
+ * the statistics the services already keep (SSE/WS hubs, caches, pools,
+ * rate limiter, mail queue, change bus, compression).
+ */
+class MetricsController {
+public:
+  static void registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app);
+};
+
+} // namespace controller
+} // namespace rz
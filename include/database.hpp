@@ -2,8 +2,8 @@
  * @file database.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.1.0
- * @date 2026-01-01
+ * @version 0.3.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -30,6 +30,9 @@ public:
   // Gibt die DB-Verbindung für den AKTUELLEN Thread zurück
   QSqlDatabase getDatabase();
 
+  // Schließt die Verbindung des AKTUELLEN Threads (z.B. vor fork())
+  void closeConnection();
+
   // Führt das Schema-Setup durch (Tabellen erstellen)
   bool migrate();
 
@@ -41,5 +44,11 @@ private:
   DatabaseManager(const DatabaseManager &) = delete;
   DatabaseManager &operator=(const DatabaseManager &) = delete;
 
+  // Fügt eine Spalte hinzu, falls sie in einer bestehenden DB noch fehlt
+  bool ensureColumn(QSqlDatabase &db, const QString &table,
+                    const QString &column, const QString &definition);
+
+  static QString connectionName();
+
   QString m_dbPath;
 };
@@ -2,8 +2,8 @@
  * @file auth_middleware.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Auth Middleware
- * @version 0.2.1
- * @date 2026-01-03
+ * @version 0.8.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,7 +12,17 @@
 
 #pragma once
 #include "crow.h"
+#include "utils/auth_context_cache.hpp"
+#include "utils/metrics.hpp"
+#include "utils/rate_limiter.hpp"
+#include "utils/request_trace.hpp"
+#include "utils/revocation_list.hpp"
+#include "utils/token_cache.hpp"
 #include "utils/token_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <memory>
 #include <string>
 
 namespace rz {
@@ -22,13 +32,30 @@ struct AuthMiddleware {
   // Kontext speichert Daten für den Controller
   struct context {
     rz::utils::TokenPayload currentUser;
+    // Gecachter Autorisierungs-Snapshot (nullptr bei Whitelist-Routen)
+    std::shared_ptr<const rz::utils::AuthSnapshot> auth;
+    // Start der Anfrage (Latenz-Metrik)
+    std::chrono::steady_clock::time_point started;
+    // Phasen für Server-Timing und Trace-Sampling
+    rz::utils::RequestTrace trace;
   };
 
   void before_handle(crow::request &req, crow::response &res, context &ctx) {
-    // 1. Whitelist
+    ctx.started = std::chrono::steady_clock::now();
+    ctx.trace.begin();
     std::string url = req.url;
+
+    // 0. Rate-Limit für Login/Registrierung (vor Body-Parsing und Argon2)
+    if (req.method == crow::HTTPMethod::POST &&
+        (url == "/api/login" || url == "/api/register" || url == "/api/auth/register")) {
+      if (!checkRateLimit(req, res)) return;
+    }
+
+    // 1. Whitelist
     if (url == "/api/login" || url == "/api/register" || url == "/api/status" ||
-        url.starts_with("/static")) {
+        url == "/api/auth/refresh" || url.starts_with("/static") ||
+        url == "/metrics" || // eigenes Token (CAKE_METRICS_TOKEN)
+        url == "/api/ws") { // WebSocket prüft das Token selbst (Query-Parameter)
       return;
     }
 
@@ -41,26 +68,102 @@ struct AuthMiddleware {
       return;
     }
 
-    // 3. Token extrahieren
-    std::string token = authHeader.substr(7);
-
-    // 4. Verifizieren
-    // KORREKTUR: 'token' ist bereits std::string, keine Konvertierung nötig!
-    auto payload = rz::utils::TokenUtils::verifyToken(token);
-
-    if (!payload) {
+    // 3. Token extrahieren, 4.-6. prüfen und Kontext füllen
+    std::string error;
+    bool authenticated;
+    {
+      rz::utils::TraceScope scope(&ctx.trace, "auth");
+      authenticated = authenticate(authHeader.substr(7), ctx, error);
+    }
+    if (!authenticated) {
       res.code = 403;
-      res.body = "Forbidden: Invalid or expired token.";
+      res.body = error;
       res.end();
       return;
     }
+  }
 
-    // 5. User-Daten im Kontext speichern
+  /**
+   * @brief Verify a bearer token and fill the context (also used by /api/ws).
+   *
+   * Checks the token cache / JWT, the revocation list and the cached
+   * authorization snapshot (account active).
+   * @return false with a message for a 403 answer.
+   */
+  static bool authenticate(const std::string &token, context &ctx, std::string &error) {
+    // Verifizieren (erst Cache, dann voller JWT-Check)
+    auto &cache = rz::utils::TokenCache::instance();
+    auto payload = cache.get(token);
+    if (!payload) {
+      payload = rz::utils::TokenUtils::verifyToken(token);
+      if (payload) cache.put(token, *payload);
+    }
+
+    // Widerrufene Sessions (Logout, Geräte-Abmeldung) sofort sperren
+    if (!payload ||
+        rz::utils::RevocationList::instance().isRevoked(payload->sessionId)) {
+      error = "Forbidden: Invalid or expired token.";
+      return false;
+    }
+
+    // Autorisierungs-Snapshot (aktiv, Admin, Gruppen) aus dem Cache
+    auto auth = rz::utils::AuthContextCache::instance().get(payload->userId);
+    if (!auth || !auth->isActive) {
+      error = "Forbidden: Account inactive.";
+      return false;
+    }
+
+    // User-Daten im Kontext speichern (Admin-Flag aus dem aktuellen Snapshot)
     ctx.currentUser = *payload;
+    ctx.currentUser.isAdmin = auth->isAdmin;
+    ctx.auth = std::move(auth);
+    return true;
+  }
+
+  /**
+   * @brief Apply the per-IP and per-email token buckets.
+   * @return false if the request was rejected with 429.
+   */
+  static bool checkRateLimit(const crow::request &req, crow::response &res) {
+    auto &limits = rz::utils::AuthRateLimiter::instance();
+
+    std::string ip =
+        limits.clientIp(req.remote_ip_address, req.get_header_value("X-Forwarded-For"));
+
+    // IP zuerst: kostet keinerlei Parsing
+    int retryAfter = limits.byIp().acquire(ip);
+
+    // Danach Ziel-E-Mail, damit verteilte Angriffe auf ein Konto gebremst werden
+    if (retryAfter == 0) {
+      auto json = crow::json::load(req.body);
+      if (json && json.has("email") && json["email"].t() == crow::json::type::String) {
+        std::string email = json["email"].s();
+        std::transform(email.begin(), email.end(), email.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        retryAfter = limits.byEmail().acquire(email);
+      }
+    }
+
+    if (retryAfter > 0) {
+      res.code = 429;
+      res.set_header("Retry-After", std::to_string(retryAfter));
+      res.body = "Too many requests. Please retry later.";
+      res.end();
+      return false;
+    }
+    return true;
   }
 
   void after_handle(crow::request &req, crow::response &res, context &ctx) {
-    // no-op
+    std::string method = crow::method_name(req.method);
+    std::string timing =
+        ctx.trace.finish(method, req.url, res.code, ctx.currentUser.userId.toStdString());
+
+    // SSE endet erst mit der Verbindung: zählt als Gauge, nicht als Latenz
+    if (req.url == "/api/events/stream") return;
+    // Nur für Admins: auf /api/login verrät "hash" sonst, ob die E-Mail existiert
+    if (!timing.empty() && ctx.auth && ctx.auth->isAdmin) res.add_header("Server-Timing", timing);
+    rz::utils::HttpMetrics::record(method, req.url, res.code, ctx.started);
   }
 };
 
@@ -0,0 +1,39 @@
+/**
+ * @file compression_middleware.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Compression Middleware
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+#include "utils/response_compressor.hpp"
+
+namespace rz {
+namespace middleware {
+
+/**
+ * @brief Compresses finished responses (see rz::utils::ResponseCompressor).
+ *
+ * Registered first, so its after_handle runs last, also for deferred
+ * (coroutine) responses completed with res.end().
+ */
+struct CompressionMiddleware {
+  struct context {};
+
+  void before_handle(crow::request &req, crow::response &res, context &ctx) {
+    // no-op
+  }
+
+  void after_handle(crow::request &req, crow::response &res, context &ctx) {
+    rz::utils::ResponseCompressor::instance().apply(req, res);
+  }
+};
+
+} // namespace middleware
+} // namespace rz
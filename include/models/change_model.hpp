@@ -0,0 +1,44 @@
+/**
+ * @file change_model.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Shared change sequence for prefork worker processes
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <QString>
+#include <vector>
+
+/**
+ * @brief One row of 'change_log': something every worker process must
+ *        apply locally (cache invalidation, realtime message, wake-up).
+ *
+ * 'seq' is the global order (AUTOINCREMENT: never reused after a purge)
+ * and doubles as SSE event id; 'origin' is the PID of the writing process.
+ */
+struct ChangeEntry {
+  qint64 seq = 0;
+  qint64 origin = 0;
+  int kind = 0;
+  QString topic;
+  QString key;
+  QString payload;
+
+  /**
+   * @brief Insert several entries in one transaction.
+   */
+  static bool appendBatch(const std::vector<ChangeEntry> &entries);
+
+  /**
+   * @brief Entries after 'seq', oldest first (including this process's own).
+   */
+  static std::vector<ChangeEntry> fetchAfter(qint64 seq, int limit);
+
+  static qint64 latestSeq();
+  static int purgeOlderThan(qint64 createdBefore);
+};
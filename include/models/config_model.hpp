@@ -2,8 +2,8 @@
  * @file ConfigModel.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Configuration Model to load env vars
- * @version 0.1.0
- * @date 2026-01-02
+ * @version 0.2.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -73,6 +73,24 @@ public:
    */
   bool getSmtpStartTls() const;
 
+  /**
+   * @brief Number of persistent SMTP connections kept by the pool.
+   * @return int Pool size (default: 2).
+   */
+  int getSmtpPoolSize() const;
+
+  /**
+   * @brief Messages sent over one connection before it is recycled.
+   * @return int Message limit per connection (default: 100).
+   */
+  int getSmtpMaxMessagesPerConnection() const;
+
+  /**
+   * @brief Seconds an unused connection stays open.
+   * @return int Idle timeout in seconds (default: 60).
+   */
+  int getSmtpIdleTimeoutSec() const;
+
   /**
    * @brief Get the Directory path to watch for files.
    * @return QString The absolute or relative path to the watch directory.
@@ -86,6 +104,9 @@ private:
   QString m_smtpPassword;
   QString m_smtpFrom;
   bool m_smtpStartTls = true;
+  int m_smtpPoolSize = 2;
+  int m_smtpMaxMessagesPerConnection = 100;
+  int m_smtpIdleTimeoutSec = 60;
   QString m_watchDir;
 };
 
@@ -0,0 +1,59 @@
+/**
+ * @file digest_model.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Pending notification items collected for digest mails
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <QString>
+#include <vector>
+
+/**
+ * @brief One line of a future digest mail ('digest_items').
+ *
+ * Only the pre-rendered line is stored, not a full mail. Items of one
+ * recipient are flushed together once the earliest 'dueAt' has passed.
+ */
+struct DigestItem {
+  qint64 id = 0;
+  QString recipient;
+  QString language; // de | en
+  QString kind;
+  QString reference;
+  QString line;
+  qint64 dueAt = 0;
+
+  // Digest-Modi (users.notify_digest)
+  static constexpr const char *IMMEDIATE = "immediate";
+  static constexpr const char *HOURLY = "hourly";
+  static constexpr const char *DAILY = "daily";
+
+  static bool isValidMode(const QString &mode);
+
+  /**
+   * @brief End of the current window: next full hour, or the next
+   * 'dailyHour' o'clock (local time) for daily digests.
+   */
+  static qint64 windowEnd(const QString &mode, qint64 now, int dailyHour);
+
+  /**
+   * @brief Insert the item; the same (recipient, kind, reference) is kept once.
+   */
+  bool add();
+
+  // Empfänger, deren ältestes Item fällig ist
+  static std::vector<QString> dueRecipients(qint64 now, int limit);
+
+  static std::vector<DigestItem> getForRecipient(const QString &recipient);
+
+  // Löscht die versendeten Items (id <= maxId)
+  static bool removeUpTo(const QString &recipient, qint64 maxId);
+
+  static int pendingCount();
+};
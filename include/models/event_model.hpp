@@ -2,8 +2,8 @@
  * @file event_model.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Unified Event Model
- * @version 0.3.0
- * @date 2026-01-02
+ * @version 0.8.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,10 +12,14 @@
 
 #pragma once
 #include "crow/json.h"
+#include "services/task_fwd.hpp"
 #include <QString>
+#include <QStringList>
+#include <map>
 #include <vector>
 #include <optional>
 #include <string>
+#include <utility>
 
 struct EventRating {
     double average = 0.0;
@@ -23,6 +27,20 @@ struct EventRating {
     int myRating = 0;
 };
 
+/**
+ * @brief A single attendee photo of an event (one row of 'event_photos').
+ */
+struct EventPhoto {
+    QString eventId;
+    QString userId;
+    QString uploaderName;
+    QString photoPath;
+    QString uploadedAt;
+    qint64 sizeBytes = 0; // Size of the original upload on disk
+
+    crow::json::wvalue toJson() const;
+};
+
 struct Event {
     QString id;
     QString groupId;
@@ -42,18 +60,49 @@ struct Event {
     crow::json::wvalue toJson() const;
 
     // Core Actions
+    // Sind bakerName/groupId/groupName bereits gesetzt (aus dem Auth-Kontext),
+    // entfällt der Lookup von Name und Gruppe.
     bool create(const QString& userId);
 
     // Static Fetchers
     static std::vector<Event> getRange(const QString &start, const QString &end, const QString &userId);
+    // Awaitable: auf dem db-read Pool
+    static rz::service::Task<std::vector<Event>> getRangeAsync(QString start, QString end, QString userId);
     static std::optional<Event> getById(const QString& eventId, const QString& currentUserId);
 
     // Actions
     static bool deleteEvent(const QString& eventId, const QString& currentUserId);
     static bool rateEvent(const QString& eventId, const QString& userId, int stars, const QString& comment);
 
-    // Foto Upload
-    static bool uploadPhoto(const QString& eventId, const QString& userId, const std::string& fileContent, const std::string& ext);
+    // Realtime-Deltas
+    /**
+     * @brief Group id of an event (nullopt if it does not exist).
+     */
+    static std::optional<QString> getGroupId(const QString& eventId);
+
+    /**
+     * @brief Group id and current rating aggregate (average, count) in one query.
+     */
+    static std::optional<std::pair<QString, EventRating>> getGroupRating(const QString& eventId);
+
+    // Foto Upload (liefert den gespeicherten Eintrag ohne uploaderName)
+    static std::optional<EventPhoto> uploadPhoto(const QString& eventId, const QString& userId, const std::string& fileContent, const std::string& ext);
+
+    // Foto Galerie
+    /**
+     * @brief Load all attendee photos of one event visible to the user.
+     * @return std::nullopt if the event does not exist or is in a group the
+     *         user is not a member of.
+     */
+    static std::optional<std::vector<EventPhoto>> getPhotos(const QString& eventId, const QString& currentUserId);
+
+    /**
+     * @brief Load the attendee photos of many events with a single query.
+     *
+     * Only events in groups the user is a member of are returned. Every
+     * requested id gets an entry, even if it has no photos.
+     */
+    static std::map<QString, std::vector<EventPhoto>> getPhotosBatch(const QStringList& eventIds, const QString& currentUserId);
 
     // ICS
     std::string toIcsString() const;
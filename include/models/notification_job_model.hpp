@@ -0,0 +1,47 @@
+/**
+ * @file notification_job_model.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Queued domain events for the asynchronous notification pipeline
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief One domain event ("event created in group X") in 'notification_jobs'.
+ *
+ * Request handlers only insert the job (inside their own transaction);
+ * NotificationWorker resolves recipients and fills the e-mail outbox.
+ */
+struct NotificationJob {
+  QString id; // kind:reference -> doppelte Jobs werden ignoriert
+  QString kind;
+  QJsonObject payload;
+  int attempts = 0;
+
+  static bool enqueue(const QString &kind, const QString &reference,
+                      const QJsonObject &payload);
+
+  /**
+   * @brief Mark up to 'limit' due jobs as 'running' and return them.
+   */
+  static std::vector<NotificationJob> claimBatch(int limit);
+
+  static bool markDone(const QString &id);
+  static bool markFailed(const QString &id, const QString &error,
+                         qint64 nextAttemptAt, bool dead);
+
+  // Nach einem Absturz: 'running' wieder auf 'pending' setzen
+  static int resetInFlight();
+  static int purgeDone(qint64 olderThan);
+
+  static int pendingCount();
+};
@@ -0,0 +1,102 @@
+/**
+ * @file outbox_model.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Durable e-mail outbox
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow/json.h"
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <vector>
+
+/**
+ * @brief One queued e-mail in the 'email_outbox' table.
+ *
+ * Rows are written with the connection of the calling thread, so an
+ * enqueue inside an open transaction commits or rolls back together with
+ * the mutation that triggered it.
+ */
+struct OutboxMessage {
+  // Prioritätsklassen: kleinere Zahl wird zuerst versendet
+  enum Priority { High = 0, Normal = 1, Bulk = 2 };
+  static constexpr int PRIORITY_COUNT = 3;
+
+  QString id; // idempotente Message-ID
+  QString recipient;
+  QString subject;
+  QString body;
+  QString htmlBody; // optionaler HTML-Teil (multipart/alternative)
+  QString status; // pending | sending | sent | dead
+  int priority = Normal; // High: Sicherheit/Registrierung, Bulk: Digests
+  QString fairnessKey;   // z.B. Gruppen-ID; Round-Robin im Scheduler
+  int attempts = 0;
+  qint64 nextAttemptAt = 0;
+  qint64 createdAt = 0;
+  QString lastError;
+
+  crow::json::wvalue toJson() const;
+
+  /**
+   * @brief Deterministic message id: the same notification for the same
+   * recipient is only ever queued once.
+   */
+  static QString makeId(const QString &kind, const QString &reference,
+                        const QString &recipient);
+
+  /**
+   * @brief Insert the message unless a message with the same id exists.
+   */
+  bool enqueue();
+
+  /**
+   * @brief Up to 'limit' due messages, ordered by priority and due time.
+   * Nothing is marked; the SendScheduler picks from these.
+   *
+   * At most 'perKey' messages per priority and fairness key are returned, so
+   * one large fan-out cannot fill the window. Messages to 'excludedDomains'
+   * (currently throttled) are skipped.
+   */
+  static std::vector<OutboxMessage> fetchDue(int limit, int perKey,
+                                             const QStringList &excludedDomains = {});
+
+  /**
+   * @brief Mark the picked messages as 'sending'.
+   */
+  static bool claim(const std::vector<OutboxMessage> &messages);
+
+  static bool markSent(const QString &id);
+
+  /**
+   * @brief Record a failed attempt: reschedule or move to the dead letters.
+   */
+  static bool markFailed(const QString &id, const QString &error,
+                         qint64 nextAttemptAt, bool dead);
+
+  // Nach einem Neustart hängengebliebene 'sending' Einträge erneut einplanen
+  static int resetInFlight();
+
+  // Versendete Einträge nach der Aufbewahrungszeit entfernen
+  static int purgeSent(qint64 olderThan);
+
+  struct Stats {
+    int pending = 0;
+    int sending = 0;
+    int sent = 0;
+    int dead = 0;
+    qint64 oldestPendingAgeSec = 0;
+    std::array<int, PRIORITY_COUNT> pendingByPriority{};
+    std::array<qint64, PRIORITY_COUNT> oldestAgeSecByPriority{};
+  };
+  static Stats stats();
+
+  static std::vector<OutboxMessage> getDead(int limit);
+  static bool requeue(const QString &id);
+};
@@ -0,0 +1,88 @@
+/**
+ * @file session_model.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Server-side login sessions (refresh tokens)
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow/json.h"
+#include <QString>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One login session per device, identified by a rotating refresh token.
+ *
+ * Only the SHA-256 of the refresh token is stored, together with the hash
+ * of the previous token: presenting an already rotated token again means
+ * it was copied, and the session is revoked.
+ */
+struct Session {
+  QString id;
+  QString userId;
+  QString device;
+  QString ipAddress;
+  QString createdAt;
+  QString lastUsedAt;
+  qint64 expiresAt = 0; // Sekunden seit Epoch
+  bool revoked = false;
+
+  // Aus dem JOIN mit 'users' (für neues Access Token beim Refresh)
+  QString userEmail;
+  bool userIsAdmin = false;
+  bool userIsActive = false;
+
+  crow::json::wvalue toJson() const;
+
+  /**
+   * @brief Insert a new session; sets id.
+   */
+  bool create(const QString &refreshHash);
+
+  /**
+   * @brief Indexed lookup by refresh token hash, joined with the owning user.
+   */
+  static std::optional<Session> getByRefreshHash(const QString &refreshHash);
+
+  /**
+   * @brief Session whose previous (already rotated) refresh token has this hash.
+   */
+  static std::optional<Session> getByPreviousRefreshHash(const QString &refreshHash);
+
+  /**
+   * @brief Replace the refresh token hash if it still matches (atomic rotation).
+   * @return false if the old hash was already rotated or the session revoked.
+   */
+  static bool rotate(const QString &sessionId, const QString &oldHash,
+                     const QString &newHash, qint64 newExpiresAt);
+
+  // Aktive (nicht widerrufene, nicht abgelaufene) Sessions eines Users
+  static std::vector<Session> getActiveByUser(const QString &userId);
+
+  static bool revoke(const QString &sessionId, const QString &userId);
+
+  /**
+   * @brief Revoke all sessions of a user, optionally except one (the caller's).
+   * @return Ids of the sessions revoked now.
+   */
+  static std::vector<QString> revokeAllForUser(const QString &userId,
+                                               const QString &exceptSessionId = {});
+
+  /**
+   * @brief Revoked sessions whose access tokens may still be valid, with
+   *        the time they expire (last use + access token TTL).
+   */
+  static std::vector<std::pair<QString, qint64>> getRevoked(qint64 accessTokenTtl);
+
+  /**
+   * @brief Delete expired sessions and revoked ones without valid access tokens.
+   */
+  static int purgeStale(qint64 accessTokenTtl);
+};
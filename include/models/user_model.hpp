@@ -2,8 +2,8 @@
  * @file user_model.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.2.0
- * @date 2026-01-01
+ * @version 0.7.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,6 +12,8 @@
 
 #pragma once
 #include "crow/json.h"
+#include "services/task_fwd.hpp"
+#include "utils/auth_context_cache.hpp"
 #include <QDateTime>
 #include <QString>
 #include <optional>
@@ -30,6 +32,8 @@ struct User {
   bool is_active;
   bool is_admin;
   bool must_change_password = false;
+  bool notifyNewEvents = true; // Mail bei neuem Kuchen in der Gruppe
+  QString notifyDigest = "immediate"; // immediate | hourly | daily
 
   static bool setMustChangePassword(const QString &userId, bool mustChange);
   bool enable2FA(const QString &secret);
@@ -39,15 +43,28 @@ struct User {
   // --- Business / DB Logic ---
   static std::optional<User> getById(const QString &id);
   static std::optional<User> getByEmail(const QString &email);
+  // Awaitable: Lookup auf dem db-read Pool
+  static rz::service::Task<std::optional<User>> getByEmailAsync(QString email);
   // Optionaler Filter
   static std::vector<User> getAll(const QString &filterGroupId = "");
 
   // Liefert {groupId, role} für einen User zurück
   static std::pair<QString, QString> getGroupAndRole(const QString &userId);
 
+  /**
+   * @brief Load flags, display name and all memberships in a single query.
+   *
+   * Used by AuthContextCache; controllers read the cached snapshot instead.
+   */
+  static std::optional<rz::utils::AuthSnapshot> loadAuthSnapshot(const QString &userId);
+
   static bool updateStatus(const QString &userId, bool isActive);
   static bool updatePassword(const QString &userId, const QString &newHash);
+  // Nur den Hash ersetzen (Rehash mit neuen Argon2-Parametern), Flags bleiben
+  static bool updatePasswordHash(const QString &userId, const QString &newHash);
   static bool updateSettings(const QString& userId, const QString& lang);
+  static bool updateNotificationPrefs(const QString& userId, bool notifyNewEvents);
+  static bool updateDigestMode(const QString& userId, const QString& mode);
 
   static std::vector<std::pair<QString, QString>>
   getAllGroups(); // Gibt ID + Name zurück
@@ -0,0 +1,343 @@
+/**
+ * @file async.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Coroutine tasks on top of the executor pools
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Usage in a controller (parameters, not lambda captures, keep state alive
+ * in the coroutine frame):
+ *
+ *   CROW_ROUTE(app, "/api/x")([](const crow::request &req, crow::response &res) {
+ *     respond(req, res, [](QString id) -> Task<crow::response> {
+ *       auto rows = co_await runOn(Executors::Pool::DbRead, [id] { return Model::load(id); });
+ *       co_return crow::response(toJson(rows));
+ *     }(QString("...")));
+ *   });
+ */
+
+#pragma once
+#include "crow.h"
+#include "services/executors.hpp"
+#include "services/hash_executor.hpp"
+
+#include <QDebug>
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Thrown by an awaitable when its pool rejected the job (answer 503).
+ */
+class ExecutorBusy : public std::runtime_error {
+public:
+  explicit ExecutorBusy(int retryAfterSeconds)
+      : std::runtime_error("executor busy"), retryAfter(retryAfterSeconds) {}
+  int retryAfter;
+};
+
+template <typename T> class Task;
+
+namespace detail {
+
+struct PromiseBase {
+  std::coroutine_handle<> continuation = std::noop_coroutine();
+  std::exception_ptr error;
+
+  // Lazy: läuft erst, wenn jemand co_await sagt
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+      return h.promise().continuation; // Symmetric Transfer, kein Stack-Wachstum
+    }
+    void await_resume() noexcept {}
+  };
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { error = std::current_exception(); }
+};
+
+// Selbst-zerstörender Starter für respond() und whenAll()
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine returning T (exceptions propagate to
+ *        the awaiting coroutine).
+ */
+template <typename T> class [[nodiscard]] Task {
+public:
+  struct promise_type : detail::PromiseBase {
+    std::optional<T> value;
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    template <typename U> void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+  };
+
+  Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task() {
+    if (m_handle) m_handle.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().continuation = awaiting;
+    return m_handle;
+  }
+  T await_resume() {
+    auto &promise = m_handle.promise();
+    if (promise.error) std::rethrow_exception(promise.error);
+    return std::move(*promise.value);
+  }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+template <> class [[nodiscard]] Task<void> {
+public:
+  struct promise_type : detail::PromiseBase {
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    void return_void() {}
+  };
+
+  Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task() {
+    if (m_handle) m_handle.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().continuation = awaiting;
+    return m_handle;
+  }
+  void await_resume() {
+    if (m_handle.promise().error) std::rethrow_exception(m_handle.promise().error);
+  }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * @brief Continue the coroutine on a pool thread.
+ * @throws ExecutorBusy if the pool is full.
+ */
+inline auto scheduleOn(Executors::Pool pool) {
+  struct Awaiter {
+    Executor &executor;
+    bool rejected = false;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+      if (executor.post([h]() { h.resume(); })) return true;
+      rejected = true;
+      return false; // sofort weiter, await_resume wirft
+    }
+    void await_resume() const {
+      if (rejected) throw ExecutorBusy(executor.retryAfterSeconds());
+    }
+  };
+  return Awaiter{Executors::instance().get(pool)};
+}
+
+/**
+ * @brief Continue the coroutine on an io thread (inline if there is none).
+ */
+inline auto resumeOn(asio::io_context *io) {
+  struct Awaiter {
+    asio::io_context *io;
+    bool await_ready() const noexcept { return io == nullptr; }
+    void await_suspend(std::coroutine_handle<> h) {
+      asio::post(*io, [h]() { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+  };
+  return Awaiter{io};
+}
+
+/**
+ * @brief Run a blocking function on a pool; the caller continues there.
+ */
+template <typename F>
+Task<std::invoke_result_t<F>> runOn(Executors::Pool pool, F fn) {
+  co_await scheduleOn(pool);
+  co_return fn();
+}
+
+/**
+ * @brief Run a function in an Argon2 slot of the HashExecutor.
+ *
+ * The slot is released as soon as fn returns; the coroutine continues on
+ * the CPU pool, not inside the slot.
+ * @throws ExecutorBusy if the hash queue is full.
+ */
+template <typename F> Task<std::invoke_result_t<F>> runHashed(F fn) {
+  using R = std::invoke_result_t<F>;
+
+  struct Awaiter {
+    F fn;
+    std::optional<R> result;
+    std::exception_ptr error;
+    bool rejected = false;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+      bool posted = HashExecutor::instance().post([this, h]() {
+        try {
+          result.emplace(fn());
+        } catch (...) {
+          error = std::current_exception();
+        }
+        // Fortsetzung außerhalb des Hash-Slots
+        if (!Executors::instance().get(Executors::Pool::Cpu).post([h]() { h.resume(); })) {
+          h.resume();
+        }
+      });
+      if (posted) return true;
+      rejected = true;
+      return false;
+    }
+    R await_resume() {
+      if (rejected) throw ExecutorBusy(HashExecutor::instance().retryAfterSeconds());
+      if (error) std::rethrow_exception(error);
+      return std::move(*result);
+    }
+  };
+
+  co_return co_await Awaiter{std::move(fn)};
+}
+
+namespace detail {
+
+struct WhenAllState {
+  explicit WhenAllState(size_t count) : remaining(count) {}
+  std::atomic<size_t> remaining;
+  std::coroutine_handle<> continuation;
+};
+
+template <typename T>
+Detached runInto(Task<T> task, std::optional<T> &out, std::exception_ptr &error,
+                 std::shared_ptr<WhenAllState> state) {
+  try {
+    out.emplace(co_await task);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) state->continuation.resume();
+}
+
+} // namespace detail
+
+/**
+ * @brief Await several independent tasks in parallel (fan-out).
+ *
+ * All tasks are started at once (each usually hops onto its own pool
+ * thread); the caller resumes when the last one finished. The first
+ * exception is rethrown after all tasks completed.
+ */
+template <typename... T> Task<std::tuple<T...>> whenAll(Task<T>... tasks) {
+  constexpr size_t N = sizeof...(T);
+  std::tuple<Task<T>...> pending(std::move(tasks)...);
+  std::tuple<std::optional<T>...> results;
+  std::array<std::exception_ptr, N> errors;
+
+  struct Awaiter {
+    std::tuple<Task<T>...> &pending;
+    std::tuple<std::optional<T>...> &results;
+    std::array<std::exception_ptr, N> &errors;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+      // +1: der Awaiter selbst, damit kein Task vor dem Start aller anderen fortsetzt
+      auto state = std::make_shared<detail::WhenAllState>(N + 1);
+      state->continuation = h;
+      [&]<size_t... I>(std::index_sequence<I...>) {
+        (detail::runInto(std::move(std::get<I>(pending)), std::get<I>(results), errors[I], state),
+         ...);
+      }(std::index_sequence_for<T...>{});
+      return state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  co_await Awaiter{pending, results, errors};
+
+  for (const auto &error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  co_return std::apply([](auto &...r) { return std::tuple<T...>(std::move(*r)...); }, results);
+}
+
+namespace detail {
+
+inline Detached respondImpl(asio::io_context *io, crow::response &res,
+                            Task<crow::response> handler) {
+  crow::response out;
+  try {
+    out = co_await handler;
+  } catch (const ExecutorBusy &busy) {
+    out = crow::response(503, "Server busy, please retry later");
+    out.set_header("Retry-After", std::to_string(busy.retryAfter));
+  } catch (const std::exception &e) {
+    qWarning() << "[Async] Handler-Fehler:" << e.what();
+    out = crow::response(500);
+  }
+
+  // Antwort immer auf dem io-Thread der Verbindung schreiben
+  co_await resumeOn(io);
+  res = std::move(out);
+  res.end();
+}
+
+} // namespace detail
+
+/**
+ * @brief Run a coroutine handler for a Crow route with crow::response&.
+ *
+ * The Crow worker returns immediately; the response is written on the
+ * request's io thread once the task completes (ExecutorBusy -> 503,
+ * other exceptions -> 500).
+ */
+inline void respond(const crow::request &req, crow::response &res, Task<crow::response> handler) {
+  detail::respondImpl(req.io_context, res, std::move(handler));
+}
+
+} // namespace service
+} // namespace rz
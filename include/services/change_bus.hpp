@@ -0,0 +1,145 @@
+/**
+ * @file change_bus.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Cross-process cache invalidation and realtime fan-out
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+#include "models/change_model.hpp"
+
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Applies process-local side effects of a change in every worker.
+ *
+ * The caller's process applies the change at once (caches, EventHub,
+ * WsHub). In prefork mode the change is also appended to the shared
+ * 'change_log' table; a bus thread in every worker writes its own changes
+ * in batches and replays the changes of the other workers every
+ * CAKE_CHANGE_POLL_MS (default 50 ms). Without start() (single process)
+ * nothing is written.
+ *
+ * SSE messages are the exception: in prefork mode every worker (the
+ * writer included) hands them to the EventHub from the bus thread, in
+ * seq order and with the seq as event id, so a reconnect can resume on
+ * any worker.
+ *
+ * Caches stay correct across workers after at most one poll interval;
+ * rows older than CAKE_CHANGE_RETENTION_SEC are purged by worker 0. A
+ * worker that stalled longer than that sees a gap in the seqs and resyncs:
+ * revocations are reloaded from the sessions table, the auth cache is
+ * cleared, templates are reloaded and SSE/WS clients get a RESYNC.
+ */
+class ChangeBus {
+public:
+  struct Stats {
+    bool shared = false;
+    qint64 lastSeq = 0;
+    uint64_t written = 0;
+    uint64_t applied = 0;
+    uint64_t dropped = 0;
+    uint64_t resyncs = 0;
+    size_t pending = 0;
+  };
+
+  static ChangeBus &instance();
+
+  /**
+   * @brief Start the bus thread (prefork workers only).
+   * @param primary Worker that purges old rows and runs the wake handler.
+   */
+  void start(bool primary);
+  void stop();
+
+  bool shared() const { return m_shared.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Realtime message to SSE and WebSocket subscribers of a topic.
+   */
+  void publish(const std::string &topic, crow::json::wvalue payload, std::string coalesceKey = {});
+
+  /**
+   * @brief Realtime message for WebSocket subscribers only (typing, presence).
+   */
+  void publishWs(const std::string &topic, crow::json::wvalue payload, std::string coalesceKey = {});
+
+  // Auth-Snapshot eines Users verwerfen (Rollen, Gruppen, Aktiv-Status)
+  void invalidateUser(const QString &userId);
+  void revokeSession(const QString &sessionId);
+  void reloadTemplates();
+
+  /**
+   * @brief Ask the worker running the notification pipeline to drain now.
+   */
+  void wakeNotifications();
+
+  /**
+   * @brief Handler for wakeNotifications() in this process (primary worker).
+   */
+  void setWakeHandler(std::function<void()> handler) { m_wakeHandler = std::move(handler); }
+
+  Stats stats() const;
+
+private:
+  ChangeBus() = default;
+  ~ChangeBus();
+  ChangeBus(const ChangeBus &) = delete;
+  ChangeBus &operator=(const ChangeBus &) = delete;
+
+  enum Kind {
+    Realtime = 1,
+    RealtimeWs = 2,
+    InvalidateUser = 3,
+    RevokeSession = 4,
+    ReloadTemplates = 5,
+    WakeNotifications = 6,
+  };
+
+  void apply(const ChangeEntry &entry);
+  void resync(qint64 missedUpTo);
+  void append(int kind, QString topic, QString key, QString payload);
+  void loop();
+
+  std::atomic<bool> m_shared{false};
+  bool m_primary = false;
+  qint64 m_origin = 0;
+  std::function<void()> m_wakeHandler;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::vector<ChangeEntry> m_outgoing;
+  std::thread m_thread;
+  bool m_stopping = false;
+
+  int m_pollMs = 50;
+  int m_retentionSec = 60;
+  size_t m_maxPending = 10000;
+
+  std::atomic<qint64> m_lastSeq{0};
+  std::atomic<uint64_t> m_written{0};
+  std::atomic<uint64_t> m_applied{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<uint64_t> m_resyncs{0};
+};
+
+} // namespace service
+} // namespace rz
@@ -0,0 +1,167 @@
+/**
+ * @file event_hub.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Non-blocking Server-Sent Events hub
+ * @version 0.6.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Holds SSE subscribers as parked responses on their connection's
+ * io_context instead of blocking a worker thread.
+ *
+ * A subscriber collects frames for a short coalescing window, then the
+ * response is completed with all of them. Idle subscribers get a heartbeat
+ * after CAKE_SSE_HEARTBEAT_SEC. The per-client buffer is bounded; a full
+ * buffer is flushed at once. Crow cannot stream a response body, so every
+ * flush ends the response and EventSource reconnects ('retry:').
+ *
+ * Subscribers are indexed by topic ("group:<id>"), so a publish only
+ * touches the subscribers of that topic.
+ *
+ * Every message gets a monotonic id ("id:" line). Each topic keeps the
+ * last CAKE_SSE_REPLAY_SIZE messages; a reconnect with Last-Event-ID gets
+ * the missed ones replayed, or a RESYNC message if they already fell out
+ * of the ring (or the id stems from an earlier process).
+ *
+ * In prefork mode the ChangeBus delivers every message with its
+ * change_log.seq as id, in seq order, so all workers agree on the ids and
+ * any worker can serve the replay. A reconnect whose id is slightly ahead
+ * of this worker (the bus has not polled it yet) skips those frames.
+ *
+ * All state of one subscriber is only touched on its own io_context
+ * thread; the hub mutex only guards the topic index.
+ */
+class EventHub {
+public:
+  struct Stats {
+    size_t subscribers = 0;
+    size_t topics = 0;
+    uint64_t published = 0;
+    uint64_t framesDelivered = 0;
+    uint64_t flushes = 0;
+    uint64_t overflowFlushes = 0;
+    uint64_t heartbeats = 0;
+    uint64_t rejected = 0;
+    uint64_t replayedFrames = 0;
+    uint64_t resyncs = 0;
+    uint64_t lastEventId = 0;
+  };
+
+  static EventHub &instance();
+
+  /**
+   * @brief Read CAKE_SSE_* settings from the environment.
+   */
+  void configureFromEnv();
+
+  static std::string groupTopic(const QString &groupId);
+
+  /**
+   * @brief Park the response of a stream request on the given topics.
+   * @return false if the subscriber limit is reached (caller answers 503).
+   */
+  bool subscribe(const crow::request &req, crow::response &res,
+                 std::vector<std::string> topics);
+
+  /**
+   * @brief Queue a JSON payload for the subscribers of one topic (thread-safe).
+   */
+  void publish(const std::string &topic, const crow::json::wvalue &payload);
+
+  /**
+   * @brief Prefork: take ids from the shared change_log from now on.
+   * @param lastSeq Newest seq at start; older Last-Event-IDs get a RESYNC.
+   */
+  void useSharedIds(uint64_t lastSeq);
+
+  /**
+   * @brief Publish with an explicit id (change_log.seq, ascending).
+   */
+  void publish(const std::string &topic, const crow::json::wvalue &payload, uint64_t id);
+
+  /**
+   * @brief Prefork: ids up to missedUpTo were lost (purged from the
+   *        change_log before this worker read them). Live subscribers get a
+   *        RESYNC now, reconnects from before the gap get one as well.
+   */
+  void resync(uint64_t missedUpTo);
+
+  Stats stats() const;
+
+private:
+  EventHub();
+  EventHub(const EventHub &) = delete;
+  EventHub &operator=(const EventHub &) = delete;
+
+  struct Subscriber;
+  using Frame = std::shared_ptr<const std::string>;
+
+  void publishFrame(const std::string &topic, const std::string &data, uint64_t id);
+  void deliver(const std::shared_ptr<Subscriber> &sub, uint64_t id, const Frame &frame);
+  void complete(const std::shared_ptr<Subscriber> &sub);
+
+  void unregister(const Subscriber &sub);
+
+  // Letzte Nachrichten eines Topics für Last-Event-ID-Replay
+  struct TopicLog {
+    std::deque<std::pair<uint64_t, Frame>> entries;
+    uint64_t evictedUpTo = 0; // höchste bereits verdrängte Id
+  };
+
+  /// Replay-Frames für 'lastId'; false = Lücke, Client muss neu laden (unter m_mutex)
+  bool collectReplay(const std::vector<std::string> &topics, uint64_t lastId,
+                     std::vector<std::pair<uint64_t, Frame>> &out) const;
+
+  using SubscriberMap = std::unordered_map<uint64_t, std::shared_ptr<Subscriber>>;
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, SubscriberMap> m_topics;
+  size_t m_subscriberCount = 0;
+  std::unordered_map<std::string, TopicLog> m_logs;
+  uint64_t m_firstEventId = 0; // erste Id dieses Prozesses
+  uint64_t m_lastEventId = 0;
+  bool m_sharedIds = false; // Prefork: Ids = change_log.seq
+  std::atomic<uint64_t> m_nextId{1};
+
+  std::chrono::seconds m_heartbeat{25};
+  std::chrono::milliseconds m_coalesce{50};
+  size_t m_maxBufferBytes = 64 * 1024;
+  size_t m_maxSubscribers = 10000;
+  int m_retryMs = 1000;
+  size_t m_replaySize = 256;
+
+  std::atomic<uint64_t> m_published{0};
+  std::atomic<uint64_t> m_framesDelivered{0};
+  std::atomic<uint64_t> m_flushes{0};
+  std::atomic<uint64_t> m_overflowFlushes{0};
+  std::atomic<uint64_t> m_heartbeats{0};
+  std::atomic<uint64_t> m_rejected{0};
+  std::atomic<uint64_t> m_replayedFrames{0};
+  std::atomic<uint64_t> m_resyncs{0};
+};
+
+} // namespace service
+} // namespace rz
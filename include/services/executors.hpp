@@ -0,0 +1,233 @@
+/**
+ * @file executors.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Named thread pools for DB, CPU and background work
+ * @version 0.5.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Common interface and statistics of all pools.
+ */
+class Executor {
+public:
+  struct Stats {
+    std::string name;
+    int workers = 0;
+    int capacity = 0;
+    int queued = 0;
+    int active = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;
+    uint64_t stolen = 0; // nur Work-Stealing
+    double avgWaitMs = 0.0;
+    double avgRunMs = 0.0;
+    double maxWaitMs = 0.0;
+    double waitSecondsTotal = 0.0; // Summen seit Start (Prometheus-Counter)
+    double runSecondsTotal = 0.0;
+  };
+
+  explicit Executor(std::string name) : m_name(std::move(name)) {}
+  virtual ~Executor() = default;
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  const std::string &name() const { return m_name; }
+
+  virtual void start(int workers, int queueCapacity) = 0;
+
+  /**
+   * @brief Stop all workers after draining queued jobs.
+   */
+  virtual void stop() = 0;
+
+  /**
+   * @brief Queue a job; false if the queue is full (backpressure).
+   */
+  virtual bool post(std::function<void()> fn) = 0;
+
+  virtual Stats stats() const = 0;
+
+  /**
+   * @brief Submit a job. Returns nullopt if the queue is full.
+   */
+  template <typename T>
+  std::optional<std::future<T>> submit(std::function<T()> job) {
+    auto task = std::make_shared<std::packaged_task<T()>>(std::move(job));
+    std::future<T> future = task->get_future();
+    if (!post([task]() { (*task)(); })) return std::nullopt;
+    return future;
+  }
+
+  /**
+   * @brief Estimated seconds until a new job would be picked up.
+   */
+  int retryAfterSeconds() const;
+
+protected:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    std::function<void()> fn;
+    Clock::time_point enqueuedAt;
+  };
+
+  /// Job ausführen und Warte-/Laufzeit verbuchen
+  void run(Job &job);
+  void fillTimings(Stats &s) const;
+
+  std::string m_name;
+  std::atomic<int> m_active{0};
+  std::atomic<uint64_t> m_completed{0};
+  std::atomic<uint64_t> m_rejected{0};
+  std::atomic<uint64_t> m_waitUsTotal{0};
+  std::atomic<uint64_t> m_runUsTotal{0};
+  std::atomic<uint64_t> m_maxWaitUs{0};
+};
+
+/**
+ * @brief Bounded FIFO pool (one shared queue).
+ *
+ * Used for DB and background work, where fairness matters more than cache
+ * locality. With one worker it serialises its jobs (DB writer).
+ */
+class ThreadPool : public Executor {
+public:
+  using Executor::Executor;
+  ~ThreadPool() override { stop(); }
+
+  void start(int workers, int queueCapacity) override;
+  void stop() override;
+  bool post(std::function<void()> fn) override;
+  Stats stats() const override;
+
+private:
+  void workerLoop();
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<Job> m_queue;
+  std::vector<std::thread> m_threads;
+  size_t m_capacity = 0;
+  bool m_stopping = false;
+};
+
+/**
+ * @brief Work-stealing pool for short CPU-bound jobs.
+ *
+ * Every worker owns a deque: jobs posted from a worker stay on its own
+ * deque (LIFO, warm caches), external jobs are spread round-robin. Idle
+ * workers steal the oldest job of another worker.
+ */
+class WorkStealingPool : public Executor {
+public:
+  using Executor::Executor;
+  ~WorkStealingPool() override { stop(); }
+
+  void start(int workers, int queueCapacity) override;
+  void stop() override;
+  bool post(std::function<void()> fn) override;
+  Stats stats() const override;
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void workerLoop(size_t index);
+  bool popLocal(size_t index, Job &job);
+  bool steal(size_t index, Job &job);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::atomic<size_t> m_nextWorker{0};
+  std::atomic<int> m_queued{0};
+  std::atomic<uint64_t> m_stolen{0};
+  size_t m_capacity = 0;
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_cv;
+  std::atomic<bool> m_stopping{false};
+};
+
+/**
+ * @brief Registry of the named pools.
+ *
+ * HTTP parsing stays on Crow's io threads (CAKE_HTTP_THREADS); everything
+ * that may block or burn CPU is handed to its own pool so one class of
+ * work cannot starve the others:
+ *
+ *  - db-read    SQLite reads (WAL allows parallel readers)
+ *  - db-write   single writer thread, SQLite serialises writes anyway
+ *  - cpu        work-stealing, Argon2 (via HashExecutor) and other crypto
+ *  - background maintenance (purges, rehashes, cache warm-up)
+ *
+ * Sizes come from CAKE_POOL_<NAME>_THREADS / CAKE_POOL_<NAME>_QUEUE
+ * (name upper-case, '-' as '_'). Defaults are derived from the cores
+ * divided by CAKE_WORKERS, so prefork workers do not oversubscribe the
+ * machine.
+ */
+class Executors {
+public:
+  enum class Pool { DbRead, DbWrite, Cpu, Background };
+
+  static Executors &instance();
+
+  /**
+   * @brief Read pool sizes and start all pools (before that, post() rejects).
+   */
+  void start();
+
+  /**
+   * @brief Stop all pools after draining their queues.
+   */
+  void stop();
+
+  Executor &get(Pool pool);
+
+  /**
+   * @brief Worker threads for Crow's io loops (CAKE_HTTP_THREADS).
+   */
+  int httpThreads() const { return m_httpThreads; }
+
+  std::vector<Executor::Stats> stats() const;
+
+private:
+  Executors();
+  ~Executors();
+  Executors(const Executors &) = delete;
+  Executors &operator=(const Executors &) = delete;
+
+  static constexpr size_t POOL_COUNT = 4;
+
+  std::unique_ptr<Executor> m_pools[POOL_COUNT];
+  int m_httpThreads = 0;
+  bool m_started = false;
+};
+
+} // namespace service
+} // namespace rz
@@ -0,0 +1,123 @@
+/**
+ * @file hash_executor.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Bounded executor for Argon2 password hashing
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Admission limit for Argon2 hashing/verification on the CPU pool.
+ *
+ * Has no threads of its own: jobs run on Executors' "cpu" pool, but at
+ * most 'workers' of them at the same time (memory stays at
+ * workers x M_COST). Further jobs wait in a bounded queue; once it is full
+ * work is rejected immediately, so callers can answer with 503 instead of
+ * pinning Crow workers. A slot that finishes a job runs the next queued
+ * one right away on the same pool thread, so an accepted job is never
+ * dropped.
+ */
+class HashExecutor {
+public:
+  struct Stats {
+    int workers = 0;
+    int capacity = 0;
+    int queued = 0;
+    int active = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;
+    double avgWaitMs = 0.0;
+    double avgRunMs = 0.0;
+    double maxWaitMs = 0.0;
+  };
+
+  static HashExecutor &instance();
+
+  /**
+   * @brief Set the limits (the CPU pool must be started separately).
+   * @param workers Number of concurrent hash computations.
+   * @param queueCapacity Number of jobs allowed to wait for a slot.
+   */
+  void start(int workers, int queueCapacity);
+
+  /**
+   * @brief Reject new jobs; running and queued jobs still finish.
+   */
+  void stop();
+
+  /**
+   * @brief Submit a job. Returns nullopt if the queue is full (backpressure).
+   */
+  template <typename T>
+  std::optional<std::future<T>> submit(std::function<T()> job) {
+    auto task = std::make_shared<std::packaged_task<T()>>(std::move(job));
+    std::future<T> future = task->get_future();
+    if (!enqueue([task]() { (*task)(); })) return std::nullopt;
+    return future;
+  }
+
+  /**
+   * @brief Queue a job without a future (coroutines, fire-and-forget).
+   * @return false if the queue is full.
+   */
+  bool post(std::function<void()> fn) { return enqueue(std::move(fn)); }
+
+  Stats stats() const;
+
+  /**
+   * @brief Estimated seconds until a new job would be picked up.
+   */
+  int retryAfterSeconds() const;
+
+private:
+  HashExecutor() = default;
+  HashExecutor(const HashExecutor &) = delete;
+  HashExecutor &operator=(const HashExecutor &) = delete;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    std::function<void()> fn;
+    Clock::time_point enqueuedAt;
+  };
+
+  bool enqueue(std::function<void()> fn);
+  bool launch(Job job);
+  void runSlot(Job job);
+  void runJob(Job &job);
+
+  mutable std::mutex m_mutex;
+  std::deque<Job> m_queue;
+  int m_workers = 0;
+  size_t m_capacity = 0;
+  bool m_stopping = true;
+
+  std::atomic<int> m_active{0};
+  std::atomic<uint64_t> m_completed{0};
+  std::atomic<uint64_t> m_rejected{0};
+  std::atomic<uint64_t> m_waitUsTotal{0};
+  std::atomic<uint64_t> m_runUsTotal{0};
+  std::atomic<uint64_t> m_maxWaitUs{0};
+};
+
+} // namespace service
+} // namespace rz
@@ -1,27 +1,99 @@
+/**
+ * @file notification_service.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Notification Service (writes into the e-mail outbox)
+ * @version 0.6.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
 #pragma once
 
-#include "smtp_service.hpp"
+#include "utils/mail_templates.hpp"
 #include <QString>
 #include <vector>
 
+struct NotificationJob;
+
 namespace rz {
 namespace service {
 
+class NotificationWorker;
+class OutboxDispatcher;
+
+/**
+ * @brief Builds notification mails and queues them in the durable outbox.
+ *
+ * Subjects and bodies come from MailTemplates (per type and language).
+ *
+ * The notify* methods use the DB connection of the calling thread, so they
+ * join a transaction the caller has open. Call dispatch() after the commit.
+ * Group notifications are only queued as a job; NotificationWorker resolves
+ * the recipients later via processJob().
+ *
+ * Recipients with an hourly or daily digest get a digest item instead of a
+ * mail; flushDigests() turns all items of a recipient into one message.
+ */
 class NotificationService {
 public:
-    explicit NotificationService(SmtpService* smtp);
+    explicit NotificationService(OutboxDispatcher* dispatcher);
 
     // Punkt 4: Info an Admins bei neuer Registrierung
-    void notifyAdminsNewUser(const QString& newUserName, const QString& newUserEmail);
+    bool notifyAdminsNewUser(const QString& newUserName, const QString& newUserEmail);
+
+    // Punkt 2b: Info an Gruppe bei neuem Kuchen (nur ein Job, Fan-out im Worker)
+    bool notifyGroupNewEvent(const QString& eventId, const QString& groupId, const QString& groupName, const QString& bakerId, const QString& bakerName, const QString& date);
+
+    /**
+     * @brief Expand a queued job into outbox rows (called by NotificationWorker
+     * inside its transaction).
+     */
+    bool processJob(const NotificationJob& job, QString& error);
+
+    /**
+     * @brief Send one digest mail per recipient whose window has elapsed.
+     * @return Number of digest mails queued.
+     */
+    int flushDigests(int maxRecipients);
 
-    // Punkt 2b (Später): Info an Gruppe bei neuem Kuchen
-    void notifyGroupNewEvent(const QString& groupName, const QString& bakerName, const QString& date, const std::vector<QString>& recipientsDe, const std::vector<QString>& recipientsEn);
+    void setWorker(NotificationWorker* worker) { m_worker = worker; }
+
+    /**
+     * @brief Wake worker and dispatcher once the queued work is committed.
+     */
+    void dispatch();
 
 private:
-    SmtpService* m_smtp;
+    struct Recipient {
+        QString email;
+        QString name;
+        QString language; // de | en
+        QString digest;   // immediate | hourly | daily
+    };
+
+    OutboxDispatcher* m_dispatcher;
+    NotificationWorker* m_worker = nullptr;
+    int m_dailyHour = 7;
+
+    // Aktive Gruppenmitglieder (ohne Bäcker), die neue-Kuchen-Mails abonniert haben
+    bool getGroupRecipients(const QString& groupId, const QString& excludeUserId, std::vector<Recipient>& recipients);
 
     // Hilfsmethode um alle globalen Admins aus der DB zu holen
-    std::vector<QString> getGlobalAdminEmails();
+    std::vector<Recipient> getGlobalAdmins();
+
+    /**
+     * @brief Route one notification: immediate mail or digest line,
+     * depending on the recipient's preference.
+     */
+    bool deliver(const Recipient& to, const QString& kind, const QString& reference,
+                 const QString& fairnessKey, const rz::utils::TemplateVars& vars);
+
+    // Priorität ergibt sich aus der Art (Sicherheit vor Kuchen vor Digest)
+    bool enqueue(const QString& kind, const QString& reference, const QString& to,
+                 const QString& fairnessKey, const rz::utils::RenderedMail& mail);
 };
 
 } // namespace service
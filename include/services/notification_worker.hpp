@@ -0,0 +1,74 @@
+/**
+ * @file notification_worker.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Background fan-out of notification jobs into the e-mail outbox
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QTimer;
+
+namespace rz {
+namespace service {
+
+class NotificationService;
+class OutboxDispatcher;
+
+/**
+ * @brief Processes queued notification jobs on the db-write pool.
+ *
+ * Each job is expanded (recipients, preferences, language) and written to
+ * the outbox in one transaction, so request latency no longer depends on
+ * the size of a group. The timers live on the Qt main thread, the work
+ * does not: a large group must not stall SMTP and the outbox dispatcher.
+ * At most one batch runs at a time. A second timer flushes due digest
+ * mails; the hourly housekeeping purges finished jobs and stale sessions.
+ */
+class NotificationWorker : public QObject {
+    Q_OBJECT
+public:
+    NotificationWorker(NotificationService* service, OutboxDispatcher* outbox,
+                       QObject* parent = nullptr);
+
+    /**
+     * @brief Start polling (CAKE_NOTIFY_POLL_MS) and recover running jobs.
+     */
+    void start();
+
+    /**
+     * @brief Thread-safe: process pending jobs as soon as possible.
+     */
+    void wake();
+
+private slots:
+    void drain();
+    void flushDigests();
+    void housekeeping();
+
+private:
+    // Läuft im db-write-Pool; true, wenn Mails in die Outbox kamen
+    bool processBatch(int& claimed);
+    void batchDone(bool queuedMail, int claimed);
+
+    NotificationService* m_service;
+    OutboxDispatcher* m_outbox;
+    QTimer* m_pollTimer = nullptr;
+    QTimer* m_digestTimer = nullptr;
+    QTimer* m_housekeepingTimer = nullptr;
+    int m_batchSize = 20;
+    int m_maxAttempts = 5;
+    bool m_running = false;      // nur im Qt-Thread
+    bool m_digestRunning = false; // nur im Qt-Thread
+};
+
+} // namespace service
+} // namespace rz
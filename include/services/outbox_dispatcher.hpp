@@ -0,0 +1,67 @@
+/**
+ * @file outbox_dispatcher.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Drains the e-mail outbox with retries and exponential backoff
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QTimer;
+
+namespace rz {
+namespace service {
+
+class SmtpService;
+
+/**
+ * @brief Sends queued outbox rows over SmtpService on the Qt main thread.
+ *
+ * Failed sends are retried with exponential backoff; after the maximum
+ * number of attempts a message is moved to the dead letters ('dead').
+ * SendScheduler decides which due messages may go out now.
+ */
+class OutboxDispatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit OutboxDispatcher(SmtpService* smtp, QObject* parent = nullptr);
+
+    /**
+     * @brief Start polling (CAKE_OUTBOX_POLL_MS) and recover in-flight rows.
+     */
+    void start();
+
+    /**
+     * @brief Thread-safe: drain as soon as possible (after a commit).
+     */
+    void wake();
+
+private slots:
+    void drain();
+    void housekeeping();
+
+private:
+    void onSent(const QString& id, int attempts, bool ok, const QString& error);
+    qint64 backoffSeconds(int attempts) const;
+
+    SmtpService* m_smtp;
+    QTimer* m_pollTimer = nullptr;
+    QTimer* m_throttleTimer = nullptr;
+    QTimer* m_housekeepingTimer = nullptr;
+    int m_batchSize = 50;
+    int m_maxAttempts = 8;
+    int m_backoffBaseSec = 30;
+    int m_backoffMaxSec = 3600;
+    int m_inFlight = 0;
+};
+
+} // namespace service
+} // namespace rz
@@ -0,0 +1,115 @@
+/**
+ * @file send_scheduler.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Provider-aware throttling, priorities and fairness for outbound mail
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "models/outbox_model.hpp"
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Decides which due outbox messages may be handed to SmtpService now.
+ *
+ * A global token bucket caps the overall send rate, per-domain buckets cap
+ * the rate towards a single provider (CAKE_SMTP_DOMAIN_LIMITS overrides
+ * individual domains). Higher priority classes are served first; within a
+ * class, fairness keys (groups) are served round-robin so one large group
+ * cannot starve the others.
+ *
+ * select() is called by the OutboxDispatcher on the Qt main thread; stats()
+ * may be read from any thread.
+ */
+class SendScheduler {
+public:
+    struct Stats {
+        uint64_t scheduled = 0;
+        uint64_t throttledGlobal = 0;
+        uint64_t throttledDomain = 0;
+        std::array<uint64_t, OutboxMessage::PRIORITY_COUNT> sentByPriority{};
+        double avgQueueDelaySec = 0.0; // created_at -> Übergabe an SMTP
+        double maxQueueDelaySec = 0.0;
+        double globalTokens = 0.0;
+        size_t domainBuckets = 0;
+    };
+
+    static SendScheduler &instance();
+
+    /**
+     * @brief Read CAKE_SMTP_RATE_* and CAKE_SMTP_DOMAIN_* from the environment.
+     */
+    void configureFromEnv();
+
+    /**
+     * @brief Pick up to 'max' messages from candidates (sorted by priority,
+     * then due time) and consume their tokens.
+     */
+    std::vector<OutboxMessage> select(const std::vector<OutboxMessage> &candidates, int max);
+
+    /**
+     * @brief Milliseconds until the global bucket has a token again
+     * (0 if one is available now).
+     */
+    int msUntilNextToken();
+
+    /**
+     * @brief Domains whose bucket has no token right now (at most 'max'),
+     * so the dispatcher does not fetch mail that cannot be sent anyway.
+     */
+    QStringList blockedDomains(int max);
+
+    Stats stats();
+
+private:
+    SendScheduler();
+    SendScheduler(const SendScheduler &) = delete;
+    SendScheduler &operator=(const SendScheduler &) = delete;
+
+    struct Bucket {
+        double tokens = 0.0;
+        double perMs = 0.0; // <= 0: unbegrenzt
+        double burst = 1.0;
+        qint64 lastMs = 0;
+
+        void refill(qint64 nowMs);
+        bool available(qint64 nowMs);
+        void take() { tokens -= 1.0; }
+    };
+
+    Bucket makeBucket(double perMinute, double burst) const;
+    Bucket &domainBucket(const QString &domain, qint64 nowMs);
+
+    static QString domainOf(const QString &recipient);
+
+    std::mutex m_mutex;
+    QElapsedTimer m_clock;
+    Bucket m_global;
+    double m_domainPerMinute = 30;
+    double m_domainBurst = 10;
+    std::unordered_map<QString, std::pair<double, double>> m_domainOverrides;
+    std::unordered_map<QString, Bucket> m_domains;
+
+    Stats m_stats;
+    double m_totalDelaySec = 0.0;
+};
+
+} // namespace service
+} // namespace rz
@@ -1,12 +1,30 @@
+/**
+ * @file smtp_service.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief SMTP Service with pooled, persistent connections
+ * @version 0.5.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
 #pragma once
 
 #include "models/config_model.hpp"
+#include <QElapsedTimer>
 #include <QObject>
 #include <QString>
 #include <QMetaType>
+#include <functional>
+#include <memory>
+#include <vector>
 
 // Forward declaration
-namespace SimpleMail { class ServerReply; }
+namespace SimpleMail { class Server; class ServerReply; }
+
+class QTimer;
 
 namespace rz {
 namespace service {
@@ -17,15 +35,54 @@ public:
     explicit SmtpService(const model::ConfigModel& config, QObject* parent = nullptr);
     ~SmtpService();
 
+    /**
+     * @brief Called on the Qt thread once the server accepted or rejected a mail.
+     */
+    using SendCallback = std::function<void(bool ok, const QString& error)>;
+
     // Diese Methode ist THREAD-SAFE und kann aus Crow-Controllern aufgerufen werden
     void sendEmailAsync(const QString& to, const QString& subject, const QString& body);
 
+    /**
+     * @brief Send a mail over the pool and report the result.
+     *
+     * A non-empty htmlBody is sent as multipart/alternative next to the
+     * text part. Must be called on the Qt main thread (e.g. from the
+     * outbox dispatcher).
+     */
+    void sendEmail(const QString& to, const QString& subject, const QString& body,
+                   const QString& htmlBody, SendCallback done);
+
 private slots:
     // Dieser Slot läuft im Main-Thread
     void doSendEmail(const QString& to, const QString& subject, const QString& body);
 
+    // Schließt Verbindungen, die länger als das Idle-Timeout unbenutzt sind
+    void closeIdleConnections();
+
 private:
+    /**
+     * @brief One authenticated SMTP session that is reused for many messages.
+     *
+     * SimpleMail::Server keeps its socket open and sends queued mails
+     * back-to-back, so each slot costs one connect/STARTTLS/AUTH.
+     */
+    struct PooledConnection {
+        SimpleMail::Server* server = nullptr;
+        int sent = 0;          // über diese Verbindung versendete Mails
+        int inFlight = 0;      // noch nicht abgeschlossene Mails
+        bool retiring = false; // Limit erreicht oder Fehler: keine neuen Mails mehr
+        QElapsedTimer lastUsed;
+    };
+
+    PooledConnection& acquireConnection();
+    SimpleMail::Server* createServer();
+    void releaseConnection(SimpleMail::Server* server, bool failed);
+    void destroyConnection(PooledConnection& conn);
+
     model::ConfigModel m_config;
+    std::vector<PooledConnection> m_pool;
+    QTimer* m_idleTimer = nullptr;
 };
 
 } // namespace service
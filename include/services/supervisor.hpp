@@ -0,0 +1,57 @@
+/**
+ * @file supervisor.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Prefork supervisor for multi-process worker mode
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Starts CAKE_WORKERS worker processes and keeps them running.
+ *
+ * Every worker is a fresh instance of this program (fork + execv of
+ * /proc/self/exe, or argv[0]) with CAKE_WORKER_INDEX set; it sets up Qt,
+ * its threads and database connections itself. Nothing of the supervisor
+ * (QCoreApplication, SQLite handles, threads) crosses into a worker.
+ * Call it after the migrations, with no database connection open and no
+ * thread started.
+ *
+ * The supervisor itself only waits for its children: a worker that exits
+ * or crashes is restarted in the same slot (with a growing delay if it
+ * keeps crashing). SIGTERM/SIGINT are forwarded to all workers; after
+ * CAKE_WORKER_STOP_TIMEOUT_SEC remaining workers are killed.
+ *
+ * Only one supervisor may serve a port: it holds an exclusive lock on
+ * <tmp>/cakeplanner-<port>.lock (inherited by the workers) and refuses to
+ * start if another instance holds it.
+ *
+ * Workers get CAKE_WORKER_INDEX in their environment and die with the
+ * supervisor (PR_SET_PDEATHSIG on Linux).
+ */
+class Supervisor {
+public:
+  /**
+   * @brief Start the workers and supervise them until SIGTERM/SIGINT.
+   * @param argv Command line of this process, passed on to every worker.
+   * @return Exit code for the supervisor process.
+   */
+  static int run(int workers, char *argv[]);
+
+  /**
+   * @brief Index of this worker process (from CAKE_WORKER_INDEX), -1 in
+   *        single-process mode and in the supervisor.
+   */
+  static int workerIndex();
+};
+
+} // namespace service
+} // namespace rz
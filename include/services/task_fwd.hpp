@@ -0,0 +1,23 @@
+/**
+ * @file task_fwd.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Forward declaration of the coroutine Task
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+namespace rz {
+namespace service {
+
+// Für Deklarationen in Model- und Utils-Headern; wer awaited oder
+// implementiert, bindet services/async.hpp ein (Crow, asio, Executors)
+template <typename T> class Task;
+
+} // namespace service
+} // namespace rz
@@ -0,0 +1,198 @@
+/**
+ * @file ws_hub.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief WebSocket realtime channel (/api/ws)
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+#include "utils/auth_context_cache.hpp"
+#include "utils/spsc_ring.hpp"
+#include "utils/token_utils.hpp"
+
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+/**
+ * @brief Bidirectional realtime channel next to the SSE stream.
+ *
+ * Connections authenticate during the handshake (token query parameter or
+ * Authorization header, same checks as AuthMiddleware) and are subscribed
+ * to the topics of their groups ("group:<id>", see EventHub::groupTopic).
+ *
+ * publish() only hands the message to a single broadcaster thread. It
+ * serialises every message once and pushes the shared bytes into a bounded
+ * lock-free ring per connection (broadcaster = only producer, connection
+ * io thread = only consumer). When draining, queued frames with the same
+ * coalescing key collapse to the newest one; an overflowing ring is
+ * dropped and the client gets a RESYNC message.
+ *
+ * Client messages: PING, TYPING {groupId, eventId}; an optional "ref" is
+ * answered with ACK. Presence is published when a user's first connection
+ * opens and the last one closes.
+ *
+ * Connections are indexed by session and user. A revoked session closes
+ * its connections; a changed user is re-checked (inactive or different
+ * groups: closed, the client reconnects with fresh topics). Every
+ * connection is closed when its token expires. The ChangeBus triggers
+ * this in every worker.
+ */
+class WsHub {
+public:
+  struct Stats {
+    size_t connections = 0;
+    size_t topics = 0;
+    size_t inbox = 0;
+    uint64_t published = 0;
+    uint64_t framesQueued = 0;
+    uint64_t framesSent = 0;
+    uint64_t coalesced = 0;
+    uint64_t overflows = 0;
+    uint64_t rejected = 0;
+    uint64_t clientMessages = 0;
+  };
+
+  static WsHub &instance();
+
+  /**
+   * @brief Read CAKE_WS_* settings (queue size, limits).
+   */
+  void configureFromEnv();
+
+  /**
+   * @brief Start the broadcaster thread.
+   */
+  void start();
+
+  /**
+   * @brief Stop the broadcaster thread after draining the inbox.
+   */
+  void stop();
+
+  size_t maxMessageBytes() const { return m_maxMessageBytes; }
+
+  // Crow-Callbacks der Route /api/ws
+  bool accept(const crow::request &req, void **userdata);
+  void open(crow::websocket::connection &conn);
+  void close(crow::websocket::connection &conn);
+  void message(crow::websocket::connection &conn, const std::string &data, bool isBinary);
+
+  /**
+   * @brief Queue a message for all connections of a topic (thread-safe).
+   * @param coalesceKey Queued messages with the same key are replaced by
+   *        the newest one (empty = never coalesced).
+   */
+  void publish(const std::string &topic, crow::json::wvalue payload,
+               std::string coalesceKey = {});
+
+  /**
+   * @brief Close all connections of a revoked session (thread-safe).
+   */
+  void revokeSession(const QString &sessionId);
+
+  /**
+   * @brief Re-check the connections of a user against a fresh snapshot
+   *        (on the DB read pool) and close the ones no longer valid.
+   */
+  void invalidateUser(const QString &userId);
+
+  /**
+   * @brief Messages and auth changes were missed (change_log gap): close
+   *        connections of revoked sessions, re-check every user and send
+   *        RESYNC to the remaining connections.
+   */
+  void resync();
+
+  Stats stats() const;
+
+private:
+  WsHub() = default;
+  ~WsHub();
+  WsHub(const WsHub &) = delete;
+  WsHub &operator=(const WsHub &) = delete;
+
+  struct Frame {
+    std::shared_ptr<const std::string> bytes;
+    std::string key;
+  };
+
+  struct Connection {
+    Connection(size_t capacity, asio::io_context &ctx) : io(&ctx), queue(capacity), expiry(ctx) {}
+
+    crow::websocket::connection *conn = nullptr; // nur im io-Thread
+    asio::io_context *io = nullptr;
+    rz::utils::TokenPayload user;
+    std::shared_ptr<const rz::utils::AuthSnapshot> auth; // nur im io-Thread ersetzt
+    std::vector<std::string> topics;
+    rz::utils::SpscRing<Frame> queue;
+    asio::steady_timer expiry; // schließt bei Token-Ablauf
+    std::atomic<bool> drainScheduled{false};
+    std::atomic<bool> overflowed{false};
+    bool closed = false; // nur im io-Thread
+  };
+
+  using ConnectionMap = std::unordered_map<const Connection *, std::shared_ptr<Connection>>;
+
+  struct Outgoing {
+    std::string topic;
+    crow::json::wvalue payload;
+    std::string key;
+  };
+
+  void broadcasterLoop();
+  void enqueue(const std::shared_ptr<Connection> &c, const Frame &frame);
+  void drain(const std::shared_ptr<Connection> &c);
+  void publishPresence(const Connection &c, bool online);
+  void kick(const std::shared_ptr<Connection> &c, const std::string &reason);
+  std::vector<std::shared_ptr<Connection>> connectionsOf(
+      const std::unordered_map<QString, ConnectionMap> &index, const QString &key) const;
+
+  // Verbindungs-Index (Topic/Session/User -> Verbindungen)
+  mutable std::mutex m_mutex;
+  ConnectionMap m_connections;
+  std::unordered_map<std::string, ConnectionMap> m_topics;
+  std::unordered_map<QString, ConnectionMap> m_sessions;
+  std::unordered_map<QString, ConnectionMap> m_users;
+
+  // Inbox des Broadcaster-Threads
+  mutable std::mutex m_inboxMutex;
+  std::condition_variable m_inboxCv;
+  std::deque<Outgoing> m_inbox;
+  std::thread m_thread;
+  bool m_stopping = false;
+
+  size_t m_queueCapacity = 256;
+  size_t m_maxConnections = 10000;
+  size_t m_maxInbox = 10000;
+  size_t m_maxMessageBytes = 4096;
+
+  std::atomic<uint64_t> m_published{0};
+  std::atomic<uint64_t> m_framesQueued{0};
+  std::atomic<uint64_t> m_framesSent{0};
+  std::atomic<uint64_t> m_coalesced{0};
+  std::atomic<uint64_t> m_overflows{0};
+  std::atomic<uint64_t> m_rejected{0};
+  std::atomic<uint64_t> m_clientMessages{0};
+};
+
+} // namespace service
+} // namespace rz
@@ -0,0 +1,120 @@
+/**
+ * @file auth_context_cache.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Cached per-user authorization snapshot
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+struct GroupMembership {
+  QString groupId;
+  QString groupName;
+  QString role; // 'member' oder 'admin'
+};
+
+/**
+ * @brief Everything the controllers need to authorize a request.
+ *
+ * Resolved once per user by AuthMiddleware and shared immutably between
+ * requests until invalidated by a change to the user or its memberships.
+ */
+struct AuthSnapshot {
+  QString userId;
+  QString displayName;
+  bool isActive = false;
+  bool isAdmin = false;
+  std::vector<GroupMembership> groups;
+  qint64 loadedAt = 0;
+
+  // Erste Gruppe (aktuell hat jeder User höchstens eine)
+  const GroupMembership *primaryGroup() const {
+    return groups.empty() ? nullptr : &groups.front();
+  }
+
+  bool isMemberOf(const QString &groupId) const {
+    for (const auto &g : groups) {
+      if (g.groupId == groupId) return true;
+    }
+    return false;
+  }
+
+  // Gruppen, in denen der User Gruppen-Admin ist
+  std::vector<QString> adminGroupIds() const {
+    std::vector<QString> ids;
+    for (const auto &g : groups) {
+      if (g.role == "admin") ids.push_back(g.groupId);
+    }
+    return ids;
+  }
+};
+
+/**
+ * @brief Concurrent cache userId -> AuthSnapshot with targeted invalidation.
+ *
+ * Entries additionally expire after a TTL (CAKE_AUTH_CACHE_TTL_SEC) as a
+ * safety net for changes made outside the model layer.
+ */
+class AuthContextCache {
+public:
+  static AuthContextCache &instance();
+
+  void setTtl(int seconds);
+
+  /**
+   * @brief Cached snapshot, loaded from the DB on miss. nullptr if unknown user.
+   */
+  std::shared_ptr<const AuthSnapshot> get(const QString &userId);
+
+  /**
+   * @brief Drop the snapshot of a user; the next request reloads it.
+   */
+  void invalidate(const QString &userId);
+
+  /**
+   * @brief Drop all snapshots (missed invalidations, see ChangeBus).
+   */
+  void clear();
+
+  uint64_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+  AuthContextCache() = default;
+  AuthContextCache(const AuthContextCache &) = delete;
+  AuthContextCache &operator=(const AuthContextCache &) = delete;
+
+  static constexpr size_t SHARD_COUNT = 16;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<QString, std::shared_ptr<const AuthSnapshot>> entries;
+    uint64_t generation = 0; // verhindert, dass veraltete Loads nach invalidate() landen
+  };
+
+  Shard &shardFor(const QString &userId);
+
+  std::array<Shard, SHARD_COUNT> m_shards;
+  std::atomic<int> m_ttlSeconds{300};
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+};
+
+} // namespace utils
+} // namespace rz
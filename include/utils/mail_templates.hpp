@@ -0,0 +1,112 @@
+/**
+ * @file mail_templates.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Precompiled, multilingual e-mail templates
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+using TemplateVars = QHash<QString, QString>;
+
+struct RenderedMail {
+  QString subject;
+  QString text;
+  QString html; // leer = nur Text-Mail
+};
+
+/**
+ * @brief Loads mail templates per type and language once and renders them
+ * from a compiled token stream.
+ *
+ * Syntax: {{name}} inserts a variable (HTML-escaped in the html part),
+ * {{{name}}} inserts it unescaped. Built-in 'de' and 'en' templates are
+ * always available; files in CAKE_TEMPLATE_DIR override or add languages:
+ *
+ *   <dir>/<type>/<lang>.subject | .txt | .html | .line
+ *
+ * Lookup falls back from "de-AT" to "de", then to the default language
+ * and "en". Parts a language does not provide (e.g. only a .subject
+ * override) are filled from the same chain at load time, so set the
+ * default language before load().
+ */
+class MailTemplates {
+public:
+  enum Part { Subject = 0, Text, Html, Line, PartCount };
+
+  static MailTemplates &instance();
+
+  /**
+   * @brief Compile built-ins plus all files below 'dir' and swap them in.
+   * @return Number of compiled (type, language) templates.
+   */
+  int load(const QString &dir);
+
+  // Gleiches Verzeichnis erneut laden (Admin-Endpoint)
+  int reload();
+
+  void setDefaultLanguage(const QString &lang);
+
+  /**
+   * @brief Render subject, text and (if present) html part.
+   */
+  RenderedMail render(const QString &type, const QString &lang,
+                      const TemplateVars &vars) const;
+
+  // Einzelner Teil, z.B. die Digest-Zeile (Part::Line)
+  QString renderPart(const QString &type, const QString &lang, Part part,
+                     const TemplateVars &vars) const;
+
+  QStringList languages() const;
+
+  static QString escapeHtml(const QString &value);
+
+private:
+  MailTemplates();
+
+  struct Token {
+    enum Kind { Literal, Var, RawVar } kind;
+    QString text; // Literal-Text oder Variablenname
+  };
+  using Compiled = std::vector<Token>;
+
+  struct Template {
+    Compiled parts[PartCount];
+    bool has[PartCount] = {false, false, false, false};
+  };
+
+  // Schlüssel: "<type>/<lang>"
+  using Catalog = std::unordered_map<QString, Template>;
+
+  static Compiled compile(const QString &source);
+  static QString renderCompiled(const Compiled &tokens, const TemplateVars &vars,
+                                bool escape);
+
+  const Template *find(const Catalog &catalog, const QString &type,
+                       const QString &lang) const;
+  std::shared_ptr<const Catalog> catalog() const;
+
+  mutable std::mutex m_mutex;
+  std::shared_ptr<const Catalog> m_catalog;
+  QString m_dir;
+  QString m_defaultLang = "en";
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,225 @@
+/**
+ * @file metrics.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Lock-free metrics registry with Prometheus text exposition
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+namespace metrics {
+
+// Anzahl Shards pro Metrik; Threads werden reihum verteilt
+inline constexpr size_t SHARD_COUNT = 16;
+inline constexpr size_t MAX_BUCKETS = 16;
+
+/**
+ * @brief Shard of the calling thread (assigned once per thread).
+ */
+inline size_t shardIndex() {
+  static std::atomic<size_t> next{0};
+  thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+  return index;
+}
+
+} // namespace metrics
+
+/**
+ * @brief Monotonic counter. inc() is one relaxed add on a per-thread shard.
+ */
+class Counter {
+public:
+  void inc(uint64_t n = 1) {
+    m_shards[metrics::shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  uint64_t value() const;
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value{0};
+  };
+  std::array<Shard, metrics::SHARD_COUNT> m_shards;
+};
+
+/**
+ * @brief Value that goes up and down (open connections, queue depth).
+ */
+class Gauge {
+public:
+  void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  void add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+  int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+  alignas(64) std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * @brief Duration histogram with fixed upper bounds (seconds).
+ *
+ * observe() is a short linear bucket search plus two relaxed adds on the
+ * calling thread's shard; shards are summed on scrape.
+ */
+class Histogram {
+public:
+  explicit Histogram(std::vector<double> bounds);
+
+  void observe(std::chrono::nanoseconds duration) {
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+    size_t bucket = 0;
+    while (bucket < m_boundsNs.size() && ns > m_boundsNs[bucket]) ++bucket;
+    auto &shard = m_shards[metrics::shardIndex()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sumNs.fetch_add(ns, std::memory_order_relaxed);
+  }
+
+  template <typename Clock> void observeSince(typename Clock::time_point started) {
+    observe(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started));
+  }
+
+  struct Snapshot {
+    std::vector<uint64_t> counts; // nicht kumuliert, letzte = +Inf
+    uint64_t count = 0;
+    double sumSeconds = 0.0;
+  };
+  Snapshot snapshot() const;
+  const std::vector<double> &bounds() const { return m_bounds; }
+
+  // 100 µs bis 10 s
+  static std::vector<double> latencyBuckets();
+
+private:
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, metrics::MAX_BUCKETS + 1> counts{};
+    std::atomic<uint64_t> sumNs{0};
+  };
+  std::vector<double> m_bounds;
+  std::vector<uint64_t> m_boundsNs;
+  std::array<Shard, metrics::SHARD_COUNT> m_shards;
+};
+
+/**
+ * @brief Writes samples of scrape-time collectors (existing stats()).
+ */
+class MetricsWriter {
+public:
+  void counter(const std::string &name, const std::string &help, double value,
+               const MetricLabels &labels = {});
+  void gauge(const std::string &name, const std::string &help, double value,
+             const MetricLabels &labels = {});
+
+private:
+  friend class MetricsRegistry;
+  MetricsWriter(std::string &out, const std::string &constLabels)
+      : m_out(out), m_constLabels(constLabels) {}
+  void sample(const std::string &name, const std::string &help, const char *type, double value,
+              const MetricLabels &labels);
+
+  std::string &m_out;
+  const std::string &m_constLabels;
+  std::set<std::string> m_described;
+};
+
+/**
+ * @brief Process-wide registry, rendered as Prometheus text format 0.0.4.
+ *
+ * Registration takes a mutex and returns a reference that stays valid for
+ * the lifetime of the process; hot paths keep it (function-local static or
+ * member) so recording never touches the registry. Values are per process:
+ * in prefork mode every sample carries a worker="<n>" label.
+ */
+class MetricsRegistry {
+public:
+  static MetricsRegistry &instance();
+
+  Counter &counter(const std::string &name, const std::string &help,
+                   const MetricLabels &labels = {});
+  Gauge &gauge(const std::string &name, const std::string &help,
+               const MetricLabels &labels = {});
+  Histogram &histogram(const std::string &name, const std::string &help,
+                       const MetricLabels &labels = {},
+                       std::vector<double> bounds = Histogram::latencyBuckets());
+
+  /**
+   * @brief Label added to every sample (e.g. worker index).
+   */
+  void setConstLabel(const std::string &name, const std::string &value);
+
+  /**
+   * @brief Callback run on every scrape to export existing statistics.
+   */
+  void addCollector(std::function<void(MetricsWriter &)> collector);
+
+  std::string render() const;
+
+  static std::string formatLabels(const MetricLabels &labels);
+
+private:
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  enum class Type { Counter, Gauge, Histogram };
+
+  struct Family {
+    std::string help;
+    Type type = Type::Counter;
+    // Label-String ("{a=\"b\"}") -> Metrik
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+  };
+
+  Family &family(const std::string &name, const std::string &help, Type type);
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Family> m_families;
+  std::vector<std::function<void(MetricsWriter &)>> m_collectors;
+  std::string m_constLabels; // ohne Klammern: worker="1"
+};
+
+/**
+ * @brief Built-in HTTP instrumentation (called by AuthMiddleware).
+ *
+ * Crow does not hand the matched rule to middlewares, so the route label is
+ * derived from the URL: id segments (containing digits, 8+ characters, or
+ * numeric) become "<string>" as in the CROW_ROUTE templates. At most
+ * MAX_ROUTES labels are created; unknown 404 paths count as "unmatched".
+ */
+class HttpMetrics {
+public:
+  static void record(const std::string &method, const std::string &url, int status,
+                     std::chrono::steady_clock::time_point started);
+  static std::string routeTemplate(std::string_view url);
+
+private:
+  static constexpr size_t MAX_ROUTES = 128;
+};
+
+} // namespace utils
+} // namespace rz
@@ -2,8 +2,8 @@
  * @file password_utils.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.6.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -11,16 +11,30 @@
  */
 
 #pragma once
+#include "services/task_fwd.hpp"
 #include <QString>
+#include <cstdint>
+#include <optional>
 #include <string>
 
 namespace rz {
 namespace utils {
 
+/**
+ * @brief Argon2id cost parameters.
+ */
+struct Argon2Params {
+  uint32_t timeCost = 3;        // Iterationen
+  uint32_t memoryCostKiB = 65536; // 64 MiB
+  uint32_t parallelism = 4;     // Lanes
+
+  bool operator==(const Argon2Params &other) const = default;
+};
+
 class PasswordUtils {
 public:
   /**
-   * Erstellt einen Argon2id Hash.
+   * Erstellt einen Argon2id Hash mit den aktuell konfigurierten Parametern.
    * Rückgabeformat: $argon2id$v=19$m=65536,t=3,p=4$...salt...$hash...
    */
   static QString hashPassword(const QString &plainText);
@@ -30,6 +44,64 @@ public:
    */
   static bool verifyPassword(const QString &plainText,
                              const QString &encodedHash);
+
+  /**
+   * @brief Awaitable variants running in an Argon2 slot of the HashExecutor.
+   * @throws rz::service::ExecutorBusy if the hash queue is full.
+   */
+  static rz::service::Task<QString> hashPasswordAsync(QString plainText);
+  static rz::service::Task<bool> verifyPasswordAsync(QString plainText, QString encodedHash);
+
+  /**
+   * @brief Parameters used for new hashes.
+   */
+  static Argon2Params currentParams();
+
+  /**
+   * @brief Replace the parameters used for new hashes.
+   */
+  static void setParams(const Argon2Params &params);
+
+  /**
+   * @brief Apply CAKE_ARGON2_* settings from the environment.
+   *
+   * Either explicit parameters (CAKE_ARGON2_T, CAKE_ARGON2_M_KIB,
+   * CAKE_ARGON2_P) or, with CAKE_ARGON2_CALIBRATE=true, a calibration run
+   * against CAKE_ARGON2_TARGET_MS and CAKE_ARGON2_MAX_MEMORY_KIB.
+   * Prefork workers use the parameters handed down by exportToWorkers()
+   * instead, so calibration runs once in the supervisor.
+   */
+  static void configureFromEnv();
+
+  /**
+   * @brief Hand the active parameters to processes started from here
+   *        (inherited across exec).
+   */
+  static void exportToWorkers();
+
+  /**
+   * @brief Benchmark Argon2id on this host and pick parameters.
+   *
+   * Uses as much memory as the budget allows and the highest time cost whose
+   * verification stays within the target latency. Memory is reduced (down
+   * to the OWASP minimum of 19 MiB) if even t=1 is too slow.
+   *
+   * @param targetMs Target latency for a single verification.
+   * @param maxMemoryKiB Memory budget per hash in KiB.
+   * @param parallelism Number of lanes.
+   */
+  static Argon2Params calibrate(uint32_t targetMs, uint32_t maxMemoryKiB,
+                                uint32_t parallelism);
+
+  /**
+   * @brief Read the parameters embedded in an encoded Argon2 hash.
+   */
+  static std::optional<Argon2Params> parseParams(const QString &encodedHash);
+
+  /**
+   * @brief True if the hash was created with other than the current parameters.
+   */
+  static bool needsRehash(const QString &encodedHash);
 };
 
 } // namespace utils
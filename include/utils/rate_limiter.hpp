@@ -0,0 +1,113 @@
+/**
+ * @file rate_limiter.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Sharded token bucket rate limiter
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Token buckets keyed by an arbitrary string (IP, e-mail, ...).
+ *
+ * Buckets are spread over shards with a short critical section each. Idle
+ * buckets that have refilled completely carry no state and are evicted.
+ */
+class RateLimiter {
+public:
+  struct Stats {
+    uint64_t allowed = 0;
+    uint64_t limited = 0;
+    uint64_t evicted = 0;
+    size_t buckets = 0;
+  };
+
+  /**
+   * @brief Set refill rate and bucket size. A rate <= 0 disables the limiter.
+   */
+  void configure(double perMinute, double burst);
+
+  /**
+   * @brief Take one token for the key.
+   * @return 0 if allowed, otherwise the seconds until a token is available.
+   */
+  int acquire(const std::string &key);
+
+  Stats stats() const;
+
+private:
+  static constexpr size_t SHARD_COUNT = 32;
+  static constexpr uint32_t SWEEP_INTERVAL = 1024; // Zugriffe pro Shard zwischen Sweeps
+
+  struct Bucket {
+    double tokens = 0.0;
+    int64_t lastRefillNs = 0;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Bucket> buckets;
+    uint32_t opsSinceSweep = 0;
+  };
+
+  void sweep(Shard &shard, int64_t nowNs, double ratePerNs, double burst);
+
+  std::array<Shard, SHARD_COUNT> m_shards;
+  std::atomic<double> m_ratePerSecond{0.0};
+  std::atomic<double> m_burst{1.0};
+  std::atomic<uint64_t> m_allowed{0};
+  std::atomic<uint64_t> m_limited{0};
+  std::atomic<uint64_t> m_evicted{0};
+};
+
+/**
+ * @brief The limiters in front of the unauthenticated credential endpoints.
+ */
+class AuthRateLimiter {
+public:
+  static AuthRateLimiter &instance();
+
+  /**
+   * @brief Read CAKE_RATE_* limits and CAKE_TRUST_PROXY from the environment.
+   */
+  void configureFromEnv();
+
+  RateLimiter &byIp() { return m_byIp; }
+  RateLimiter &byEmail() { return m_byEmail; }
+
+  /**
+   * @brief Client address for the per-IP bucket.
+   *
+   * CAKE_TRUST_PROXY is the number of trusted reverse proxies in front of
+   * the server (0 / "false": ignore X-Forwarded-For, "true" = 1). Each
+   * proxy appends the address it saw, so the client is the entry that many
+   * hops from the right; anything further left is client-controlled.
+   */
+  std::string clientIp(const std::string &remoteIp, const std::string &forwarded) const;
+
+private:
+  AuthRateLimiter() = default;
+  AuthRateLimiter(const AuthRateLimiter &) = delete;
+  AuthRateLimiter &operator=(const AuthRateLimiter &) = delete;
+
+  RateLimiter m_byIp;
+  RateLimiter m_byEmail;
+  std::atomic<int> m_trustedHops{0};
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,165 @@
+/**
+ * @file request_trace.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Per-request phase timing, Server-Timing header and trace sampling
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Phase timings of one request (lives in the AuthMiddleware context).
+ *
+ * Started in before_handle and finished in after_handle. TraceScope adds
+ * phases to the trace of the current thread; coroutine handlers that hop
+ * to a pool pass the trace explicitly (TraceScope(trace, "db")). Phases
+ * with the same name add up. Nothing is allocated while recording.
+ */
+class RequestTrace {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr size_t MAX_PHASES = 12;
+
+  struct Phase {
+    const char *name = nullptr; // String-Literal
+    int64_t ns = 0;
+  };
+
+  /**
+   * @brief Start timing if Server-Timing or sampling is enabled and make
+   *        this the trace of the calling thread.
+   */
+  void begin();
+
+  /**
+   * @brief Stop timing; set Server-Timing and hand sampled or slow traces
+   *        to the TraceBuffer.
+   * @return Server-Timing header value (empty if disabled).
+   */
+  std::string finish(const std::string &method, const std::string &url, int status,
+                     const std::string &userId);
+
+  bool active() const { return m_active; }
+  void add(const char *name, std::chrono::nanoseconds duration);
+
+  static RequestTrace *current();
+
+private:
+  std::array<Phase, MAX_PHASES> m_phases{};
+  size_t m_count = 0;
+  Clock::time_point m_started;
+  bool m_active = false;
+  bool m_sampled = false;
+};
+
+/**
+ * @brief RAII timer for one phase ("auth", "db", "json", ...).
+ *
+ * Without an active trace it costs one thread-local load.
+ */
+class TraceScope {
+public:
+  explicit TraceScope(const char *name) : TraceScope(RequestTrace::current(), name) {}
+  TraceScope(RequestTrace *trace, const char *name)
+      : m_trace(trace && trace->active() ? trace : nullptr), m_name(name) {
+    if (m_trace) m_started = RequestTrace::Clock::now();
+  }
+  ~TraceScope() {
+    if (m_trace) m_trace->add(m_name, RequestTrace::Clock::now() - m_started);
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  RequestTrace *m_trace;
+  const char *m_name;
+  RequestTrace::Clock::time_point m_started;
+};
+
+/**
+ * @brief Ring buffer of sampled request traces (GET /api/admin/traces).
+ *
+ * CAKE_SERVER_TIMING (default 0) adds the Server-Timing header, and only
+ * to requests of authenticated admins: phase timings of public routes
+ * would leak internals (e.g. whether a login reached the password hash).
+ * CAKE_TRACE_SAMPLE_RATE (0.0 - 1.0, default 0) keeps that fraction of
+ * requests, CAKE_TRACE_SLOW_MS (default 0 = off) additionally keeps every
+ * slower request. CAKE_TRACE_BUFFER traces are kept (default 256).
+ */
+class TraceBuffer {
+public:
+  struct Record {
+    uint64_t id = 0;
+    int64_t startedAtMs = 0; // Unix-Zeit
+    std::string method;
+    std::string path; // ohne Query (Tokens!)
+    std::string userId;
+    int status = 0;
+    int64_t totalUs = 0;
+    bool slow = false;
+    std::vector<std::pair<std::string, int64_t>> phasesUs;
+  };
+
+  struct Stats {
+    double sampleRate = 0.0;
+    int slowMs = 0;
+    bool serverTiming = false;
+    size_t capacity = 0;
+    size_t stored = 0;
+    uint64_t recorded = 0;
+  };
+
+  static TraceBuffer &instance();
+  void configureFromEnv();
+
+  bool serverTiming() const { return m_serverTiming; }
+  // Trace überhaupt messen?
+  bool enabled() const { return m_serverTiming || m_sampleRate > 0.0 || m_slowNs > 0; }
+  bool sample() const;
+  int64_t slowNs() const { return m_slowNs; }
+
+  void push(Record record);
+
+  /**
+   * @brief Newest first, optionally only traces of at least minMs.
+   */
+  std::vector<Record> recent(size_t limit, int minMs) const;
+
+  Stats stats() const;
+
+private:
+  TraceBuffer() = default;
+  TraceBuffer(const TraceBuffer &) = delete;
+  TraceBuffer &operator=(const TraceBuffer &) = delete;
+
+  bool m_serverTiming = false;
+  double m_sampleRate = 0.0;
+  int64_t m_slowNs = 0;
+
+  mutable std::mutex m_mutex;
+  std::vector<Record> m_ring;
+  size_t m_capacity = 256;
+  size_t m_next = 0; // nächster Schreibplatz
+  std::atomic<uint64_t> m_recorded{0};
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,136 @@
+/**
+ * @file response_compressor.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Negotiated HTTP response compression (gzip/deflate, brotli/zstd)
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "crow.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Compresses response bodies according to the client's
+ *        Accept-Encoding (q-values honoured).
+ *
+ * Preference: zstd, br (only if built with CAKE_HAVE_ZSTD /
+ * CAKE_HAVE_BROTLI), gzip, deflate. Only text-like content types above
+ * CAKE_COMPRESS_MIN_BYTES are compressed; photos, SSE and other
+ * already-compressed types never are. Per-route policy via
+ * CAKE_COMPRESS_ROUTES ("prefix=off|level,..."; longest prefix wins).
+ *
+ * A result that saves less than CAKE_COMPRESS_MIN_SAVING_PCT percent is
+ * discarded and the body is sent as is. Bodies with an ETag are cached
+ * compressed (CAKE_COMPRESS_CACHE_BYTES, LRU), so unchanged lists are
+ * compressed only once; the ETag becomes weak (W/) like nginx does.
+ */
+class ResponseCompressor {
+public:
+  enum class Encoding { Identity, Deflate, Gzip, Brotli, Zstd };
+
+  struct Stats {
+    uint64_t eligible = 0;
+    uint64_t compressed = 0;
+    uint64_t skippedSmall = 0;
+    uint64_t skippedNotWorth = 0;
+    uint64_t cacheHits = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t cpuUs = 0;
+    size_t cacheBytes = 0;
+    size_t cacheEntries = 0;
+    std::vector<std::string> encodings; // verfügbare Kodierungen
+  };
+
+  static ResponseCompressor &instance();
+
+  /**
+   * @brief Read CAKE_COMPRESS_* settings.
+   */
+  void configureFromEnv();
+
+  /**
+   * @brief Compress res.body in place if policy, size and negotiation allow.
+   */
+  void apply(const crow::request &req, crow::response &res);
+
+  /**
+   * @brief Best encoding accepted by the client (Identity if none).
+   */
+  Encoding negotiate(std::string_view acceptEncoding) const;
+
+  static const char *name(Encoding encoding);
+
+  Stats stats() const;
+
+private:
+  ResponseCompressor() = default;
+  ResponseCompressor(const ResponseCompressor &) = delete;
+  ResponseCompressor &operator=(const ResponseCompressor &) = delete;
+
+  struct RoutePolicy {
+    std::string prefix;
+    bool enabled = true;
+    int level = 0; // 0 = Default der Kodierung
+  };
+
+  const RoutePolicy *policyFor(std::string_view path) const;
+  static bool compressibleType(std::string_view contentType);
+
+  /// Komprimieren; leer, wenn die Kodierung fehlschlägt
+  std::string encode(std::string_view body, Encoding encoding, int level) const;
+  int defaultLevel(Encoding encoding) const;
+
+  // --- Cache für Antworten mit ETag ---
+  using Bytes = std::shared_ptr<const std::string>; // nullptr = lohnt nicht
+  bool cacheGet(const std::string &key, Bytes &out);
+  void cachePut(const std::string &key, Bytes bytes);
+
+  bool m_enabled = true;
+  size_t m_minBytes = 1024;
+  size_t m_maxBytes = 8 * 1024 * 1024;
+  int m_minSavingPct = 10;
+  int m_gzipLevel = 4;
+  int m_brotliLevel = 4;
+  int m_zstdLevel = 3;
+  std::vector<RoutePolicy> m_routes; // nach Präfixlänge absteigend
+
+  mutable std::mutex m_cacheMutex;
+  std::list<std::string> m_lru; // vorne = zuletzt benutzt
+  struct CacheEntry {
+    Bytes bytes;
+    std::list<std::string>::iterator lruPos;
+  };
+  std::unordered_map<std::string, CacheEntry> m_cache;
+  size_t m_cacheBytes = 0;
+  size_t m_cacheCapacity = 8 * 1024 * 1024;
+
+  std::atomic<uint64_t> m_eligible{0};
+  std::atomic<uint64_t> m_compressed{0};
+  std::atomic<uint64_t> m_skippedSmall{0};
+  std::atomic<uint64_t> m_skippedNotWorth{0};
+  std::atomic<uint64_t> m_cacheHits{0};
+  std::atomic<uint64_t> m_bytesIn{0};
+  std::atomic<uint64_t> m_bytesOut{0};
+  std::atomic<uint64_t> m_cpuUs{0};
+};
+
+} // namespace utils
+} // namespace rz
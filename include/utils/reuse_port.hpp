@@ -0,0 +1,45 @@
+/**
+ * @file reuse_port.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief SO_REUSEPORT for the HTTP listener in prefork mode
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Let several worker processes bind the same TCP port.
+ *
+ * Crow opens and binds its acceptor itself and has no hook for extra
+ * socket options (and is not pinned, so there is no stable source to
+ * patch). Once enabled, the TCP socket bound to the given port gets
+ * SO_REUSEPORT right before bind(); the kernel then spreads incoming
+ * connections over all workers listening on the port. Sockets on other
+ * ports are left alone. The process aborts if the real bind() cannot be
+ * resolved.
+ *
+ * Another instance of the same user could join the port as well; the
+ * supervisor guards against that with a per-port lock file.
+ */
+class ReusePort {
+public:
+  /**
+   * @brief Enable for the following bind() calls on this port.
+   * @return false if the platform has no SO_REUSEPORT or the port is invalid.
+   */
+  static bool enable(int port);
+
+  static bool enabled();
+  static int port();
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,66 @@
+/**
+ * @file revocation_list.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief In-memory set of revoked session ids
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <QString>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Revoked session ids, consulted by AuthMiddleware on every request.
+ *
+ * Access tokens carry their session id ('sid'). Revoking a session makes
+ * its still-valid access tokens unusable without a DB lookup per request.
+ * An entry is only needed until the last access token of the session has
+ * expired; prune() drops older ones (housekeeping job, and every few
+ * hundred revocations in each worker).
+ */
+class RevocationList {
+public:
+  static RevocationList &instance();
+
+  // Beim Start aus der DB befüllen (Session-Id, gültig bis)
+  void load(const std::vector<std::pair<QString, qint64>> &sessions);
+
+  /**
+   * @param expiresAt When the last access token of the session expires.
+   */
+  void revoke(const QString &sessionId, qint64 expiresAt);
+  bool isRevoked(const QString &sessionId) const;
+
+  /**
+   * @brief Drop entries whose access tokens have expired.
+   * @return Number of entries removed.
+   */
+  size_t prune(qint64 now);
+
+  size_t size() const;
+
+private:
+  RevocationList() = default;
+  RevocationList(const RevocationList &) = delete;
+  RevocationList &operator=(const RevocationList &) = delete;
+
+  size_t pruneLocked(qint64 now);
+
+  mutable std::shared_mutex m_mutex;
+  std::unordered_map<QString, qint64> m_revoked; // Session-Id -> gültig bis
+  size_t m_sinceSweep = 0;
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,76 @@
+/**
+ * @file spsc_ring.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Fixed-capacity ring for exactly one producer and one consumer thread.
+ *
+ * push() and pop() never block and never allocate; the capacity is rounded
+ * up to a power of two. A full ring rejects the push, the caller decides
+ * what to do with the overflow.
+ */
+template <typename T> class SpscRing {
+public:
+  explicit SpscRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    m_slots.resize(size);
+    m_mask = size - 1;
+  }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /// Nur vom Producer-Thread
+  bool push(T value) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask) return false; // voll
+    m_slots[tail & m_mask] = std::move(value);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Nur vom Consumer-Thread
+  bool pop(T &out) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) return false; // leer
+    out = std::move(m_slots[head & m_mask]);
+    m_slots[head & m_mask] = T{};
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const { return m_mask + 1; }
+
+  /// Näherungswert, nur für Statistiken
+  size_t size() const {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+
+private:
+  std::vector<T> m_slots;
+  size_t m_mask = 0;
+  // Eigene Cache-Lines, damit Producer und Consumer sich nicht gegenseitig ausbremsen
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,90 @@
+/**
+ * @file token_cache.hpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Sharded LRU cache for verified JWT payloads
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "utils/token_utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace rz {
+namespace utils {
+
+/**
+ * @brief Process-wide cache from token hash (SHA-256) to verified payload.
+ *
+ * Avoids decoding, JSON parsing and HMAC verification for tokens that were
+ * already validated. Entries are never returned after their 'exp' claim.
+ */
+class TokenCache {
+public:
+  static TokenCache &instance();
+
+  /**
+   * @brief Set the total number of cached tokens (spread over all shards).
+   */
+  void setCapacity(size_t capacity);
+
+  /**
+   * @brief Look up a raw token. Returns nullopt on miss or if expired.
+   */
+  std::optional<TokenPayload> get(const std::string &rawToken);
+
+  /**
+   * @brief Store a freshly verified payload for the raw token.
+   */
+  void put(const std::string &rawToken, const TokenPayload &payload);
+
+  /**
+   * @brief Drop every cached token of a user (e.g. after revocation).
+   */
+  void invalidateUser(const QString &userId);
+
+  uint64_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+  TokenCache() = default;
+  TokenCache(const TokenCache &) = delete;
+  TokenCache &operator=(const TokenCache &) = delete;
+
+  static constexpr size_t SHARD_COUNT = 16;
+
+  struct Entry {
+    std::string key;
+    TokenPayload payload;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::list<Entry> lru; // vorne = zuletzt benutzt
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  };
+
+  static std::string hashToken(const std::string &rawToken);
+  Shard &shardFor(const std::string &key);
+  void evictOverflow(Shard &shard);
+
+  std::array<Shard, SHARD_COUNT> m_shards;
+  std::atomic<size_t> m_shardCapacity{256};
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+};
+
+} // namespace utils
+} // namespace rz
@@ -2,8 +2,8 @@
  * @file token_utils.hpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.3.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -21,14 +21,44 @@ namespace utils {
 struct TokenPayload {
   QString userId;
   QString email;
-  bool isAdmin;
+  bool isAdmin = false;
+  qint64 expiresAt = 0; // 'exp' Claim, Sekunden seit Epoch
+  QString sessionId;    // 'sid' Claim, leer bei alten Tokens
 };
 
 class TokenUtils {
 public:
-  // Generiert ein Token, gültig für 24h
+  /**
+   * @brief Build the process-wide signing secret and JWT verifier.
+   *
+   * Called once at startup; later calls are no-ops. The verifier is immutable
+   * afterwards and shared by all worker threads.
+   */
+  static void init();
+
+  // Generiert ein kurzlebiges Access Token (CAKE_ACCESS_TOKEN_MINUTES, Default 15)
   static QString generateToken(const QString &userId, const QString &email,
-                               bool isAdmin);
+                               bool isAdmin, const QString &sessionId = "");
+
+  /**
+   * @brief Lifetime of access tokens in seconds.
+   */
+  static qint64 accessTokenTtl();
+
+  /**
+   * @brief Lifetime of refresh tokens in seconds (CAKE_REFRESH_TOKEN_DAYS, default 30).
+   */
+  static qint64 refreshTokenTtl();
+
+  /**
+   * @brief Create a random, opaque refresh token (256 bit, base64url).
+   */
+  static QString generateRefreshToken();
+
+  /**
+   * @brief SHA-256 (hex) of a refresh token, the only form stored in the DB.
+   */
+  static QString hashRefreshToken(const QString &refreshToken);
 
   // Verifiziert das Token und gibt Payload zurück (oder nullopt bei Fehler)
   static std::optional<TokenPayload> verifyToken(const std::string &rawToken);
@@ -2,8 +2,8 @@
  * @file admin_controller.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.4.0
- * @date 2026-01-03
+ * @version 0.19.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -13,36 +13,48 @@
 
 #include "controllers/admin_controller.hpp"
 #include "middleware/auth_middleware.hpp"
+#include "models/digest_model.hpp"
+#include "models/notification_job_model.hpp"
+#include "models/outbox_model.hpp"
 #include "models/user_model.hpp"
+#include "services/async.hpp"
+#include "services/change_bus.hpp"
+#include "services/executors.hpp"
+#include "utils/mail_templates.hpp"
+#include "utils/metrics.hpp"
+#include "utils/request_trace.hpp"
 #include "database.hpp" // Global namespace
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace rz {
 namespace controller {
 
-void AdminController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &app) {
+void AdminController::registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app) {
 
   // --- GET /api/admin/users ---
   CROW_ROUTE(app, "/api/admin/users")
   ([&](const crow::request &req) {
     const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
-    if (ctx.currentUser.userId.isEmpty()) return crow::response(401);
+    if (!ctx.auth) return crow::response(401);
 
     std::vector<User> users;
 
-    if (ctx.currentUser.isAdmin) {
+    if (ctx.auth->isAdmin) {
+      rz::utils::TraceScope scope("db");
       users = User::getAll();
     } else {
-      auto info = User::getGroupAndRole(ctx.currentUser.userId);
-      QString myGroupId = info.first;
-      QString myRole = info.second;
-
-      if (myRole == "admin" && !myGroupId.isEmpty()) {
-        users = User::getAll(myGroupId);
-      } else {
-        return crow::response(403);
+      auto adminGroups = ctx.auth->adminGroupIds();
+      if (adminGroups.empty()) return crow::response(403);
+      rz::utils::TraceScope scope("db");
+      for (const auto &gid : adminGroups) {
+        auto members = User::getAll(gid);
+        users.insert(users.end(), members.begin(), members.end());
       }
     }
 
+    rz::utils::TraceScope scope("json");
     crow::json::wvalue result = crow::json::wvalue::list();
     for (size_t i = 0; i < users.size(); ++i) {
       result[i] = users[i].toJson();
@@ -112,38 +124,158 @@ void AdminController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
   CROW_ROUTE(app, "/api/admin/groups")
   ([&](const crow::request &req) {
     const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
-    if (ctx.currentUser.userId.isEmpty()) return crow::response(401);
+    if (!ctx.auth) return crow::response(401);
 
-    auto allGroups = User::getAllGroups();
     crow::json::wvalue json = crow::json::wvalue::list();
     int idx = 0;
 
-    if (ctx.currentUser.isAdmin) {
-      for (const auto &g : allGroups) {
+    if (ctx.auth->isAdmin) {
+      for (const auto &g : User::getAllGroups()) {
         json[idx]["id"] = g.first.toStdString();
         json[idx]["name"] = g.second.toStdString();
         idx++;
       }
     } else {
-      auto info = User::getGroupAndRole(ctx.currentUser.userId);
-      QString myGroupId = info.first;
-      QString myRole = info.second;
-
-      if (myRole == "admin" && !myGroupId.isEmpty()) {
-        for (const auto &g : allGroups) {
-          if (g.first == myGroupId) {
-            json[idx]["id"] = g.first.toStdString();
-            json[idx]["name"] = g.second.toStdString();
-            idx++;
-          }
-        }
-      } else {
-        return crow::response(403);
+      // Gruppen-Admins: Namen stehen bereits im Snapshot, kein Query nötig
+      for (const auto &g : ctx.auth->groups) {
+        if (g.role != "admin") continue;
+        json[idx]["id"] = g.groupId.toStdString();
+        json[idx]["name"] = g.groupName.toStdString();
+        idx++;
       }
+      if (idx == 0) return crow::response(403);
     }
     return crow::response(json);
   });
 
+  // --- GET /api/admin/metrics ---
+  // Dieselbe Registry wie /metrics (Prometheus-Text), für Admins ohne Scrape-Token.
+  // Prefork: Werte gelten für den Worker, der die Anfrage bekommen hat
+  CROW_ROUTE(app, "/api/admin/metrics")
+  ([&](const crow::request &req) {
+    const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+    if (!ctx.currentUser.isAdmin) return crow::response(403);
+
+    crow::response res(200, rz::utils::MetricsRegistry::instance().render());
+    res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    res.set_header("Cache-Control", "no-store");
+    return res;
+  });
+
+  // --- GET /api/admin/traces?limit=50&minMs=0 ---
+  // Gesampelte und langsame Requests dieses Workers, neueste zuerst
+  CROW_ROUTE(app, "/api/admin/traces")
+  ([&](const crow::request &req) {
+    const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+    if (!ctx.currentUser.isAdmin) return crow::response(403);
+
+    int limit = 50;
+    int minMs = 0;
+    if (auto p = req.url_params.get("limit")) limit = std::clamp(std::atoi(p), 1, 1000);
+    if (auto p = req.url_params.get("minMs")) minMs = std::max(0, std::atoi(p));
+
+    auto &buffer = rz::utils::TraceBuffer::instance();
+    auto stats = buffer.stats();
+    crow::json::wvalue res;
+    res["serverTiming"] = stats.serverTiming;
+    res["sampleRate"] = stats.sampleRate;
+    res["slowMs"] = stats.slowMs;
+    res["capacity"] = stats.capacity;
+    res["stored"] = stats.stored;
+    res["recorded"] = stats.recorded;
+    res["traces"] = crow::json::wvalue::list();
+
+    int i = 0;
+    for (const auto &t : buffer.recent(static_cast<size_t>(limit), minMs)) {
+      auto &item = res["traces"][i++];
+      item["id"] = t.id;
+      item["startedAt"] = t.startedAtMs;
+      item["method"] = t.method;
+      item["path"] = t.path;
+      item["userId"] = t.userId;
+      item["status"] = t.status;
+      item["totalMs"] = t.totalUs / 1000.0;
+      item["slow"] = t.slow;
+      item["phases"] = crow::json::wvalue::object();
+      int64_t phasesUs = 0;
+      for (const auto &[name, us] : t.phasesUs) {
+        item["phases"][name] = us / 1000.0;
+        phasesUs += us;
+      }
+      // Routing, Handler-Logik, Middleware: alles außerhalb benannter Phasen
+      item["otherMs"] = std::max<int64_t>(0, t.totalUs - phasesUs) / 1000.0;
+    }
+    return crow::response(res);
+  });
+
+  // --- GET /api/admin/outbox ---
+  CROW_ROUTE(app, "/api/admin/outbox")
+  ([&](const crow::request &req, crow::response &res) {
+    const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+    if (!ctx.currentUser.isAdmin) {
+      res = crow::response(403);
+      res.end();
+      return;
+    }
+
+    // Vier unabhängige Abfragen parallel auf dem db-read Pool
+    using rz::service::Executors;
+    rz::service::respond(req, res, []() -> rz::service::Task<crow::response> {
+      auto [stats, jobsPending, digestItemsPending, dead] = co_await rz::service::whenAll(
+          rz::service::runOn(Executors::Pool::DbRead, [] { return OutboxMessage::stats(); }),
+          rz::service::runOn(Executors::Pool::DbRead, [] { return NotificationJob::pendingCount(); }),
+          rz::service::runOn(Executors::Pool::DbRead, [] { return DigestItem::pendingCount(); }),
+          rz::service::runOn(Executors::Pool::DbRead, [] { return OutboxMessage::getDead(50); }));
+
+      crow::json::wvalue json;
+      json["pending"] = stats.pending;
+      json["sending"] = stats.sending;
+      json["sent"] = stats.sent;
+      json["dead"] = stats.dead;
+      json["oldestPendingAgeSec"] = stats.oldestPendingAgeSec;
+      json["jobsPending"] = jobsPending;
+      json["digestItemsPending"] = digestItemsPending;
+
+      json["deadLetters"] = crow::json::wvalue::list();
+      int i = 0;
+      for (const auto &m : dead) {
+        json["deadLetters"][i++] = m.toJson();
+      }
+      co_return crow::response(json);
+    }());
+  });
+
+  // --- POST /api/admin/outbox/<id>/retry ---
+  CROW_ROUTE(app, "/api/admin/outbox/<string>/retry")
+      .methods(crow::HTTPMethod::POST)([&](const crow::request &req, std::string id) {
+        const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        if (!ctx.currentUser.isAdmin) return crow::response(403);
+
+        if (OutboxMessage::requeue(QString::fromStdString(id))) {
+          crow::json::wvalue res; res["message"] = "Message requeued";
+          return crow::response(200, res);
+        }
+        return crow::response(404);
+      });
+
+  // --- POST /api/admin/templates/reload ---
+  CROW_ROUTE(app, "/api/admin/templates/reload")
+      .methods(crow::HTTPMethod::POST)([&](const crow::request &req) {
+        const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        if (!ctx.currentUser.isAdmin) return crow::response(403);
+
+        auto &templates = rz::utils::MailTemplates::instance();
+        crow::json::wvalue res;
+        res["templates"] = templates.reload();
+        rz::service::ChangeBus::instance().reloadTemplates(); // andere Worker
+        res["languages"] = crow::json::wvalue::list();
+        int i = 0;
+        for (const auto &lang : templates.languages()) {
+          res["languages"][i++] = lang.toStdString();
+        }
+        return crow::response(res);
+      });
+
   // --- POST /api/admin/users/assign-group ---
   CROW_ROUTE(app, "/api/admin/users/assign-group")
       .methods(crow::HTTPMethod::POST)([&](const crow::request &req) {
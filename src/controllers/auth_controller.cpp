@@ -2,8 +2,8 @@
  * @file auth_controller.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Auth Controller Implementation
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.12.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -11,57 +11,178 @@
  */
 
 #include "controllers/auth_controller.hpp"
+#include "database.hpp"
+#include "models/session_model.hpp"
 #include "models/user_model.hpp"
+#include "services/async.hpp"
+#include "services/change_bus.hpp"
+#include "services/executors.hpp"
+#include "services/hash_executor.hpp"
 #include "services/notification_service.hpp"
 #include "utils/password_utils.hpp"
+#include "utils/request_trace.hpp"
 #include "utils/token_utils.hpp"
 #include "utils/totp_utils.hpp"
+#include <QDateTime>
 #include <QDebug>
 
 namespace rz {
 namespace controller {
 
+/**
+ * @brief Write access token, rotating refresh token and expiry into a response.
+ */
+static void writeTokens(crow::json::wvalue &res, const QString &accessToken,
+                        const QString &refreshToken) {
+  res["token"] = accessToken.toStdString();
+  res["refreshToken"] = refreshToken.toStdString();
+  res["expiresIn"] = rz::utils::TokenUtils::accessTokenTtl();
+}
+
+/**
+ * @brief Transparently rehash a password created with old Argon2 parameters.
+ *
+ * Best effort: if the executor is full we try again on the next login.
+ * The hash runs on the CPU pool, the UPDATE on the DB writer.
+ */
+static void rehashIfNeeded(const User &user, const QString &password) {
+  if (!rz::utils::PasswordUtils::needsRehash(user.password_hash)) return;
+
+  QString userId = user.id;
+  rz::service::HashExecutor::instance().submit<void>([password, userId]() {
+    QString newHash = rz::utils::PasswordUtils::hashPassword(password);
+    if (newHash.isEmpty()) return;
+    rz::service::Executors::instance()
+        .get(rz::service::Executors::Pool::DbWrite)
+        .post([userId, newHash]() {
+          if (User::updatePasswordHash(userId, newHash)) {
+            qInfo() << "Passwort-Hash mit neuen Argon2-Parametern aktualisiert:" << userId;
+          }
+        });
+  });
+}
+
+/**
+ * @brief Second half of the login after a successful password check:
+ *        2FA, account state, new session and tokens. Only a complete login
+ *        (2FA included) may upgrade the password hash.
+ */
+static crow::response completeLogin(const crow::request &req, const User &user,
+                                    const QString &password, const QString &totpCode) {
+  // 2FA Check
+  if (!user.totp_secret.isEmpty()) {
+    if (totpCode.isEmpty()) {
+      crow::json::wvalue res;
+      res["require2fa"] = true;
+      return crow::response(200, res);
+    }
+    if (!rz::utils::TotpUtils::validateCode(user.totp_secret, totpCode)) {
+      return crow::response(401, "Invalid 2FA code");
+    }
+  }
+
+  if (!user.is_active)
+    return crow::response(403, "Account inactive");
+
+  // Neue Session pro Gerät, Refresh Token wird nur gehasht gespeichert
+  QString refreshToken = rz::utils::TokenUtils::generateRefreshToken();
+  Session session;
+  session.userId = user.id;
+  session.device = QString::fromStdString(req.get_header_value("User-Agent")).left(255);
+  session.ipAddress = QString::fromStdString(req.remote_ip_address);
+  session.expiresAt =
+      QDateTime::currentSecsSinceEpoch() + rz::utils::TokenUtils::refreshTokenTtl();
+  if (refreshToken.isEmpty() ||
+      !session.create(rz::utils::TokenUtils::hashRefreshToken(refreshToken))) {
+    return crow::response(500, "Could not create session");
+  }
+  rehashIfNeeded(user, password);
+
+  auto token = rz::utils::TokenUtils::generateToken(user.id, user.email,
+                                                    user.is_admin, session.id);
+  crow::json::wvalue res;
+  writeTokens(res, token, refreshToken);
+  res["user"] = user.toJson();
+  return crow::response(200, res);
+}
+
 AuthController::AuthController(service::NotificationService* notifyService)
     : m_notifyService(notifyService) {}
 
 // KORRIGIERT: Namespace rz::middleware::AuthMiddleware
-void AuthController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &app) {
+void AuthController::registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app) {
 
-  // 1. REGISTRIERUNG
+  // 1. REGISTRIERUNG (Coroutine: Argon2 im Hash-Slot, Insert auf db-write)
   CROW_ROUTE(app, "/api/auth/register")
-      .methods(crow::HTTPMethod::POST)([this](const crow::request &req) {
+      .methods(crow::HTTPMethod::POST)([this](const crow::request &req, crow::response &res) {
         auto json = crow::json::load(req.body);
         if (!json || !json.has("email") || !json.has("password") ||
             !json.has("name")) {
-          return crow::response(400, "Missing parameters");
+          res = crow::response(400, "Missing parameters");
+          res.end();
+          return;
         }
 
         User user;
         user.email = QString::fromStdString(json["email"].s());
-        // Voll qualifizierter Aufruf für utils
-        user.password_hash = rz::utils::PasswordUtils::hashPassword(
-            QString::fromStdString(json["password"].s()));
         user.full_name = QString::fromStdString(json["name"].s());
+        QString plainPassword = QString::fromStdString(json["password"].s());
 
-        if (user.create()) {
-            // Notification auslösen
-            if (m_notifyService) {
-                m_notifyService->notifyAdminsNewUser(user.full_name, user.email);
-            } else {
-                qWarning() << "NotificationService not available inside AuthController!";
-            }
-            return crow::response(201, "User created");
-        } else {
-            return crow::response(400, "User already exists or database error");
-        }
+        // Trace explizit mitgeben: die Coroutine wechselt den Thread
+        rz::service::respond(req, res,
+            [](User user, QString plainPassword, service::NotificationService *notifyService,
+               rz::utils::RequestTrace *trace) -> rz::service::Task<crow::response> {
+              // Günstige Prüfung zuerst, bevor Argon2 (64 MiB) gerechnet wird
+              bool exists;
+              {
+                rz::utils::TraceScope scope(trace, "db");
+                exists = (co_await User::getByEmailAsync(user.email)).has_value();
+              }
+              if (exists) co_return crow::response(400, "User already exists or database error");
+
+              {
+                rz::utils::TraceScope scope(trace, "hash");
+                user.password_hash = co_await rz::utils::PasswordUtils::hashPasswordAsync(plainPassword);
+              }
+              if (user.password_hash.isEmpty()) {
+                co_return crow::response(500, "Hashing failed");
+              }
+
+              // User und Admin-Benachrichtigung (Outbox) in einer Transaktion auf einem Thread
+              rz::utils::TraceScope scope(trace, "db");
+              co_return co_await rz::service::runOn(
+                  rz::service::Executors::Pool::DbWrite, [user, notifyService]() mutable {
+                    auto db = DatabaseManager::instance().getDatabase();
+                    db.transaction();
+                    if (!user.create()) {
+                      db.rollback();
+                      return crow::response(400, "User already exists or database error");
+                    }
+                    // Notification auslösen
+                    bool queued = true;
+                    if (notifyService) {
+                      queued = notifyService->notifyAdminsNewUser(user.full_name, user.email);
+                    } else {
+                      qWarning() << "NotificationService not available inside AuthController!";
+                    }
+                    if (!queued || !db.commit()) {
+                      db.rollback();
+                      return crow::response(500, "Database error");
+                    }
+                    if (notifyService) notifyService->dispatch();
+                    return crow::response(201, "User created");
+                  });
+            }(user, plainPassword, m_notifyService, rz::utils::RequestTrace::current()));
       });
 
-  // 2. LOGIN
+  // 2. LOGIN (Coroutine: Lookup auf db-read, Argon2 im Hash-Slot, Session auf db-write)
   CROW_ROUTE(app, "/api/login")
-      .methods(crow::HTTPMethod::POST)([](const crow::request &req) {
+      .methods(crow::HTTPMethod::POST)([](const crow::request &req, crow::response &res) {
         auto json = crow::json::load(req.body);
         if (!json || !json.has("email") || !json.has("password")) {
-          return crow::response(400, "Missing credentials");
+          res = crow::response(400, "Missing credentials");
+          res.end();
+          return;
         }
 
         QString email = QString::fromStdString(json["email"].s());
@@ -71,38 +192,124 @@ void AuthController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &a
           totpCode = QString::fromStdString(json["code"].s());
         }
 
-        auto userOpt = User::getByEmail(email);
-        if (!userOpt)
-          return crow::response(401, "Invalid credentials");
-        User user = *userOpt;
+        // req und Trace bleiben bis res.end() gültig
+        rz::service::respond(req, res,
+            [](const crow::request &req, QString email, QString password, QString totpCode,
+               rz::utils::RequestTrace *trace) -> rz::service::Task<crow::response> {
+              std::optional<User> userOpt;
+              {
+                rz::utils::TraceScope scope(trace, "db");
+                userOpt = co_await User::getByEmailAsync(email);
+              }
+              if (!userOpt) co_return crow::response(401, "Invalid credentials");
+              User user = *userOpt;
 
-        if (!rz::utils::PasswordUtils::verifyPassword(password, user.password_hash)) {
-          return crow::response(401, "Invalid credentials");
+              bool verified;
+              {
+                rz::utils::TraceScope scope(trace, "hash");
+                verified = co_await rz::utils::PasswordUtils::verifyPasswordAsync(password,
+                                                                                 user.password_hash);
+              }
+              if (!verified) co_return crow::response(401, "Invalid credentials");
+
+              rz::utils::TraceScope scope(trace, "db");
+              co_return co_await rz::service::runOn(
+                  rz::service::Executors::Pool::DbWrite, [&req, user, password, totpCode]() {
+                    return completeLogin(req, user, password, totpCode);
+                  });
+            }(req, email, password, totpCode, rz::utils::RequestTrace::current()));
+      });
+
+  // 2b. REFRESH (ohne Passwort: ein SHA-256, ein Index-Lookup, ein HMAC)
+  CROW_ROUTE(app, "/api/auth/refresh")
+      .methods(crow::HTTPMethod::POST)([](const crow::request &req) {
+        auto json = crow::json::load(req.body);
+        if (!json || !json.has("refreshToken")) {
+          return crow::response(400, "Missing refresh token");
         }
 
-        // 2FA Check
-        if (!user.totp_secret.isEmpty()) {
-          if (totpCode.isEmpty()) {
-            crow::json::wvalue res;
-            res["require2fa"] = true;
-            return crow::response(200, res);
-          }
-          if (!rz::utils::TotpUtils::validateCode(user.totp_secret, totpCode)) {
-            return crow::response(401, "Invalid 2FA code");
+        QString presented = QString::fromStdString(json["refreshToken"].s());
+        QString presentedHash = rz::utils::TokenUtils::hashRefreshToken(presented);
+
+        // Wiederverwendung eines Tokens: Kopie im Umlauf, Session sperren
+        auto revokeStolen = [](const Session &s) {
+          qWarning() << "[Auth] Refresh Token wiederverwendet, Session" << s.id << "gesperrt";
+          if (Session::revoke(s.id, s.userId)) {
+            rz::service::ChangeBus::instance().revokeSession(s.id);
           }
+          return crow::response(401, "Invalid refresh token");
+        };
+
+        auto session = Session::getByRefreshHash(presentedHash);
+        if (!session) {
+          auto rotated = Session::getByPreviousRefreshHash(presentedHash);
+          if (rotated && !rotated->revoked) return revokeStolen(*rotated);
+          return crow::response(401, "Invalid refresh token");
+        }
+        qint64 now = QDateTime::currentSecsSinceEpoch();
+        if (session->revoked || session->expiresAt <= now || !session->userIsActive) {
+          return crow::response(401, "Invalid refresh token");
         }
 
-        if (!user.is_active)
-          return crow::response(403, "Account inactive");
+        // Rotation: das alte Refresh Token ist danach ungültig
+        QString nextToken = rz::utils::TokenUtils::generateRefreshToken();
+        if (nextToken.isEmpty()) return crow::response(500);
+        if (!Session::rotate(session->id, presentedHash,
+                             rz::utils::TokenUtils::hashRefreshToken(nextToken),
+                             now + rz::utils::TokenUtils::refreshTokenTtl())) {
+          // Gleichzeitig schon rotiert: dasselbe Token wurde zweimal benutzt
+          return revokeStolen(*session);
+        }
 
-        auto token =
-            rz::utils::TokenUtils::generateToken(user.id, user.email, user.is_admin);
+        auto token = rz::utils::TokenUtils::generateToken(
+            session->userId, session->userEmail, session->userIsAdmin, session->id);
         crow::json::wvalue res;
-        res["token"] = token.toStdString();
-        res["user"] = user.toJson();
+        writeTokens(res, token, nextToken);
         return crow::response(200, res);
       });
 
+  // 2c. SESSIONS (Geräte) auflisten
+  CROW_ROUTE(app, "/api/auth/sessions")
+  ([&](const crow::request &req) {
+    const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+
+    auto sessions = Session::getActiveByUser(ctx.currentUser.userId);
+    crow::json::wvalue result = crow::json::wvalue::list();
+    int i = 0;
+    for (const auto &s : sessions) {
+      result[i] = s.toJson();
+      result[i]["current"] = (s.id == ctx.currentUser.sessionId);
+      i++;
+    }
+    return crow::response(result);
+  });
+
+  // 2d. SESSION widerrufen (Gerät abmelden)
+  CROW_ROUTE(app, "/api/auth/sessions/<string>")
+      .methods(crow::HTTPMethod::DELETE)([&](const crow::request &req,
+                                             std::string sessionId) {
+        const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        QString sid = QString::fromStdString(sessionId);
+
+        if (!Session::revoke(sid, ctx.currentUser.userId)) {
+          return crow::response(404);
+        }
+        rz::service::ChangeBus::instance().revokeSession(sid);
+        return crow::response(200, "Session revoked");
+      });
+
+  // 2e. LOGOUT (aktuelle Session)
+  CROW_ROUTE(app, "/api/auth/logout")
+      .methods(crow::HTTPMethod::POST)([&](const crow::request &req) {
+        const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        const QString &sid = ctx.currentUser.sessionId;
+
+        if (!sid.isEmpty() && Session::revoke(sid, ctx.currentUser.userId)) {
+          rz::service::ChangeBus::instance().revokeSession(sid);
+        }
+        return crow::response(200, "Logged out");
+      });
+
   // 3. 2FA SETUP
   CROW_ROUTE(app, "/api/auth/2fa/setup")
       .methods(crow::HTTPMethod::POST)([&](const crow::request &req) {
@@ -1,9 +1,9 @@
 /**
  * @file event_controller.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
- * @brief Event Controller Implementation (Safe Blocking Long Polling)
- * @version 0.3.5
- * @date 2026-01-03
+ * @brief Event Controller Implementation (non-blocking SSE hub)
+ * @version 0.15.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -11,43 +11,134 @@
  */
 
 #include "controllers/event_controller.hpp"
+#include "database.hpp"
 #include "models/event_model.hpp"
-#include "models/user_model.hpp" // NEU: Für User::getAll
 #include "middleware/auth_middleware.hpp"
+#include "services/async.hpp"
+#include "services/change_bus.hpp"
+#include "services/event_hub.hpp"
+#include "services/ws_hub.hpp"
 #include "services/notification_service.hpp" // NEU: Für Notifications
+#include "utils/request_trace.hpp"
 
-#include <mutex>
-#include <condition_variable>
-#include <chrono>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
 #include <QUuid>
 #include <iostream>
 
-// --- Helpers (SSE / Long Polling) ---
+// --- Helpers (Realtime) ---
 
-std::mutex event_mutex;
-std::condition_variable event_cv;
-
-struct LatestEventData {
-    long long generation = 0;
-    crow::json::wvalue payload;
-} latestEvent;
+// Nur an Mitglieder der Gruppe (Topic "group:<id>"), SSE und WebSocket,
+// im Prefork-Modus auch an die Verbindungen der anderen Worker
+static void broadcastToGroup(const QString& groupId, crow::json::wvalue msg,
+                             std::string coalesceKey = {}) {
+    rz::service::ChangeBus::instance().publish(rz::service::EventHub::groupTopic(groupId),
+                                               std::move(msg), std::move(coalesceKey));
+}
 
 void broadcastNewEvent(const Event& evt) {
+    crow::json::wvalue msg;
+    msg["type"] = "NEW_EVENT";
+    msg["eventId"] = evt.id.toStdString();
+    msg["groupId"] = evt.groupId.toStdString();
+    msg["bakerId"] = evt.bakerId.toStdString();
+    msg["bakerName"] = evt.bakerName.toStdString();
+    msg["date"] = evt.date.toStdString();
+    broadcastToGroup(evt.groupId, std::move(msg));
+}
+
+// Neues Aggregat statt einzelner Bewertung: Clients überschreiben nur die Sterne
+static void broadcastRatingChanged(const QString& eventId) {
+    auto groupRating = Event::getGroupRating(eventId);
+    if (!groupRating) return;
+
+    crow::json::wvalue msg;
+    msg["type"] = "RATING_CHANGED";
+    msg["eventId"] = eventId.toStdString();
+    msg["groupId"] = groupRating->first.toStdString();
+    msg["average"] = groupRating->second.average;
+    msg["count"] = groupRating->second.count;
+    // Mehrere Bewertungen kurz hintereinander: nur das letzte Aggregat zählt
+    broadcastToGroup(groupRating->first, std::move(msg), "RATING:" + eventId.toStdString());
+}
+
+static void broadcastEventDeleted(const QString& eventId, const QString& groupId) {
+    crow::json::wvalue msg;
+    msg["type"] = "EVENT_DELETED";
+    msg["eventId"] = eventId.toStdString();
+    msg["groupId"] = groupId.toStdString();
+    broadcastToGroup(groupId, std::move(msg));
+}
+
+static void broadcastPhotoAdded(const EventPhoto& photo, const QString& groupId) {
+    crow::json::wvalue msg = photo.toJson();
+    msg["type"] = "PHOTO_ADDED";
+    msg["groupId"] = groupId.toStdString();
+    broadcastToGroup(groupId, std::move(msg),
+                     "PHOTO:" + photo.eventId.toStdString() + ":" + photo.userId.toStdString());
+}
+
+// --- Helpers (ETag) ---
+
+// Maximale Anzahl Events pro Batch-Anfrage (SQLite Parameter-Limit beachten)
+static constexpr int MAX_PHOTO_BATCH = 200;
+
+/**
+ * @brief Build a JSON response with a content based ETag.
+ *
+ * Answers with 304 Not Modified if the client already holds the same version.
+ */
+// If-None-Match: Liste, "*" und schwache Tags (W/, z.B. nach Kompression) erlaubt
+static bool etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+    if (ifNoneMatch.empty()) return false;
+    if (ifNoneMatch == "*") return true;
+    size_t pos = 0;
+    while (pos < ifNoneMatch.size()) {
+        size_t end = ifNoneMatch.find(',', pos);
+        if (end == std::string::npos) end = ifNoneMatch.size();
+        std::string tag = QString::fromStdString(ifNoneMatch.substr(pos, end - pos)).trimmed().toStdString();
+        if (tag.starts_with("W/")) tag.erase(0, 2);
+        if (tag == etag) return true;
+        pos = end + 1;
+    }
+    return false;
+}
+
+static crow::response jsonWithEtag(const crow::request& req, const crow::json::wvalue& json) {
+    std::string body;
+    {
+        rz::utils::TraceScope scope("json");
+        body = json.dump();
+    }
+    QByteArray digest;
     {
-        std::lock_guard<std::mutex> lock(event_mutex);
-        latestEvent.generation++;
+        rz::utils::TraceScope scope("etag");
+        digest = QCryptographicHash::hash(QByteArray::fromRawData(body.data(), body.size()),
+                                          QCryptographicHash::Sha1).toHex();
+    }
+    std::string etag = "\"" + digest.toStdString() + "\"";
 
-        crow::json::wvalue msg;
-        msg["type"] = "NEW_EVENT";
-        msg["groupId"] = evt.groupId.toStdString();
-        msg["bakerName"] = evt.bakerName.toStdString();
-        msg["date"] = evt.date.toStdString();
+    crow::response res;
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "private, no-cache");
+    if (etagMatches(req.get_header_value("If-None-Match"), etag)) {
+        res.code = 304;
+        return res;
+    }
+    res.code = 200;
+    res.set_header("Content-Type", "application/json");
+    res.body = std::move(body);
+    return res;
+}
 
-        latestEvent.payload = std::move(msg);
+static crow::json::wvalue photosToJson(const std::vector<EventPhoto>& photos) {
+    crow::json::wvalue list = crow::json::wvalue::list();
+    int i = 0;
+    for (const auto& p : photos) {
+        list[i++] = p.toJson();
     }
-    event_cv.notify_all();
+    return list;
 }
 
 // --- Routes ---
@@ -56,51 +147,77 @@ namespace rz {
 namespace controller {
 
 // Update Signatur: notifyService entgegennehmen
-void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &app, service::NotificationService* notifyService) {
+void EventController::registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app, service::NotificationService* notifyService) {
 
-    // 0. SSE Stream (unverändert)
+    // 0. SSE Stream: Response wird im EventHub geparkt, kein Worker-Thread blockiert
     CROW_ROUTE(app, "/api/events/stream")
     ([&](const crow::request& req, crow::response& res){
-        res.set_header("Content-Type", "text/event-stream");
-        res.set_header("Cache-Control", "no-cache");
-        res.set_header("Connection", "keep-alive");
-
-        long long myGen;
-        {
-            std::lock_guard<std::mutex> lock(event_mutex);
-            myGen = latestEvent.generation;
+        const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        if (!ctx.auth) {
+            res.code = 401;
+            res.end();
+            return;
         }
 
-        std::unique_lock<std::mutex> lock(event_mutex);
-        bool hasNewEvent = event_cv.wait_for(lock, std::chrono::seconds(29), [&]{
-            return latestEvent.generation > myGen;
-        });
+        // Topics aus den Mitgliedschaften im Auth-Snapshot
+        std::vector<std::string> topics;
+        for (const auto& m : ctx.auth->groups) {
+            topics.push_back(rz::service::EventHub::groupTopic(m.groupId));
+        }
 
-        if (hasNewEvent) {
-            std::string body = "data: " + latestEvent.payload.dump() + "\n\n";
-            res.write(body);
-        } else {
-            res.write(": keepalive\n\n");
+        if (!rz::service::EventHub::instance().subscribe(req, res, std::move(topics))) {
+            res.code = 503;
+            res.set_header("Retry-After", "5");
+            res.end("Too many stream subscribers");
         }
-        res.end();
     });
 
-    // 1. GET /api/events (unverändert)
+    // 0b. WebSocket: Auth beim Handshake (Middleware läuft bei Upgrades nicht)
+    CROW_WEBSOCKET_ROUTE(app, "/api/ws")
+        .max_payload(rz::service::WsHub::instance().maxMessageBytes())
+        .onaccept([](const crow::request& req, void** userdata) {
+            return rz::service::WsHub::instance().accept(req, userdata);
+        })
+        .onopen([](crow::websocket::connection& conn) {
+            rz::service::WsHub::instance().open(conn);
+        })
+        .onclose([](crow::websocket::connection& conn, const std::string&, uint16_t) {
+            rz::service::WsHub::instance().close(conn);
+        })
+        .onmessage([](crow::websocket::connection& conn, const std::string& data, bool isBinary) {
+            rz::service::WsHub::instance().message(conn, data, isBinary);
+        });
+
+    // 1. GET /api/events (Coroutine: Query auf dem db-read Pool)
     CROW_ROUTE(app, "/api/events")
-    ([&](const crow::request &req) {
+    ([&](const crow::request &req, crow::response &res) {
         const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
         auto start = req.url_params.get("start");
         auto end = req.url_params.get("end");
 
-        if (!start || !end) return crow::response(400, "Missing params");
-
-        auto events = Event::getRange(start, end, ctx.currentUser.userId);
-        crow::json::wvalue result = crow::json::wvalue::list();
-        int i = 0;
-        for (const auto &e : events) {
-            result[i++] = e.toJson();
+        if (!start || !end) {
+            res = crow::response(400, "Missing params");
+            res.end();
+            return;
         }
-        return crow::response(result);
+
+        // Trace explizit mitgeben: die Coroutine wechselt den Thread
+        rz::service::respond(req, res,
+            [](QString start, QString end, QString userId,
+               rz::utils::RequestTrace *trace) -> rz::service::Task<crow::response> {
+                std::vector<Event> events;
+                {
+                    rz::utils::TraceScope scope(trace, "db");
+                    events = co_await Event::getRangeAsync(start, end, userId);
+                }
+                rz::utils::TraceScope scope(trace, "json");
+                crow::json::wvalue result = crow::json::wvalue::list();
+                int i = 0;
+                for (const auto &e : events) {
+                    result[i++] = e.toJson();
+                }
+                co_return crow::response(result);
+            }(start, end, ctx.currentUser.userId, rz::utils::RequestTrace::current()));
     });
 
     // 2. POST /api/events (HIER IST DIE ÄNDERUNG!)
@@ -108,6 +225,10 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
     .methods(crow::HTTPMethod::POST)([&, notifyService](const crow::request &req) {
         const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
 
+        // Gruppe und Name kommen aus dem Auth-Kontext (kein zusätzlicher Query)
+        const auto* group = ctx.auth->primaryGroup();
+        if (!group) return crow::response(403, "No group assigned");
+
         crow::multipart::message msg(req);
         QString date, description, savedFileName;
 
@@ -141,36 +262,35 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
         e.date = date;
         e.description = description;
         e.photoPath = savedFileName;
+        e.bakerName = ctx.auth->displayName;
+        e.groupId = group->groupId;
+        e.groupName = group->groupName;
 
-        if (e.create(ctx.currentUser.userId)) {
-            broadcastNewEvent(e);
+        // Event und Notification-Job in einer Transaktion (keine verlorenen Mails)
+        auto db = DatabaseManager::instance().getDatabase();
+        db.transaction();
+        bool created = e.create(ctx.currentUser.userId);
 
+        if (created) {
             // --- NOTIFICATION LOGIC START ---
+            // Nur ein Job; Empfänger löst der NotificationWorker asynchron auf
             if (notifyService && !e.groupId.isEmpty()) {
-                // 1. Alle User der Gruppe laden
-                auto members = User::getAll(e.groupId);
-                std::vector<QString> de, en;
-
-                for (const auto& u : members) {
-                    // Sich selbst nicht benachrichtigen
-                    if (u.id == ctx.currentUser.userId) continue;
-                    // Nur aktive User benachrichtigen
-                    if (!u.is_active) continue;
-
-                    if (u.emailLanguage == "de") de.push_back(u.email);
-                    else en.push_back(u.email);
-                }
-
-                // 2. Service aufrufen
-                notifyService->notifyGroupNewEvent(e.groupName, e.bakerName, e.date, de, en);
+                created = notifyService->notifyGroupNewEvent(e.id, e.groupId, e.groupName,
+                                                             ctx.currentUser.userId, e.bakerName, e.date);
             }
             // --- NOTIFICATION LOGIC END ---
+        }
+
+        if (created && db.commit()) {
+            broadcastNewEvent(e);
+            if (notifyService) notifyService->dispatch();
 
             crow::json::wvalue res;
             res["message"] = "Event created";
             res["id"] = e.id.toStdString();
             return crow::response(201, res);
         } else {
+            db.rollback();
             return crow::response(500, "Error creating event");
         }
     });
@@ -179,13 +299,44 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
     // Ich kürze hier ab, der Rest der Datei ist identisch zur vorherigen Version.
     // Bitte übernimm die anderen Methoden (GET Single, DELETE, RATE, ICS, PHOTO) 1:1.
 
+    // 2b. GET /api/events/photos?ids=a,b,c (Batch-Galerie, vor GET Single registrieren!)
+    CROW_ROUTE(app, "/api/events/photos")
+    ([&](const crow::request& req){
+        const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        auto idsParam = req.url_params.get("ids");
+        if (!idsParam) return crow::response(400, "Missing ids");
+
+        QStringList ids = QString::fromUtf8(idsParam).split(',', Qt::SkipEmptyParts);
+        for (auto& id : ids) id = id.trimmed();
+        ids.removeDuplicates();
+        ids.removeAll(QString());
+        if (ids.isEmpty()) return crow::response(400, "Missing ids");
+        if (ids.size() > MAX_PHOTO_BATCH) return crow::response(400, "Too many ids");
+
+        std::map<QString, std::vector<EventPhoto>> batch;
+        {
+            rz::utils::TraceScope scope("db");
+            batch = Event::getPhotosBatch(ids, ctx.currentUser.userId);
+        }
+        crow::json::wvalue result = crow::json::wvalue::object();
+        for (const auto& [eventId, photos] : batch) {
+            result[eventId.toStdString()] = photosToJson(photos);
+        }
+        return jsonWithEtag(req, result);
+    });
+
     // 3. GET Single
     CROW_ROUTE(app, "/api/events/<string>")
     ([&](const crow::request& req, std::string eventId){
         const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
-        auto evt = Event::getById(QString::fromStdString(eventId), ctx.currentUser.userId);
-        if(evt) return crow::response(evt->toJson());
-        return crow::response(404);
+        std::optional<Event> evt;
+        {
+            rz::utils::TraceScope scope("db");
+            evt = Event::getById(QString::fromStdString(eventId), ctx.currentUser.userId);
+        }
+        if (!evt) return crow::response(404);
+        rz::utils::TraceScope scope("json");
+        return crow::response(evt->toJson());
     });
 
     // 4. DELETE
@@ -193,7 +344,10 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
     .methods(crow::HTTPMethod::DELETE)
     ([&](const crow::request& req, std::string eventId){
         const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
-        if(Event::deleteEvent(QString::fromStdString(eventId), ctx.currentUser.userId)) {
+        QString id = QString::fromStdString(eventId);
+        auto groupId = Event::getGroupId(id);
+        if(groupId && Event::deleteEvent(id, ctx.currentUser.userId)) {
+            broadcastEventDeleted(id, *groupId);
             return crow::response(200);
         }
         return crow::response(403);
@@ -210,7 +364,9 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
         int stars = json["stars"].i();
         std::string comment = json.has("comment") ? std::string(json["comment"].s()) : std::string("");
 
-        if(Event::rateEvent(QString::fromStdString(eventId), ctx.currentUser.userId, stars, QString::fromStdString(comment))) {
+        QString id = QString::fromStdString(eventId);
+        if(Event::rateEvent(id, ctx.currentUser.userId, stars, QString::fromStdString(comment))) {
+            broadcastRatingChanged(id);
             return crow::response(200);
         }
         return crow::response(500);
@@ -229,6 +385,15 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
         return res;
     });
 
+    // 7a. Photo Galerie eines Events
+    CROW_ROUTE(app, "/api/events/<string>/photos")
+    ([&](const crow::request& req, std::string eventId){
+        const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
+        auto photos = Event::getPhotos(QString::fromStdString(eventId), ctx.currentUser.userId);
+        if (!photos) return crow::response(404);
+        return jsonWithEtag(req, photosToJson(*photos));
+    });
+
     // 7. Photo
     CROW_ROUTE(app, "/api/events/<string>/photo")
     .methods(crow::HTTPMethod::POST)([&](const crow::request& req, std::string eventId){
@@ -247,7 +412,13 @@ void EventController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &
         }
 
         if (fileContent.empty()) return crow::response(400);
-        if(Event::uploadPhoto(QString::fromStdString(eventId), ctx.currentUser.userId, fileContent, ext)) {
+        QString id = QString::fromStdString(eventId);
+        if(auto photo = Event::uploadPhoto(id, ctx.currentUser.userId, fileContent, ext)) {
+            // Gleiche Felder wie GET /api/events/<id>/photos
+            if (auto groupId = Event::getGroupId(id)) {
+                photo->uploaderName = ctx.auth ? ctx.auth->displayName : QString();
+                broadcastPhotoAdded(*photo, *groupId);
+            }
             return crow::response(200);
         }
         return crow::response(500);
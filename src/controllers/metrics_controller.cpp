@@ -0,0 +1,237 @@
+/**
+ * @file metrics_controller.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Prometheus /metrics endpoint
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "controllers/metrics_controller.hpp"
+#include "models/outbox_model.hpp"
+#include "services/change_bus.hpp"
+#include "services/event_hub.hpp"
+#include "services/executors.hpp"
+#include "services/hash_executor.hpp"
+#include "services/send_scheduler.hpp"
+#include "services/supervisor.hpp"
+#include "services/ws_hub.hpp"
+#include "utils/auth_context_cache.hpp"
+#include "utils/env_loader.hpp"
+#include "utils/metrics.hpp"
+#include "utils/rate_limiter.hpp"
+#include "utils/response_compressor.hpp"
+#include "utils/token_cache.hpp"
+
+#include <QDebug>
+
+namespace rz {
+namespace controller {
+
+namespace {
+
+// Vergleich ohne frühen Abbruch (Token-Länge ist nicht geheim)
+bool tokenEquals(const std::string &a, const std::string &b) {
+  if (a.size() != b.size()) return false;
+  unsigned char diff = 0;
+  for (size_t i = 0; i < a.size(); ++i) diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+  return diff == 0;
+}
+
+void registerCollectors(bool primary) {
+  auto &registry = rz::utils::MetricsRegistry::instance();
+
+  // --- Realtime ---
+  registry.addCollector([](rz::utils::MetricsWriter &w) {
+    auto sse = rz::service::EventHub::instance().stats();
+    w.gauge("cake_sse_subscribers", "Open SSE connections.", sse.subscribers);
+    w.gauge("cake_sse_topics", "SSE topics with subscribers.", sse.topics);
+    w.counter("cake_sse_published_total", "Events published to SSE topics.", sse.published);
+    w.counter("cake_sse_frames_delivered_total", "SSE frames written.", sse.framesDelivered);
+    w.counter("cake_sse_rejected_total", "SSE connections rejected (limit).", sse.rejected);
+    w.counter("cake_sse_resyncs_total", "SSE reconnects that needed a RESYNC.", sse.resyncs);
+    w.counter("cake_sse_replayed_frames_total", "SSE frames replayed after a reconnect.",
+              sse.replayedFrames);
+    w.counter("cake_sse_flushes_total", "SSE responses completed.", sse.flushes);
+    w.counter("cake_sse_overflow_flushes_total", "SSE responses completed on a full buffer.",
+              sse.overflowFlushes);
+    w.counter("cake_sse_heartbeats_total", "SSE heartbeats sent.", sse.heartbeats);
+    w.gauge("cake_sse_last_event_id", "Newest SSE event id.", sse.lastEventId);
+
+    auto ws = rz::service::WsHub::instance().stats();
+    w.gauge("cake_ws_connections", "Open WebSocket connections.", ws.connections);
+    w.gauge("cake_ws_topics", "WebSocket topics with connections.", ws.topics);
+    w.gauge("cake_ws_inbox", "Messages waiting for the WebSocket broadcaster.", ws.inbox);
+    w.counter("cake_ws_published_total", "Messages published to WebSocket topics.",
+              ws.published);
+    w.counter("cake_ws_frames_queued_total", "WebSocket frames queued.", ws.framesQueued);
+    w.counter("cake_ws_frames_sent_total", "WebSocket frames sent.", ws.framesSent);
+    w.counter("cake_ws_coalesced_total", "WebSocket frames merged before sending.", ws.coalesced);
+    w.counter("cake_ws_overflows_total", "WebSocket send queue overflows.", ws.overflows);
+    w.counter("cake_ws_rejected_total", "WebSocket connections or messages rejected (limit).",
+              ws.rejected);
+    w.counter("cake_ws_client_messages_total", "Messages received from WebSocket clients.",
+              ws.clientMessages);
+  });
+
+  // --- Caches ---
+  registry.addCollector([](rz::utils::MetricsWriter &w) {
+    const std::string help = "Cache lookups by cache and result.";
+    auto &tokens = rz::utils::TokenCache::instance();
+    w.counter("cake_cache_lookups_total", help, tokens.hits(),
+              {{"cache", "token"}, {"result", "hit"}});
+    w.counter("cake_cache_lookups_total", help, tokens.misses(),
+              {{"cache", "token"}, {"result", "miss"}});
+    auto &auth = rz::utils::AuthContextCache::instance();
+    w.counter("cake_cache_lookups_total", help, auth.hits(),
+              {{"cache", "auth_context"}, {"result", "hit"}});
+    w.counter("cake_cache_lookups_total", help, auth.misses(),
+              {{"cache", "auth_context"}, {"result", "miss"}});
+
+    auto gz = rz::utils::ResponseCompressor::instance().stats();
+    w.counter("cake_cache_lookups_total", help, gz.cacheHits,
+              {{"cache", "compression"}, {"result", "hit"}});
+    w.counter("cake_cache_lookups_total", help, gz.eligible - gz.cacheHits,
+              {{"cache", "compression"}, {"result", "miss"}});
+    w.counter("cake_compression_bytes_in_total", "Bytes before compression.", gz.bytesIn);
+    w.counter("cake_compression_bytes_out_total", "Bytes after compression.", gz.bytesOut);
+    w.counter("cake_compression_cpu_seconds_total", "CPU time spent compressing.",
+              gz.cpuUs / 1e6);
+    const std::string gzHelp = "Compressible responses by outcome.";
+    w.counter("cake_compression_responses_total", gzHelp, gz.compressed,
+              {{"result", "compressed"}});
+    w.counter("cake_compression_responses_total", gzHelp, gz.skippedSmall,
+              {{"result", "too_small"}});
+    w.counter("cake_compression_responses_total", gzHelp, gz.skippedNotWorth,
+              {{"result", "not_worth"}});
+    w.gauge("cake_compression_cache_bytes", "Bytes held by the compression cache.",
+            gz.cacheBytes);
+    w.gauge("cake_compression_cache_entries", "Entries in the compression cache.",
+            gz.cacheEntries);
+  });
+
+  // --- Pools, Hashing, Rate-Limit, ChangeBus ---
+  registry.addCollector([](rz::utils::MetricsWriter &w) {
+    for (const auto &s : rz::service::Executors::instance().stats()) {
+      rz::utils::MetricLabels pool{{"pool", s.name}};
+      w.gauge("cake_pool_workers", "Threads of an executor pool.", s.workers, pool);
+      w.gauge("cake_pool_queued", "Tasks waiting in an executor pool.", s.queued, pool);
+      w.gauge("cake_pool_active", "Tasks running in an executor pool.", s.active, pool);
+      w.counter("cake_pool_completed_total", "Tasks finished by an executor pool.", s.completed,
+                pool);
+      w.counter("cake_pool_rejected_total", "Tasks rejected by a full pool.", s.rejected, pool);
+      w.counter("cake_pool_stolen_total", "Tasks taken by work stealing.", s.stolen, pool);
+      // Summen: rate(wait) / rate(completed) ergibt die mittlere Wartezeit im Fenster
+      w.counter("cake_pool_wait_seconds_total", "Total queue wait of finished tasks.",
+                s.waitSecondsTotal, pool);
+      w.counter("cake_pool_run_seconds_total", "Total run time of finished tasks.",
+                s.runSecondsTotal, pool);
+    }
+    w.gauge("cake_http_threads", "Crow io threads.",
+            rz::service::Executors::instance().httpThreads());
+
+    auto hash = rz::service::HashExecutor::instance().stats();
+    w.gauge("cake_hash_workers", "Argon2 jobs allowed at the same time.", hash.workers);
+    w.gauge("cake_hash_queued", "Argon2 jobs waiting for a slot.", hash.queued);
+    w.gauge("cake_hash_active", "Argon2 jobs running.", hash.active);
+    w.counter("cake_hash_completed_total", "Argon2 jobs finished.", hash.completed);
+    w.counter("cake_hash_rejected_total", "Argon2 jobs rejected (queue full).", hash.rejected);
+
+    auto &limits = rz::utils::AuthRateLimiter::instance();
+    auto ip = limits.byIp().stats();
+    auto email = limits.byEmail().stats();
+    const std::string help = "Auth rate limiter decisions.";
+    w.counter("cake_ratelimit_total", help, ip.allowed, {{"key", "ip"}, {"result", "allowed"}});
+    w.counter("cake_ratelimit_total", help, ip.limited, {{"key", "ip"}, {"result", "limited"}});
+    w.counter("cake_ratelimit_total", help, email.allowed,
+              {{"key", "email"}, {"result", "allowed"}});
+    w.counter("cake_ratelimit_total", help, email.limited,
+              {{"key", "email"}, {"result", "limited"}});
+    w.gauge("cake_ratelimit_buckets", "Tracked rate limit buckets.", ip.buckets,
+            {{"key", "ip"}});
+    w.gauge("cake_ratelimit_buckets", "Tracked rate limit buckets.", email.buckets,
+            {{"key", "email"}});
+    w.counter("cake_ratelimit_evicted_total", "Idle rate limit buckets evicted.", ip.evicted,
+              {{"key", "ip"}});
+    w.counter("cake_ratelimit_evicted_total", "Idle rate limit buckets evicted.", email.evicted,
+              {{"key", "email"}});
+
+    auto bus = rz::service::ChangeBus::instance().stats();
+    if (bus.shared) {
+      w.counter("cake_change_bus_written_total", "Changes written to the shared log.",
+                bus.written);
+      w.counter("cake_change_bus_applied_total", "Changes of other workers applied.",
+                bus.applied);
+      w.counter("cake_change_bus_dropped_total", "Changes dropped (queue full, DB error).",
+                bus.dropped);
+      w.counter("cake_change_bus_resyncs_total",
+                "Gaps in the change log (purged before read) that forced a resync.", bus.resyncs);
+      w.gauge("cake_change_bus_pending", "Changes waiting to be written.", bus.pending);
+      w.gauge("cake_change_bus_last_seq", "Newest change_log seq applied.", bus.lastSeq);
+    }
+  });
+
+  // --- Mail-Queue (nur der Worker mit der Pipeline; fragt die DB ab) ---
+  if (primary) {
+    registry.addCollector([](rz::utils::MetricsWriter &w) {
+      auto queue = OutboxMessage::stats();
+      auto sched = rz::service::SendScheduler::instance().stats();
+      const char *names[OutboxMessage::PRIORITY_COUNT] = {"high", "normal", "bulk"};
+      for (int p = 0; p < OutboxMessage::PRIORITY_COUNT; ++p) {
+        rz::utils::MetricLabels prio{{"priority", names[p]}};
+        w.gauge("cake_mail_queue_depth", "Outbox messages waiting to be sent.",
+                queue.pendingByPriority[p], prio);
+        w.gauge("cake_mail_queue_oldest_seconds", "Age of the oldest waiting message.",
+                queue.oldestAgeSecByPriority[p], prio);
+        w.counter("cake_mail_scheduled_sent_total", "Messages handed to SMTP.",
+                  sched.sentByPriority[p], prio);
+      }
+      w.gauge("cake_mail_sending", "Outbox messages currently being sent.", queue.sending);
+      w.counter("cake_mail_throttled_total", "Sends delayed by the rate limits.",
+                sched.throttledGlobal, {{"scope", "global"}});
+      w.counter("cake_mail_throttled_total", "Sends delayed by the rate limits.",
+                sched.throttledDomain, {{"scope", "domain"}});
+      w.gauge("cake_mail_global_tokens", "Tokens left in the global send bucket.",
+              sched.globalTokens);
+      w.gauge("cake_mail_domain_buckets", "Tracked per-domain send buckets.",
+              sched.domainBuckets);
+    });
+  }
+}
+
+} // namespace
+
+void MetricsController::registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app) {
+  const std::string token = rz::utils::EnvLoader::get("CAKE_METRICS_TOKEN", "").toStdString();
+  if (token.empty()) {
+    qInfo() << "[Metrics] /metrics deaktiviert (CAKE_METRICS_TOKEN nicht gesetzt)";
+  }
+
+  const int workerIndex = rz::service::Supervisor::workerIndex();
+  if (workerIndex >= 0) {
+    rz::utils::MetricsRegistry::instance().setConstLabel("worker", std::to_string(workerIndex));
+  }
+  registerCollectors(workerIndex <= 0);
+
+  // --- GET /metrics ---
+  CROW_ROUTE(app, "/metrics")
+  ([token](const crow::request &req) {
+    if (token.empty()) return crow::response(404);
+
+    std::string auth = req.get_header_value("Authorization");
+    if (!auth.starts_with("Bearer ") || !tokenEquals(auth.substr(7), token)) {
+      return crow::response(401);
+    }
+
+    crow::response res(200, rz::utils::MetricsRegistry::instance().render());
+    res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    res.set_header("Cache-Control", "no-store");
+    return res;
+  });
+}
+
+} // namespace controller
+} // namespace rz
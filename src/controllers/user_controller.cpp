@@ -2,8 +2,8 @@
  * @file user_controller.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.4.0
- * @date 2026-01-01
+ * @version 0.13.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,38 +12,43 @@
 
 
 #include "controllers/user_controller.hpp"
+#include "models/digest_model.hpp"
+#include "models/session_model.hpp"
 #include "models/user_model.hpp"
+#include "services/async.hpp"
+#include "services/change_bus.hpp"
 #include "utils/password_utils.hpp"
+#include "utils/request_trace.hpp"
 #include "utils/token_utils.hpp"
 
 namespace rz {
 namespace controller {
 
 // WICHTIG: Signatur muss rz::middleware::AuthMiddleware enthalten
-void UserController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &app) {
+void UserController::registerRoutes(crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> &app) {
 
   // --- GET /api/users ---
   CROW_ROUTE(app, "/api/users")
   ([&](const crow::request &req) {
     const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
 
-    if (ctx.currentUser.userId.isEmpty())
+    if (!ctx.auth)
       return crow::response(401);
 
     std::vector<User> users;
 
-    if (ctx.currentUser.isAdmin) {
+    if (ctx.auth->isAdmin) {
       users = User::getAll();
     } else {
-      auto info = User::getGroupAndRole(ctx.currentUser.userId);
-      QString myGroupId = info.first;
-      QString myRole = info.second;
-
-      if (myRole == "admin" && !myGroupId.isEmpty()) {
-        users = User::getAll(myGroupId);
-      } else {
+      // Gruppen-Admins sehen die Mitglieder ihrer Gruppe(n)
+      auto adminGroups = ctx.auth->adminGroupIds();
+      if (adminGroups.empty()) {
         return crow::response(403, "Forbidden: Insufficient rights.");
       }
+      for (const auto &gid : adminGroups) {
+        auto members = User::getAll(gid);
+        users.insert(users.end(), members.begin(), members.end());
+      }
     }
 
     crow::json::wvalue result = crow::json::wvalue::list();
@@ -56,76 +61,126 @@ void UserController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &a
 
   // --- POST /api/register ---
   CROW_ROUTE(app, "/api/register")
-      .methods(crow::HTTPMethod::POST)([](const crow::request &req) {
+      .methods(crow::HTTPMethod::POST)([](const crow::request &req, crow::response &res) {
         auto json = crow::json::load(req.body);
         if (!json || !json.has("email") || !json.has("password") || !json.has("name")) {
-          return crow::response(400, "Missing fields");
-        }
-
-        QString email = QString::fromStdString(json["email"].s());
-        QString plainPassword = QString::fromStdString(json["password"].s());
-        QString name = QString::fromStdString(json["name"].s());
-
-        if (User::getByEmail(email).has_value()) {
-          return crow::response(409, "User already exists");
+          res = crow::response(400, "Missing fields");
+          res.end();
+          return;
         }
 
         User newUser;
-        newUser.full_name = name;
-        newUser.email = email;
-
-        // Namespace rz::utils nutzen!
-        newUser.password_hash = rz::utils::PasswordUtils::hashPassword(plainPassword);
-
-        if (newUser.password_hash.isEmpty()) return crow::response(500, "Hashing failed");
-
+        newUser.full_name = QString::fromStdString(json["name"].s());
+        newUser.email = QString::fromStdString(json["email"].s());
         newUser.is_active = false;
         newUser.is_admin = false;
+        QString plainPassword = QString::fromStdString(json["password"].s());
 
-        if (newUser.create()) {
-          crow::json::wvalue resJson;
-          resJson["message"] = "Registration successful.";
-          resJson["userId"] = newUser.id.toStdString();
-          return crow::response(201, resJson);
-        } else {
-          return crow::response(500, "Database error");
-        }
+        // Trace explizit mitgeben: die Coroutine wechselt den Thread
+        rz::service::respond(req, res,
+            [](User newUser, QString plainPassword,
+               rz::utils::RequestTrace *trace) -> rz::service::Task<crow::response> {
+              bool exists;
+              {
+                rz::utils::TraceScope scope(trace, "db");
+                exists = (co_await User::getByEmailAsync(newUser.email)).has_value();
+              }
+              if (exists) co_return crow::response(409, "User already exists");
+
+              // Hashing im begrenzten Argon2-Slot, nicht auf dem Crow-Worker
+              {
+                rz::utils::TraceScope scope(trace, "hash");
+                newUser.password_hash =
+                    co_await rz::utils::PasswordUtils::hashPasswordAsync(plainPassword);
+              }
+              if (newUser.password_hash.isEmpty()) co_return crow::response(500, "Hashing failed");
+
+              bool created;
+              {
+                rz::utils::TraceScope scope(trace, "db");
+                created = co_await rz::service::runOn(rz::service::Executors::Pool::DbWrite,
+                                                      [&newUser]() { return newUser.create(); });
+              }
+              if (!created) co_return crow::response(500, "Database error");
+
+              crow::json::wvalue resJson;
+              resJson["message"] = "Registration successful.";
+              resJson["userId"] = newUser.id.toStdString();
+              co_return crow::response(201, resJson);
+            }(std::move(newUser), plainPassword, rz::utils::RequestTrace::current()));
       });
 
   // --- POST /api/user/change-password ---
   CROW_ROUTE(app, "/api/user/change-password")
-      .methods(crow::HTTPMethod::POST)([&](const crow::request &req) {
+      .methods(crow::HTTPMethod::POST)([&](const crow::request &req, crow::response &res) {
         const auto &ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
-        if (ctx.currentUser.userId.isEmpty()) return crow::response(401);
+        auto fail = [&res](int code, const char *message = "") {
+          res = crow::response(code, message);
+          res.end();
+        };
+        if (ctx.currentUser.userId.isEmpty()) return fail(401);
 
         auto json = crow::json::load(req.body);
-        if (!json || !json.has("newPassword")) return crow::response(400);
+        if (!json || !json.has("newPassword")) return fail(400);
 
         std::string newPassRaw = json["newPassword"].s();
-        if (newPassRaw.length() < 8) return crow::response(400, "Min 8 chars");
-
-        QString newHash = rz::utils::PasswordUtils::hashPassword(QString::fromStdString(newPassRaw));
-        if (newHash.isEmpty()) return crow::response(500);
-
-        if (User::updatePassword(ctx.currentUser.userId, newHash)) {
-          return crow::response(200, "Password changed");
-        }
-        return crow::response(500, "DB Error");
+        if (newPassRaw.length() < 8) return fail(400, "Min 8 chars");
+
+        rz::service::respond(req, res,
+            [](QString userId, QString sessionId, QString newPass,
+               rz::utils::RequestTrace *trace) -> rz::service::Task<crow::response> {
+              QString newHash;
+              {
+                rz::utils::TraceScope scope(trace, "hash");
+                newHash = co_await rz::utils::PasswordUtils::hashPasswordAsync(newPass);
+              }
+              if (newHash.isEmpty()) co_return crow::response(500);
+
+              rz::utils::TraceScope scope(trace, "db");
+              bool updated = co_await rz::service::runOn(
+                  rz::service::Executors::Pool::DbWrite, [&userId, &sessionId, &newHash]() {
+                    if (!User::updatePassword(userId, newHash)) return false;
+                    // Alle anderen Geräte abmelden (evtl. mit dem alten Passwort angemeldet)
+                    for (const auto &sid : Session::revokeAllForUser(userId, sessionId)) {
+                      rz::service::ChangeBus::instance().revokeSession(sid);
+                    }
+                    return true;
+                  });
+              if (updated) co_return crow::response(200, "Password changed");
+              co_return crow::response(500, "DB Error");
+            }(ctx.currentUser.userId, ctx.currentUser.sessionId,
+              QString::fromStdString(newPassRaw), rz::utils::RequestTrace::current()));
       });
 
-    // Profil-Update (Sprache)
+    // Profil-Update (Sprache, Benachrichtigungen)
     CROW_ROUTE(app, "/api/user/settings")
     .methods(crow::HTTPMethod::POST)
     ([&](const crow::request& req){
         const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
         auto json = crow::json::load(req.body);
-        if (!json) return crow::response(400);
+        if (!json || (!json.has("language") && !json.has("notifyNewEvents") && !json.has("notifyDigest"))) {
+            return crow::response(400);
+        }
 
-        std::string lang = json["language"].s();
-        if (User::updateSettings(ctx.currentUser.userId, QString::fromStdString(lang))) {
-            return crow::response(200);
+        // immediate | hourly | daily
+        QString digestMode;
+        if (json.has("notifyDigest")) {
+            digestMode = QString::fromStdString(json["notifyDigest"].s());
+            if (!DigestItem::isValidMode(digestMode)) return crow::response(400, "Invalid digest mode");
         }
-        return crow::response(500);
+
+        bool ok = true;
+        if (json.has("language")) {
+            std::string lang = json["language"].s();
+            ok = User::updateSettings(ctx.currentUser.userId, QString::fromStdString(lang));
+        }
+        if (ok && json.has("notifyNewEvents")) {
+            ok = User::updateNotificationPrefs(ctx.currentUser.userId, json["notifyNewEvents"].b());
+        }
+        if (ok && json.has("notifyDigest")) {
+            ok = User::updateDigestMode(ctx.currentUser.userId, digestMode);
+        }
+        return crow::response(ok ? 200 : 500);
     });
 
     // Account Löschen
@@ -134,6 +189,10 @@ void UserController::registerRoutes(crow::App<rz::middleware::AuthMiddleware> &a
     ([&](const crow::request& req){
         const auto& ctx = app.get_context<rz::middleware::AuthMiddleware>(req);
         if (User::softDelete(ctx.currentUser.userId)) {
+            // Alle Geräte abmelden
+            for (const auto& sid : Session::revokeAllForUser(ctx.currentUser.userId)) {
+                rz::service::ChangeBus::instance().revokeSession(sid);
+            }
             return crow::response(200, "Account deleted");
         }
         return crow::response(500);
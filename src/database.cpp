@@ -2,8 +2,8 @@
  * @file database.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief No description provided
- * @version 0.3.0
- * @date 2026-01-03
+ * @version 0.14.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2026 ZHENG Robert
  *
@@ -11,6 +11,7 @@
  */
 
 #include "database.hpp"
+#include "utils/metrics.hpp"
 
 #include <QDebug>
 #include <QDir>
@@ -47,15 +48,67 @@ void DatabaseManager::initialize(const QString &path) {
   qInfo() << "Datenbank-Pfad gesetzt auf:" << m_dbPath;
 }
 
+QString DatabaseManager::connectionName() {
+  return QString("db_conn_%1")
+      .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+namespace {
+
+// Verbindungs-Metriken (einmal registriert, danach nur atomare Adds)
+struct DbMetrics {
+  rz::utils::Counter &reused;
+  rz::utils::Counter &opened;
+  rz::utils::Counter &failed;
+  rz::utils::Gauge &open;
+  rz::utils::Histogram &openSeconds;
+};
+
+DbMetrics &dbMetrics() {
+  auto &registry = rz::utils::MetricsRegistry::instance();
+  static const char *help = "DatabaseManager::getDatabase() calls by result.";
+  static DbMetrics metrics{
+      registry.counter("cake_db_connection_acquire_total", help, {{"result", "reused"}}),
+      registry.counter("cake_db_connection_acquire_total", help, {{"result", "opened"}}),
+      registry.counter("cake_db_connection_acquire_total", help, {{"result", "failed"}}),
+      registry.gauge("cake_db_connections_open", "Open per-thread SQLite connections."),
+      registry.histogram("cake_db_connection_open_seconds",
+                         "Time to open a SQLite connection incl. PRAGMAs."),
+  };
+  return metrics;
+}
+
+// Öffnen inkl. PRAGMAs (gelten pro Verbindung, also auch beim Wiederöffnen)
+bool openWithPragmas(QSqlDatabase &db) {
+  auto &metrics = dbMetrics();
+  auto started = std::chrono::steady_clock::now();
+  if (!db.open()) {
+    metrics.failed.inc();
+    return false;
+  }
+  QSqlQuery query(db);
+  query.exec("PRAGMA journal_mode = WAL;");
+  query.exec("PRAGMA synchronous = NORMAL;");
+  query.exec("PRAGMA foreign_keys = ON;");
+  metrics.opened.inc();
+  // Jedes (Wieder-)Öffnen zählt, closeConnection() zieht wieder ab
+  metrics.open.add(1);
+  metrics.openSeconds.observeSince<std::chrono::steady_clock>(started);
+  return true;
+}
+
+} // namespace
+
 QSqlDatabase DatabaseManager::getDatabase() {
-  QString connectionName =
-      QString("db_conn_%1")
-          .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+  QString connectionName = DatabaseManager::connectionName();
 
   if (QSqlDatabase::contains(connectionName)) {
-    auto db = QSqlDatabase::database(connectionName);
-    if (db.isOpen()) return db;
-    if (!db.open()) {
+    auto db = QSqlDatabase::database(connectionName, false);
+    if (db.isOpen()) {
+      dbMetrics().reused.inc();
+      return db;
+    }
+    if (!openWithPragmas(db)) {
       qCritical() << "Kritischer Fehler: Konnte existierende Verbindung nicht öffnen:" << connectionName;
     }
     return db;
@@ -64,21 +117,46 @@ QSqlDatabase DatabaseManager::getDatabase() {
   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
   db.setDatabaseName(m_dbPath);
 
-  if (!db.open()) {
+  if (!openWithPragmas(db)) {
     qCritical() << "Fehler beim Öffnen der DB in Thread" << connectionName
                 << ":" << db.lastError().text();
-  } else {
-    QSqlQuery query(db);
-    query.exec("PRAGMA journal_mode = WAL;");
-    query.exec("PRAGMA synchronous = NORMAL;");
-    query.exec("PRAGMA foreign_keys = ON;");
   }
 
   return db;
 }
 
+void DatabaseManager::closeConnection() {
+  QString name = connectionName();
+  {
+    QSqlDatabase db = QSqlDatabase::database(name, false);
+    if (db.isOpen()) {
+      db.close();
+      dbMetrics().open.add(-1);
+    }
+  }
+  QSqlDatabase::removeDatabase(name);
+}
+
 DatabaseManager::~DatabaseManager() {}
 
+bool DatabaseManager::ensureColumn(QSqlDatabase &db, const QString &table,
+                                   const QString &column,
+                                   const QString &definition) {
+  QSqlQuery query(db);
+  if (!query.exec(QString("PRAGMA table_info(%1)").arg(table))) return false;
+  while (query.next()) {
+    if (query.value("name").toString() == column) return true;
+  }
+
+  qInfo() << "Migration: Füge Spalte" << column << "zu" << table << "hinzu";
+  if (!query.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, definition))) {
+    qCritical() << "Migration Fehler bei ALTER TABLE" << table << ":"
+                << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
 bool DatabaseManager::migrate() {
   auto db = getDatabase();
 
@@ -93,6 +171,8 @@ bool DatabaseManager::migrate() {
             is_active INTEGER DEFAULT 0,
             is_admin INTEGER DEFAULT 0,
             must_change_password INTEGER DEFAULT 0,
+            notify_new_events INTEGER DEFAULT 1,
+            notify_digest TEXT DEFAULT 'immediate',
             created_at TEXT DEFAULT CURRENT_TIMESTAMP,
             updated_at TEXT DEFAULT CURRENT_TIMESTAMP
         );
@@ -143,15 +223,83 @@ bool DatabaseManager::migrate() {
             user_id TEXT NOT NULL,
             photo_path TEXT NOT NULL,
             uploaded_at TEXT DEFAULT CURRENT_TIMESTAMP,
+            size_bytes INTEGER,
             PRIMARY KEY (event_id, user_id),
             FOREIGN KEY (event_id) REFERENCES events(id) ON DELETE CASCADE,
             FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
         );
 
+        CREATE TABLE IF NOT EXISTS sessions (
+            id TEXT PRIMARY KEY,
+            user_id TEXT NOT NULL,
+            refresh_hash TEXT UNIQUE NOT NULL,
+            device TEXT,
+            ip_address TEXT,
+            created_at TEXT DEFAULT CURRENT_TIMESTAMP,
+            last_used_at TEXT DEFAULT CURRENT_TIMESTAMP,
+            expires_at INTEGER NOT NULL,
+            revoked INTEGER DEFAULT 0,
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+
+        CREATE TABLE IF NOT EXISTS email_outbox (
+            id TEXT PRIMARY KEY,
+            recipient TEXT NOT NULL,
+            subject TEXT NOT NULL,
+            body TEXT NOT NULL,
+            html_body TEXT,
+            status TEXT NOT NULL DEFAULT 'pending',
+            priority INTEGER DEFAULT 1,
+            fairness_key TEXT,
+            attempts INTEGER DEFAULT 0,
+            next_attempt_at INTEGER NOT NULL,
+            last_error TEXT,
+            created_at INTEGER NOT NULL,
+            sent_at INTEGER
+        );
+
+        CREATE TABLE IF NOT EXISTS notification_jobs (
+            id TEXT PRIMARY KEY,
+            kind TEXT NOT NULL,
+            payload TEXT NOT NULL,
+            status TEXT NOT NULL DEFAULT 'pending',
+            attempts INTEGER DEFAULT 0,
+            next_attempt_at INTEGER NOT NULL,
+            last_error TEXT,
+            created_at INTEGER NOT NULL,
+            done_at INTEGER
+        );
+
+        CREATE TABLE IF NOT EXISTS digest_items (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            recipient TEXT NOT NULL,
+            language TEXT NOT NULL,
+            kind TEXT NOT NULL,
+            reference TEXT NOT NULL,
+            line TEXT NOT NULL,
+            due_at INTEGER NOT NULL,
+            created_at INTEGER NOT NULL,
+            UNIQUE(recipient, kind, reference)
+        );
+
+        CREATE TABLE IF NOT EXISTS change_log (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            origin INTEGER NOT NULL,
+            kind INTEGER NOT NULL,
+            topic TEXT,
+            key TEXT,
+            payload TEXT,
+            created_at INTEGER NOT NULL
+        );
+
         -- INDIZES für Performance
         CREATE INDEX IF NOT EXISTS idx_ratings_event_id ON ratings(event_id);
         CREATE INDEX IF NOT EXISTS idx_event_photos_event_id ON event_photos(event_id);
         CREATE INDEX IF NOT EXISTS idx_events_group_date ON events(group_id, event_date);
+        CREATE INDEX IF NOT EXISTS idx_sessions_user_id ON sessions(user_id);
+        CREATE INDEX IF NOT EXISTS idx_outbox_status_next ON email_outbox(status, next_attempt_at);
+        CREATE INDEX IF NOT EXISTS idx_notification_jobs_status_next ON notification_jobs(status, next_attempt_at);
+        CREATE INDEX IF NOT EXISTS idx_digest_items_due ON digest_items(recipient, due_at);
     )";
 
   QStringList statements = schemaSql.split(';', Qt::SkipEmptyParts);
@@ -171,6 +319,47 @@ bool DatabaseManager::migrate() {
     }
   }
 
+  // Spalten, die nach dem ersten Release hinzugekommen sind
+  if (success) {
+    success = ensureColumn(db, "users", "notify_new_events", "INTEGER DEFAULT 1") &&
+              ensureColumn(db, "users", "notify_digest", "TEXT DEFAULT 'immediate'") &&
+              ensureColumn(db, "email_outbox", "html_body", "TEXT") &&
+              ensureColumn(db, "email_outbox", "priority", "INTEGER DEFAULT 1") &&
+              ensureColumn(db, "email_outbox", "fairness_key", "TEXT") &&
+              ensureColumn(db, "sessions", "prev_refresh_hash", "TEXT") &&
+              ensureColumn(db, "event_photos", "size_bytes", "INTEGER");
+  }
+
+  // Indizes auf nachträglich hinzugefügten Spalten erst nach ensureColumn
+  if (success &&
+      !query.exec("CREATE INDEX IF NOT EXISTS idx_outbox_due ON email_outbox(status, priority, next_attempt_at)")) {
+    qCritical() << "Migration Fehler bei idx_outbox_due:" << query.lastError().text();
+    success = false;
+  }
+  if (success &&
+      !query.exec("CREATE INDEX IF NOT EXISTS idx_sessions_prev_hash ON sessions(prev_refresh_hash)")) {
+    qCritical() << "Migration Fehler bei idx_sessions_prev_hash:" << query.lastError().text();
+    success = false;
+  }
+
+  // Fotos von vor size_bytes einmalig von der Platte nachtragen (fehlende Datei = 0)
+  if (success && query.exec("SELECT event_id, user_id, photo_path FROM event_photos "
+                            "WHERE size_bytes IS NULL")) {
+    QDir uploads("data/uploads");
+    QSqlQuery update(db);
+    update.prepare("UPDATE event_photos SET size_bytes = :size "
+                   "WHERE event_id = :eid AND user_id = :uid");
+    while (success && query.next()) {
+      update.bindValue(":size", QFileInfo(uploads.filePath(query.value(2).toString())).size());
+      update.bindValue(":eid", query.value(0));
+      update.bindValue(":uid", query.value(1));
+      if (!update.exec()) {
+        qCritical() << "Migration Fehler bei event_photos.size_bytes:" << update.lastError().text();
+        success = false;
+      }
+    }
+  }
+
   if (success) {
     db.commit();
     qInfo() << "Datenbank-Migration erfolgreich abgeschlossen.";
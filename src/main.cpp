@@ -2,8 +2,8 @@
  * @file main.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Entry Point
- * @version 0.3.5
- * @date 2026-01-03
+ * @version 0.19.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -14,25 +14,51 @@
 #include "database.hpp"
 #include "rz_config.hpp"
 #include "utils/env_loader.hpp"
+#include "models/session_model.hpp"
+#include "utils/auth_context_cache.hpp"
+#include "utils/mail_templates.hpp"
+#include "utils/password_utils.hpp"
+#include "utils/rate_limiter.hpp"
+#include "utils/request_trace.hpp"
+#include "utils/response_compressor.hpp"
+#include "utils/reuse_port.hpp"
+#include "utils/revocation_list.hpp"
 #include "utils/seeder.hpp"
+#include "utils/token_cache.hpp"
+#include "utils/token_utils.hpp"
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QTextStream>
+#include <algorithm>
 #include <thread> // Wichtig für Server-Thread
 
 // Middleware & Controller Includes
 #include "controllers/admin_controller.hpp"
 #include "controllers/auth_controller.hpp"
 #include "controllers/event_controller.hpp"
+#include "controllers/metrics_controller.hpp"
 #include "controllers/user_controller.hpp"
 #include "middleware/auth_middleware.hpp"
+#include "middleware/compression_middleware.hpp"
 
 // SMTP & Models
 #include "models/config_model.hpp" // Achte auf Groß/Kleinschreibung im Dateinamen!
+#include "services/change_bus.hpp"
+#include "services/event_hub.hpp"
+#include "services/executors.hpp"
+#include "services/hash_executor.hpp"
 #include "services/smtp_service.hpp"
 #include "services/notification_service.hpp"
+#include "services/notification_worker.hpp"
+#include "services/outbox_dispatcher.hpp"
+#include "services/supervisor.hpp"
+#include "services/ws_hub.hpp"
 
 int main(int argc, char *argv[]) {
+  // Prefork-Worker: vom Supervisor als eigener Prozess gestartet (fork + exec)
+  const int workerIndex = rz::service::Supervisor::workerIndex();
+
   // 1. Qt Core Application (Startet die Event-Loop für SMTP)
   QCoreApplication qtApp(argc, argv);
 
@@ -43,23 +69,101 @@ int main(int argc, char *argv[]) {
   rz::utils::EnvLoader::load("CakePlanner.env");
   int serverPort = rz::utils::EnvLoader::getInt("CAKE_SERVER_PORT", 8080);
 
-  // 3. Datenbank
+  // CLI: Argon2-Parameter für diesen Host ermitteln und beenden
+  if (QCoreApplication::arguments().contains("--calibrate-argon2")) {
+    auto params = rz::utils::PasswordUtils::calibrate(
+        rz::utils::EnvLoader::getInt("CAKE_ARGON2_TARGET_MS", 250),
+        rz::utils::EnvLoader::getInt("CAKE_ARGON2_MAX_MEMORY_KIB", 65536),
+        rz::utils::EnvLoader::getInt("CAKE_ARGON2_P", 4));
+    QTextStream out(stdout);
+    out << "CAKE_ARGON2_T=" << params.timeCost << "\n"
+        << "CAKE_ARGON2_M_KIB=" << params.memoryCostKiB << "\n"
+        << "CAKE_ARGON2_P=" << params.parallelism << "\n";
+    return 0;
+  }
+  rz::utils::PasswordUtils::configureFromEnv();
+
+  // 3. Datenbank (Migration und Seed nur einmal: Single-Process oder Supervisor)
   DatabaseManager::instance().initialize("data/cakeplanner.sqlite");
-  if (!DatabaseManager::instance().migrate()) {
-    qCritical() << "Abbruch: Datenbank-Migration fehlgeschlagen.";
+  if (workerIndex < 0) {
+    if (!DatabaseManager::instance().migrate()) {
+      qCritical() << "Abbruch: Datenbank-Migration fehlgeschlagen.";
+      return -1;
+    }
+    rz::utils::Seeder::ensureAdminExists();
+
+    // Prefork (CAKE_WORKERS > 1): N Prozesse teilen sich Port (SO_REUSEPORT)
+    // und WAL-Datenbank. Der Supervisor startet kein Thread und hält keine
+    // DB-Verbindung; die Worker beginnen wieder oben in main().
+    const int workers = std::max(1, rz::utils::EnvLoader::getInt("CAKE_WORKERS", 1));
+    if (workers > 1) {
+      // Einmal kalibrieren, alle Worker hashen mit denselben Parametern
+      rz::utils::PasswordUtils::exportToWorkers();
+      DatabaseManager::instance().closeConnection();
+      return rz::service::Supervisor::run(workers, argv);
+    }
+  } else if (!rz::utils::ReusePort::enable(serverPort)) {
+    qCritical() << "Abbruch: SO_REUSEPORT wird auf dieser Plattform nicht unterstützt.";
     return -1;
   }
-  rz::utils::Seeder::ensureAdminExists();
+  // Mail-Pipeline und Aufräumjobs nur einmal: Single-Process oder Worker 0
+  const bool primary = workerIndex <= 0;
+
+  // JWT Verifier einmalig aufbauen, Cache für verifizierte Tokens dimensionieren
+  rz::utils::TokenUtils::init();
+  rz::utils::TokenCache::instance().setCapacity(
+      rz::utils::EnvLoader::getInt("CAKE_TOKEN_CACHE_SIZE", 4096));
+  rz::utils::RevocationList::instance().load(
+      Session::getRevoked(rz::utils::TokenUtils::accessTokenTtl()));
+  rz::utils::AuthContextCache::instance().setTtl(
+      rz::utils::EnvLoader::getInt("CAKE_AUTH_CACHE_TTL_SEC", 300));
+  rz::utils::AuthRateLimiter::instance().configureFromEnv();
+  rz::service::EventHub::instance().configureFromEnv();
+  rz::service::WsHub::instance().configureFromEnv();
+  rz::utils::ResponseCompressor::instance().configureFromEnv();
+  rz::utils::TraceBuffer::instance().configureFromEnv();
+  rz::service::WsHub::instance().start();
+
+  // Benannte Pools (DB, CPU, Hintergrund); HTTP bleibt auf Crows io-Threads
+  rz::service::Executors::instance().start();
+
+  // Argon2 auf dem CPU-Pool, aber begrenzt (max. Worker x 64 MiB RAM)
+  rz::service::HashExecutor::instance().start(
+      rz::utils::EnvLoader::getInt("CAKE_HASH_WORKERS", 2),
+      rz::utils::EnvLoader::getInt("CAKE_HASH_QUEUE", 8));
 
   // 4. Services Setup (Dependency Injection)
   rz::model::ConfigModel configModel;
   configModel.loadEnv("CakePlanner.env");
 
+  // Mail-Vorlagen einmalig kompilieren (Reload über Admin-Endpoint)
+  rz::utils::MailTemplates::instance().setDefaultLanguage(
+      rz::utils::EnvLoader::get("CAKE_MAIL_DEFAULT_LANG", "en"));
+  rz::utils::MailTemplates::instance().load(
+      rz::utils::EnvLoader::get("CAKE_TEMPLATE_DIR", "templates"));
+
   rz::service::SmtpService smtpService(configModel, &qtApp);
-  rz::service::NotificationService notifyService(&smtpService);
+  rz::service::OutboxDispatcher outboxDispatcher(&smtpService, &qtApp);
+  rz::service::NotificationService notifyService(primary ? &outboxDispatcher : nullptr);
+  // Fan-out der Gruppen-Mails im Hintergrund (nicht im Request-Thread)
+  rz::service::NotificationWorker notifyWorker(&notifyService, &outboxDispatcher, &qtApp);
+  if (primary) {
+    outboxDispatcher.start();
+    notifyService.setWorker(&notifyWorker);
+    notifyWorker.start();
+  }
+
+  // Prefork: Cache-Invalidierung und Realtime über die gemeinsame change_log
+  if (workerIndex >= 0) {
+    if (primary) {
+      rz::service::ChangeBus::instance().setWakeHandler(
+          [&notifyService]() { notifyService.dispatch(); });
+    }
+    rz::service::ChangeBus::instance().start(primary);
+  }
 
   // 5. Crow App mit Middleware (Namespace beachten!)
-  crow::App<rz::middleware::AuthMiddleware> app;
+  crow::App<rz::middleware::CompressionMiddleware, rz::middleware::AuthMiddleware> app;
 
   // 6. Controller Registrierung
 
@@ -71,6 +175,7 @@ int main(int argc, char *argv[]) {
 rz::controller::UserController::registerRoutes(app);
 rz::controller::EventController::registerRoutes(app, &notifyService);
   rz::controller::AdminController::registerRoutes(app);
+  rz::controller::MetricsController::registerRoutes(app);
 
   // Test-Route
   CROW_ROUTE(app, "/api/profile")
@@ -82,15 +187,27 @@ rz::controller::EventController::registerRoutes(app, &notifyService);
     return result;
   });
 
-  qInfo() << "Server lauscht auf Port:" << serverPort;
+  if (workerIndex >= 0) {
+    qInfo() << "Worker" << workerIndex << "lauscht auf Port:" << serverPort;
+  } else {
+    qInfo() << "Server lauscht auf Port:" << serverPort;
+  }
 
   // Crow in eigenem Thread starten, damit Qt-Loop (für Mail) weiterläuft
   std::thread serverThread([&app, serverPort](){
-    // Erhöhe Threads auf z.B. 20
-    // app.port(serverPort).concurrency(20).run();
-    app.port(serverPort).multithreaded().run();
+    // Anzahl io-Threads über CAKE_HTTP_THREADS (Default: Kerne / CAKE_WORKERS)
+    app.port(serverPort).concurrency(rz::service::Executors::instance().httpThreads()).run();
+    // Crow beendet (SIGINT/SIGTERM oder Port belegt): auch die Qt-Loop verlassen
+    QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit,
+                              Qt::QueuedConnection);
   });
 
   // Qt Event Loop starten
-  return qtApp.exec();
+  int exitCode = qtApp.exec();
+  app.stop();
+  serverThread.join();
+  rz::service::ChangeBus::instance().stop();
+  // Pools leeren, solange NotificationWorker & Co. noch leben
+  rz::service::Executors::instance().stop();
+  return exitCode;
 }
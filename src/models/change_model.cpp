@@ -0,0 +1,104 @@
+/**
+ * @file change_model.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Shared change sequence for prefork worker processes
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "models/change_model.hpp"
+#include "database.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+bool ChangeEntry::appendBatch(const std::vector<ChangeEntry> &entries) {
+  if (entries.empty()) return true;
+  auto db = DatabaseManager::instance().getDatabase();
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+
+  db.transaction();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        INSERT INTO change_log (origin, kind, topic, key, payload, created_at)
+        VALUES (:origin, :kind, :topic, :key, :payload, :now)
+    )");
+  for (const auto &entry : entries) {
+    query.bindValue(":origin", entry.origin);
+    query.bindValue(":kind", entry.kind);
+    query.bindValue(":topic", entry.topic);
+    query.bindValue(":key", entry.key);
+    query.bindValue(":payload", entry.payload);
+    query.bindValue(":now", now);
+    if (!query.exec()) {
+      qWarning() << "ChangeEntry::appendBatch error:" << query.lastError().text();
+      db.rollback();
+      return false;
+    }
+  }
+  return db.commit();
+}
+
+std::vector<ChangeEntry> ChangeEntry::fetchAfter(qint64 seq, int limit) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<ChangeEntry> entries;
+
+  QSqlQuery query(db);
+  query.prepare(R"(
+        SELECT seq, origin, kind, topic, key, payload
+        FROM change_log
+        WHERE seq > :seq
+        ORDER BY seq ASC
+        LIMIT :limit
+    )");
+  query.bindValue(":seq", seq);
+  query.bindValue(":limit", limit);
+  if (!query.exec()) {
+    qWarning() << "ChangeEntry::fetchAfter error:" << query.lastError().text();
+    return entries;
+  }
+
+  while (query.next()) {
+    ChangeEntry entry;
+    entry.seq = query.value(0).toLongLong();
+    entry.origin = query.value(1).toLongLong();
+    entry.kind = query.value(2).toInt();
+    entry.topic = query.value(3).toString();
+    entry.key = query.value(4).toString();
+    entry.payload = query.value(5).toString();
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+qint64 ChangeEntry::latestSeq() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  // AUTOINCREMENT-Zähler mitnehmen: nach einem Purge ist die Tabelle evtl.
+  // leer, die nächste seq liegt aber dahinter (sonst Schein-Lücke)
+  if (query.exec("SELECT MAX(COALESCE((SELECT seq FROM sqlite_sequence "
+                 "WHERE name = 'change_log'), 0), COALESCE(MAX(seq), 0)) FROM change_log") &&
+      query.next()) {
+    return query.value(0).toLongLong();
+  }
+  return 0;
+}
+
+int ChangeEntry::purgeOlderThan(qint64 createdBefore) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM change_log WHERE created_at < :cutoff");
+  query.bindValue(":cutoff", createdBefore);
+  if (!query.exec()) {
+    qWarning() << "ChangeEntry::purgeOlderThan error:" << query.lastError().text();
+    return 0;
+  }
+  return query.numRowsAffected();
+}
@@ -2,8 +2,8 @@
  * @file config_model.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Configuration Model implementation
- * @version 0.2.0
- * @date 2026-01-03
+ * @version 0.3.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -53,6 +53,10 @@ void ConfigModel::loadEnv(const std::string& path) {
     QString startTls = getEnv("SMTP_STARTTLS", "true");
     m_smtpStartTls = (startTls.compare("true", Qt::CaseInsensitive) == 0);
 
+    m_smtpPoolSize = qMax(1, getEnv("SMTP_POOL_SIZE", "2").toInt());
+    m_smtpMaxMessagesPerConnection = qMax(1, getEnv("SMTP_MAX_MESSAGES_PER_CONNECTION", "100").toInt());
+    m_smtpIdleTimeoutSec = qMax(1, getEnv("SMTP_IDLE_TIMEOUT_SEC", "60").toInt());
+
     m_watchDir = getEnv("WATCH_DIR", ".");
 
     qInfo() << "Loaded Configuration for SMTP Server:" << m_smtpServer;
@@ -64,6 +68,9 @@ QString ConfigModel::getSmtpPassword() const { return m_smtpPassword; }
 QString ConfigModel::getSmtpFrom() const { return m_smtpFrom; }
 int ConfigModel::getSmtpPort() const { return m_smtpPort; }
 bool ConfigModel::getSmtpStartTls() const { return m_smtpStartTls; }
+int ConfigModel::getSmtpPoolSize() const { return m_smtpPoolSize; }
+int ConfigModel::getSmtpMaxMessagesPerConnection() const { return m_smtpMaxMessagesPerConnection; }
+int ConfigModel::getSmtpIdleTimeoutSec() const { return m_smtpIdleTimeoutSec; }
 QString ConfigModel::getWatchDir() const { return m_watchDir; }
 
 } // namespace model
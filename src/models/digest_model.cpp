@@ -0,0 +1,123 @@
+/**
+ * @file digest_model.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Pending notification items collected for digest mails
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "models/digest_model.hpp"
+#include "database.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+bool DigestItem::isValidMode(const QString &mode) {
+  return mode == IMMEDIATE || mode == HOURLY || mode == DAILY;
+}
+
+qint64 DigestItem::windowEnd(const QString &mode, qint64 now, int dailyHour) {
+  if (mode == HOURLY) {
+    return (now / 3600 + 1) * 3600;
+  }
+  if (mode == DAILY) {
+    QDateTime t = QDateTime::fromSecsSinceEpoch(now);
+    QDateTime due(t.date(), QTime(dailyHour, 0));
+    if (due <= t) due = due.addDays(1);
+    return due.toSecsSinceEpoch();
+  }
+  return now;
+}
+
+bool DigestItem::add() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        INSERT OR IGNORE INTO digest_items
+            (recipient, language, kind, reference, line, due_at, created_at)
+        VALUES (:to, :lang, :kind, :ref, :line, :due, :now)
+    )");
+  query.bindValue(":to", recipient);
+  query.bindValue(":lang", language);
+  query.bindValue(":kind", kind);
+  query.bindValue(":ref", reference);
+  query.bindValue(":line", line);
+  query.bindValue(":due", dueAt);
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+
+  if (!query.exec()) {
+    qWarning() << "DigestItem::add error:" << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
+std::vector<QString> DigestItem::dueRecipients(qint64 now, int limit) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<QString> result;
+
+  QSqlQuery query(db);
+  query.prepare(R"(
+        SELECT recipient FROM digest_items
+        GROUP BY recipient
+        HAVING MIN(due_at) <= :now
+        LIMIT :limit
+    )");
+  query.bindValue(":now", now);
+  query.bindValue(":limit", limit);
+
+  if (query.exec()) {
+    while (query.next()) result.push_back(query.value(0).toString());
+  }
+  return result;
+}
+
+std::vector<DigestItem> DigestItem::getForRecipient(const QString &recipient) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<DigestItem> items;
+
+  QSqlQuery query(db);
+  query.prepare("SELECT id, language, kind, reference, line, due_at FROM digest_items "
+                "WHERE recipient = :to ORDER BY id ASC");
+  query.bindValue(":to", recipient);
+
+  if (query.exec()) {
+    while (query.next()) {
+      DigestItem item;
+      item.id = query.value("id").toLongLong();
+      item.recipient = recipient;
+      item.language = query.value("language").toString();
+      item.kind = query.value("kind").toString();
+      item.reference = query.value("reference").toString();
+      item.line = query.value("line").toString();
+      item.dueAt = query.value("due_at").toLongLong();
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+bool DigestItem::removeUpTo(const QString &recipient, qint64 maxId) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM digest_items WHERE recipient = :to AND id <= :max");
+  query.bindValue(":to", recipient);
+  query.bindValue(":max", maxId);
+  return query.exec();
+}
+
+int DigestItem::pendingCount() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  if (query.exec("SELECT COUNT(*) FROM digest_items") && query.next()) {
+    return query.value(0).toInt();
+  }
+  return 0;
+}
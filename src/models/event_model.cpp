@@ -2,8 +2,8 @@
  * @file event_model.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Event Model Implementation
- * @version 0.3.5
- * @date 2026-01-03
+ * @version 0.8.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,12 +12,14 @@
 
 #include "models/event_model.hpp"
 #include "database.hpp"
+#include "services/async.hpp"
 
 #include <QSqlQuery>
 #include <QUuid>
 #include <QVariant>
 #include <QSqlError>
 #include <QDate>
+#include <QDateTime>
 #include <QDir>
 #include <QDebug>
 #include <sstream>
@@ -48,6 +50,11 @@ crow::json::wvalue Event::toJson() const {
     return json;
 }
 
+rz::service::Task<std::vector<Event>> Event::getRangeAsync(QString start, QString end, QString userId) {
+    co_return co_await rz::service::runOn(rz::service::Executors::Pool::DbRead,
+                                          [start, end, userId]() { return getRange(start, end, userId); });
+}
+
 std::vector<Event> Event::getRange(const QString &start,
                                    const QString &end,
                                    const QString &userId) {
@@ -101,25 +108,27 @@ bool Event::create(const QString &userId) {
     this->id = QUuid::createUuid().toString(QUuid::WithoutBraces);
   }
 
-  QSqlQuery userQuery(db);
-  // UPDATE: Join mit 'groups' Tabelle, um 'g.name' zu holen
-  userQuery.prepare(R"(
-    SELECT u.full_name, gm.group_id, g.name as group_name
-    FROM users u
-    JOIN group_members gm ON u.id = gm.user_id
-    JOIN groups g ON gm.group_id = g.id
-    WHERE u.id = :uid LIMIT 1
-  )");
-  userQuery.bindValue(":uid", userId);
-
-  if (userQuery.exec() && userQuery.next()) {
-    this->bakerName = userQuery.value("full_name").toString();
-    this->groupId = userQuery.value("group_id").toString();
-    this->groupName = userQuery.value("group_name").toString(); // NEU: Name setzen
-    this->bakerId = userId;
-  } else {
-    return false;
+  if (this->groupId.isEmpty()) {
+    QSqlQuery userQuery(db);
+    // UPDATE: Join mit 'groups' Tabelle, um 'g.name' zu holen
+    userQuery.prepare(R"(
+      SELECT u.full_name, gm.group_id, g.name as group_name
+      FROM users u
+      JOIN group_members gm ON u.id = gm.user_id
+      JOIN groups g ON gm.group_id = g.id
+      WHERE u.id = :uid LIMIT 1
+    )");
+    userQuery.bindValue(":uid", userId);
+
+    if (userQuery.exec() && userQuery.next()) {
+      this->bakerName = userQuery.value("full_name").toString();
+      this->groupId = userQuery.value("group_id").toString();
+      this->groupName = userQuery.value("group_name").toString(); // NEU: Name setzen
+    } else {
+      return false;
+    }
   }
+  this->bakerId = userId;
 
   // Insert bleibt gleich (groupName wird nicht in events tabelle gespeichert, nur referenziert)
   QSqlQuery query(db);
@@ -219,8 +228,36 @@ bool Event::rateEvent(const QString& eventId, const QString& userId, int stars,
     return query.exec();
 }
 
+std::optional<QString> Event::getGroupId(const QString& eventId) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+    query.prepare("SELECT group_id FROM events WHERE id = :id");
+    query.bindValue(":id", eventId);
+    if (!query.exec() || !query.next()) return std::nullopt;
+    return query.value(0).toString();
+}
+
+std::optional<std::pair<QString, EventRating>> Event::getGroupRating(const QString& eventId) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT e.group_id, COALESCE(AVG(r.rating_value), 0), COUNT(r.rater_id)
+        FROM events e
+        LEFT JOIN ratings r ON r.event_id = e.id
+        WHERE e.id = :id
+        GROUP BY e.id
+    )");
+    query.bindValue(":id", eventId);
+    if (!query.exec() || !query.next()) return std::nullopt;
+
+    EventRating rating;
+    rating.average = query.value(1).toDouble();
+    rating.count = query.value(2).toInt();
+    return std::make_pair(query.value(0).toString(), rating);
+}
+
 // --- Foto Upload Implementierung ---
-bool Event::uploadPhoto(const QString& eventId, const QString& userId, const std::string& fileContent, const std::string& ext) {
+std::optional<EventPhoto> Event::uploadPhoto(const QString& eventId, const QString& userId, const std::string& fileContent, const std::string& ext) {
     // 1. Dateinamen generieren (EventID_UserID.ext)
     // Damit überschreibt ein User automatisch sein altes Bild, wenn er ein neues hochlädt (1 Bild pro User Regel)
     QString filename = QString("%1_%2.%3")
@@ -242,19 +279,109 @@ bool Event::uploadPhoto(const QString& eventId, const QString& userId, const std
         QSqlQuery query(db);
         // Wir nutzen INSERT OR REPLACE (Standard SQL) oder UPSERT Syntax
         query.prepare(R"(
-            INSERT INTO event_photos (event_id, user_id, photo_path, uploaded_at)
-            VALUES (:eid, :uid, :path, CURRENT_TIMESTAMP)
+            INSERT INTO event_photos (event_id, user_id, photo_path, uploaded_at, size_bytes)
+            VALUES (:eid, :uid, :path, CURRENT_TIMESTAMP, :size)
             ON CONFLICT(event_id, user_id) DO UPDATE SET
                 photo_path = excluded.photo_path,
-                uploaded_at = CURRENT_TIMESTAMP
+                uploaded_at = CURRENT_TIMESTAMP,
+                size_bytes = excluded.size_bytes
         )");
         query.bindValue(":eid", eventId);
         query.bindValue(":uid", userId);
         query.bindValue(":path", filename);
+        query.bindValue(":size", static_cast<qint64>(fileContent.size()));
+        if (!query.exec()) return std::nullopt;
+
+        EventPhoto photo;
+        photo.eventId = eventId;
+        photo.userId = userId;
+        photo.photoPath = filename;
+        photo.uploadedAt = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd HH:mm:ss");
+        photo.sizeBytes = static_cast<qint64>(fileContent.size());
+        return photo;
+    }
+    return std::nullopt;
+}
+
+// --- Foto Galerie ---
+
+crow::json::wvalue EventPhoto::toJson() const {
+    crow::json::wvalue json;
+    json["eventId"] = eventId.toStdString();
+    json["userId"] = userId.toStdString();
+    json["uploaderName"] = uploaderName.toStdString();
+    json["url"] = "/api/uploads/" + photoPath.toStdString();
+    json["uploadedAt"] = uploadedAt.toStdString();
+    // Bisher wird nur das Original gespeichert, weitere Varianten (Thumbnails) folgen hier
+    json["variants"]["original"] = sizeBytes;
+    return json;
+}
 
-        return query.exec();
+std::optional<std::vector<EventPhoto>> Event::getPhotos(const QString& eventId, const QString& currentUserId) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+
+    // Unbekanntes Event und fremde Gruppe sehen gleich aus (kein Existenz-Leak)
+    query.prepare(R"(
+        SELECT 1 FROM events e
+        JOIN group_members gm ON gm.group_id = e.group_id AND gm.user_id = :uid
+        WHERE e.id = :id
+    )");
+    query.bindValue(":uid", currentUserId);
+    query.bindValue(":id", eventId);
+    if (!query.exec() || !query.next()) return std::nullopt;
+
+    auto batch = getPhotosBatch(QStringList{eventId}, currentUserId);
+    return std::move(batch[eventId]);
+}
+
+std::map<QString, std::vector<EventPhoto>> Event::getPhotosBatch(const QStringList& eventIds, const QString& currentUserId) {
+    std::map<QString, std::vector<EventPhoto>> result;
+    if (eventIds.isEmpty()) return result;
+
+    // Jede angefragte ID bekommt einen (ggf. leeren) Eintrag
+    QStringList placeholders;
+    for (int i = 0; i < eventIds.size(); ++i) {
+        result[eventIds[i]];
+        placeholders << QString(":e%1").arg(i);
+    }
+
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+
+    // Ein Query pro Batch, Sichtbarkeit über die Gruppenmitgliedschaft
+    query.prepare(QString(R"(
+        SELECT p.event_id, p.user_id, p.photo_path, p.uploaded_at,
+               COALESCE(p.size_bytes, 0) AS size_bytes, u.full_name
+        FROM event_photos p
+        JOIN events e ON p.event_id = e.id
+        JOIN group_members gm ON gm.group_id = e.group_id AND gm.user_id = :uid
+        JOIN users u ON p.user_id = u.id
+        WHERE p.event_id IN (%1)
+        ORDER BY p.event_id, p.uploaded_at ASC
+    )").arg(placeholders.join(", ")));
+
+    query.bindValue(":uid", currentUserId);
+    for (int i = 0; i < eventIds.size(); ++i) {
+        query.bindValue(placeholders[i], eventIds[i]);
+    }
+
+    if (!query.exec()) {
+        qWarning() << "Event::getPhotosBatch error:" << query.lastError().text();
+        return result;
+    }
+
+    while (query.next()) {
+        EventPhoto p;
+        p.eventId = query.value("event_id").toString();
+        p.userId = query.value("user_id").toString();
+        p.photoPath = query.value("photo_path").toString();
+        p.uploadedAt = query.value("uploaded_at").toString();
+        p.uploaderName = query.value("full_name").toString();
+        p.sizeBytes = query.value("size_bytes").toLongLong();
+        result[p.eventId].push_back(std::move(p));
     }
-    return false;
+    return result;
 }
 
 std::string Event::toIcsString() const {
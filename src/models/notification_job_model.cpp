@@ -0,0 +1,140 @@
+/**
+ * @file notification_job_model.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Queued domain events for the asynchronous notification pipeline
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "models/notification_job_model.hpp"
+#include "database.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+bool NotificationJob::enqueue(const QString &kind, const QString &reference,
+                              const QJsonObject &payload) {
+  auto db = DatabaseManager::instance().getDatabase();
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+
+  QSqlQuery query(db);
+  query.prepare(R"(
+        INSERT OR IGNORE INTO notification_jobs
+            (id, kind, payload, status, attempts, next_attempt_at, created_at)
+        VALUES (:id, :kind, :payload, 'pending', 0, :now, :now)
+    )");
+  query.bindValue(":id", kind + ':' + reference);
+  query.bindValue(":kind", kind);
+  query.bindValue(":payload", QString::fromUtf8(
+      QJsonDocument(payload).toJson(QJsonDocument::Compact)));
+  query.bindValue(":now", now);
+
+  if (!query.exec()) {
+    qWarning() << "NotificationJob::enqueue error:" << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
+std::vector<NotificationJob> NotificationJob::claimBatch(int limit) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<NotificationJob> batch;
+
+  db.transaction();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        SELECT id, kind, payload, attempts
+        FROM notification_jobs
+        WHERE status = 'pending' AND next_attempt_at <= :now
+        ORDER BY next_attempt_at ASC
+        LIMIT :limit
+    )");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":limit", limit);
+
+  if (query.exec()) {
+    while (query.next()) {
+      NotificationJob job;
+      job.id = query.value("id").toString();
+      job.kind = query.value("kind").toString();
+      job.payload = QJsonDocument::fromJson(
+          query.value("payload").toString().toUtf8()).object();
+      job.attempts = query.value("attempts").toInt();
+      batch.push_back(job);
+    }
+  }
+
+  QSqlQuery update(db);
+  update.prepare("UPDATE notification_jobs SET status = 'running' WHERE id = :id");
+  for (const auto &job : batch) {
+    update.bindValue(":id", job.id);
+    update.exec();
+  }
+  db.commit();
+  return batch;
+}
+
+bool NotificationJob::markDone(const QString &id) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("UPDATE notification_jobs SET status = 'done', done_at = :now, "
+                "attempts = attempts + 1, last_error = NULL WHERE id = :id");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":id", id);
+  return query.exec();
+}
+
+bool NotificationJob::markFailed(const QString &id, const QString &error,
+                                 qint64 nextAttemptAt, bool dead) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        UPDATE notification_jobs
+        SET status = :status,
+            attempts = attempts + 1,
+            next_attempt_at = :next,
+            last_error = :error
+        WHERE id = :id
+    )");
+  query.bindValue(":status", dead ? "dead" : "pending");
+  query.bindValue(":next", nextAttemptAt);
+  query.bindValue(":error", error);
+  query.bindValue(":id", id);
+  return query.exec();
+}
+
+int NotificationJob::resetInFlight() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  if (query.exec("UPDATE notification_jobs SET status = 'pending' WHERE status = 'running'")) {
+    return query.numRowsAffected();
+  }
+  return 0;
+}
+
+int NotificationJob::purgeDone(qint64 olderThan) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM notification_jobs WHERE status = 'done' AND done_at < :ts");
+  query.bindValue(":ts", olderThan);
+  if (query.exec()) return query.numRowsAffected();
+  return 0;
+}
+
+int NotificationJob::pendingCount() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  if (query.exec("SELECT COUNT(*) FROM notification_jobs WHERE status IN ('pending', 'running')") &&
+      query.next()) {
+    return query.value(0).toInt();
+  }
+  return 0;
+}
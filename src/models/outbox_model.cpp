@@ -0,0 +1,263 @@
+/**
+ * @file outbox_model.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Durable e-mail outbox
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "models/outbox_model.hpp"
+#include "database.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <algorithm>
+
+crow::json::wvalue OutboxMessage::toJson() const {
+  crow::json::wvalue json;
+  json["id"] = id.toStdString();
+  json["recipient"] = recipient.toStdString();
+  json["subject"] = subject.toStdString();
+  json["status"] = status.toStdString();
+  json["attempts"] = attempts;
+  json["nextAttemptAt"] = nextAttemptAt;
+  json["createdAt"] = createdAt;
+  json["lastError"] = lastError.toStdString();
+  return json;
+}
+
+QString OutboxMessage::makeId(const QString &kind, const QString &reference,
+                              const QString &recipient) {
+  QByteArray key = (kind + '\n' + reference + '\n' + recipient.toLower()).toUtf8();
+  return QString::fromLatin1(
+      QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+}
+
+bool OutboxMessage::enqueue() {
+  auto db = DatabaseManager::instance().getDatabase();
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+
+  QSqlQuery query(db);
+  query.prepare(R"(
+        INSERT OR IGNORE INTO email_outbox
+            (id, recipient, subject, body, html_body, status, attempts, priority,
+             fairness_key, next_attempt_at, created_at)
+        VALUES (:id, :to, :subject, :body, :html, 'pending', 0, :priority,
+                :fairness, :next, :created)
+    )");
+  query.bindValue(":id", id);
+  query.bindValue(":to", recipient);
+  query.bindValue(":subject", subject);
+  query.bindValue(":body", body);
+  query.bindValue(":html", htmlBody.isEmpty() ? QVariant() : QVariant(htmlBody));
+  query.bindValue(":priority", priority);
+  query.bindValue(":fairness", fairnessKey);
+  query.bindValue(":next", nextAttemptAt > 0 ? nextAttemptAt : now);
+  query.bindValue(":created", now);
+
+  if (!query.exec()) {
+    qWarning() << "OutboxMessage::enqueue error:" << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
+std::vector<OutboxMessage> OutboxMessage::fetchDue(int limit, int perKey,
+                                                   const QStringList &excludedDomains) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<OutboxMessage> batch;
+
+  // Gedrosselte Domains schon in SQL ausfiltern, sonst füllen sie das Fenster
+  QString domainFilter;
+  QStringList placeholders;
+  for (int i = 0; i < excludedDomains.size(); ++i) placeholders << QString(":d%1").arg(i);
+  if (!placeholders.isEmpty()) {
+    domainFilter = QString(" AND lower(trim(substr(recipient, instr(recipient, '@') + 1))) "
+                           "NOT IN (%1)")
+                       .arg(placeholders.join(", "));
+  }
+
+  // Pro Priorität und Fairness-Key nur die ältesten perKey Mails: ein großer
+  // Gruppen-Fan-out verdrängt die anderen Gruppen nicht aus dem Fenster
+  QSqlQuery query(db);
+  query.prepare(QString(R"(
+        SELECT id, recipient, subject, body, html_body, attempts, priority, fairness_key, created_at
+        FROM (
+            SELECT *, ROW_NUMBER() OVER (
+                       PARTITION BY priority, COALESCE(fairness_key, '')
+                       ORDER BY next_attempt_at ASC) AS key_rank
+            FROM email_outbox
+            WHERE status = 'pending' AND next_attempt_at <= :now%1
+        )
+        WHERE key_rank <= :perKey
+        ORDER BY priority ASC, next_attempt_at ASC
+        LIMIT :limit
+    )").arg(domainFilter));
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":perKey", std::max(1, perKey));
+  query.bindValue(":limit", limit);
+  for (int i = 0; i < placeholders.size(); ++i) {
+    query.bindValue(placeholders[i], excludedDomains[i]);
+  }
+
+  if (query.exec()) {
+    while (query.next()) {
+      OutboxMessage m;
+      m.id = query.value("id").toString();
+      m.recipient = query.value("recipient").toString();
+      m.subject = query.value("subject").toString();
+      m.body = query.value("body").toString();
+      m.htmlBody = query.value("html_body").toString();
+      m.attempts = query.value("attempts").toInt();
+      m.priority = query.value("priority").toInt();
+      m.fairnessKey = query.value("fairness_key").toString();
+      m.createdAt = query.value("created_at").toLongLong();
+      m.status = "pending";
+      batch.push_back(m);
+    }
+  }
+  return batch;
+}
+
+bool OutboxMessage::claim(const std::vector<OutboxMessage> &messages) {
+  auto db = DatabaseManager::instance().getDatabase();
+  db.transaction();
+  QSqlQuery update(db);
+  update.prepare("UPDATE email_outbox SET status = 'sending' WHERE id = :id AND status = 'pending'");
+  for (const auto &m : messages) {
+    update.bindValue(":id", m.id);
+    if (!update.exec()) {
+      db.rollback();
+      return false;
+    }
+  }
+  return db.commit();
+}
+
+bool OutboxMessage::markSent(const QString &id) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("UPDATE email_outbox SET status = 'sent', sent_at = :now, "
+                "attempts = attempts + 1, last_error = NULL WHERE id = :id");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":id", id);
+  return query.exec();
+}
+
+bool OutboxMessage::markFailed(const QString &id, const QString &error,
+                               qint64 nextAttemptAt, bool dead) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        UPDATE email_outbox
+        SET status = :status,
+            attempts = attempts + 1,
+            next_attempt_at = :next,
+            last_error = :error
+        WHERE id = :id
+    )");
+  query.bindValue(":status", dead ? "dead" : "pending");
+  query.bindValue(":next", nextAttemptAt);
+  query.bindValue(":error", error);
+  query.bindValue(":id", id);
+  return query.exec();
+}
+
+int OutboxMessage::resetInFlight() {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  if (query.exec("UPDATE email_outbox SET status = 'pending' WHERE status = 'sending'")) {
+    return query.numRowsAffected();
+  }
+  return 0;
+}
+
+int OutboxMessage::purgeSent(qint64 olderThan) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM email_outbox WHERE status = 'sent' AND sent_at < :ts");
+  query.bindValue(":ts", olderThan);
+  if (query.exec()) return query.numRowsAffected();
+  return 0;
+}
+
+OutboxMessage::Stats OutboxMessage::stats() {
+  auto db = DatabaseManager::instance().getDatabase();
+  Stats s;
+
+  QSqlQuery query(db);
+  if (query.exec("SELECT status, priority, COUNT(*), MIN(created_at) FROM email_outbox "
+                 "GROUP BY status, priority")) {
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    while (query.next()) {
+      QString status = query.value(0).toString();
+      int priority = query.value(1).toInt();
+      int count = query.value(2).toInt();
+      if (status == "pending") {
+        qint64 age = now - query.value(3).toLongLong();
+        s.pending += count;
+        s.oldestPendingAgeSec = std::max(s.oldestPendingAgeSec, age);
+        if (priority >= 0 && priority < PRIORITY_COUNT) {
+          s.pendingByPriority[priority] = count;
+          s.oldestAgeSecByPriority[priority] = age;
+        }
+      } else if (status == "sending") {
+        s.sending += count;
+      } else if (status == "sent") {
+        s.sent += count;
+      } else if (status == "dead") {
+        s.dead += count;
+      }
+    }
+  }
+  return s;
+}
+
+std::vector<OutboxMessage> OutboxMessage::getDead(int limit) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<OutboxMessage> result;
+
+  QSqlQuery query(db);
+  query.prepare(R"(
+        SELECT id, recipient, subject, attempts, next_attempt_at, created_at, last_error
+        FROM email_outbox
+        WHERE status = 'dead'
+        ORDER BY created_at DESC
+        LIMIT :limit
+    )");
+  query.bindValue(":limit", limit);
+
+  if (query.exec()) {
+    while (query.next()) {
+      OutboxMessage m;
+      m.id = query.value("id").toString();
+      m.recipient = query.value("recipient").toString();
+      m.subject = query.value("subject").toString();
+      m.status = "dead";
+      m.attempts = query.value("attempts").toInt();
+      m.nextAttemptAt = query.value("next_attempt_at").toLongLong();
+      m.createdAt = query.value("created_at").toLongLong();
+      m.lastError = query.value("last_error").toString();
+      result.push_back(m);
+    }
+  }
+  return result;
+}
+
+bool OutboxMessage::requeue(const QString &id) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("UPDATE email_outbox SET status = 'pending', attempts = 0, "
+                "next_attempt_at = :now WHERE id = :id AND status = 'dead'");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":id", id);
+  return query.exec() && query.numRowsAffected() > 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file session_model.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Server-side login sessions (refresh tokens)
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "models/session_model.hpp"
+#include "database.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+#include <QVariant>
+
+crow::json::wvalue Session::toJson() const {
+  crow::json::wvalue json;
+  json["id"] = id.toStdString();
+  json["device"] = device.toStdString();
+  json["ipAddress"] = ipAddress.toStdString();
+  json["createdAt"] = createdAt.toStdString();
+  json["lastUsedAt"] = lastUsedAt.toStdString();
+  json["expiresAt"] = expiresAt;
+  return json;
+}
+
+bool Session::create(const QString &refreshHash) {
+  auto db = DatabaseManager::instance().getDatabase();
+
+  if (this->id.isEmpty()) {
+    this->id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+  }
+
+  QSqlQuery query(db);
+  query.prepare("INSERT INTO sessions (id, user_id, refresh_hash, device, "
+                "ip_address, expires_at) "
+                "VALUES (:id, :uid, :hash, :device, :ip, :exp)");
+  query.bindValue(":id", this->id);
+  query.bindValue(":uid", this->userId);
+  query.bindValue(":hash", refreshHash);
+  query.bindValue(":device", this->device);
+  query.bindValue(":ip", this->ipAddress);
+  query.bindValue(":exp", this->expiresAt);
+
+  if (!query.exec()) {
+    qWarning() << "Session::create error:" << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
+// Lookup über refresh_hash oder prev_refresh_hash (beide indiziert)
+static std::optional<Session> getByHashColumn(const char *column, const QString &refreshHash) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(QString(R"(
+        SELECT s.id, s.user_id, s.device, s.ip_address, s.created_at,
+               s.last_used_at, s.expires_at, s.revoked,
+               u.email, u.is_admin, u.is_active
+        FROM sessions s
+        JOIN users u ON s.user_id = u.id
+        WHERE s.%1 = :hash
+    )").arg(column));
+  query.bindValue(":hash", refreshHash);
+
+  if (!query.exec() || !query.next()) return std::nullopt;
+
+  Session s;
+  s.id = query.value("id").toString();
+  s.userId = query.value("user_id").toString();
+  s.device = query.value("device").toString();
+  s.ipAddress = query.value("ip_address").toString();
+  s.createdAt = query.value("created_at").toString();
+  s.lastUsedAt = query.value("last_used_at").toString();
+  s.expiresAt = query.value("expires_at").toLongLong();
+  s.revoked = query.value("revoked").toBool();
+  s.userEmail = query.value("email").toString();
+  s.userIsAdmin = query.value("is_admin").toBool();
+  s.userIsActive = query.value("is_active").toBool();
+  return s;
+}
+
+std::optional<Session> Session::getByRefreshHash(const QString &refreshHash) {
+  return getByHashColumn("refresh_hash", refreshHash);
+}
+
+std::optional<Session> Session::getByPreviousRefreshHash(const QString &refreshHash) {
+  return getByHashColumn("prev_refresh_hash", refreshHash);
+}
+
+bool Session::rotate(const QString &sessionId, const QString &oldHash,
+                     const QString &newHash, qint64 newExpiresAt) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        UPDATE sessions
+        SET refresh_hash = :newHash,
+            prev_refresh_hash = refresh_hash,
+            expires_at = :exp,
+            last_used_at = CURRENT_TIMESTAMP
+        WHERE id = :id AND refresh_hash = :oldHash AND revoked = 0
+    )");
+  query.bindValue(":newHash", newHash);
+  query.bindValue(":exp", newExpiresAt);
+  query.bindValue(":id", sessionId);
+  query.bindValue(":oldHash", oldHash);
+
+  return query.exec() && query.numRowsAffected() == 1;
+}
+
+std::vector<Session> Session::getActiveByUser(const QString &userId) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  std::vector<Session> sessions;
+
+  query.prepare(R"(
+        SELECT id, user_id, device, ip_address, created_at, last_used_at, expires_at
+        FROM sessions
+        WHERE user_id = :uid AND revoked = 0 AND expires_at > :now
+        ORDER BY last_used_at DESC
+    )");
+  query.bindValue(":uid", userId);
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+
+  if (query.exec()) {
+    while (query.next()) {
+      Session s;
+      s.id = query.value("id").toString();
+      s.userId = query.value("user_id").toString();
+      s.device = query.value("device").toString();
+      s.ipAddress = query.value("ip_address").toString();
+      s.createdAt = query.value("created_at").toString();
+      s.lastUsedAt = query.value("last_used_at").toString();
+      s.expiresAt = query.value("expires_at").toLongLong();
+      sessions.push_back(s);
+    }
+  }
+  return sessions;
+}
+
+bool Session::revoke(const QString &sessionId, const QString &userId) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("UPDATE sessions SET revoked = 1 WHERE id = :id AND user_id = :uid");
+  query.bindValue(":id", sessionId);
+  query.bindValue(":uid", userId);
+  return query.exec() && query.numRowsAffected() > 0;
+}
+
+std::vector<QString> Session::revokeAllForUser(const QString &userId,
+                                               const QString &exceptSessionId) {
+  auto db = DatabaseManager::instance().getDatabase();
+  std::vector<QString> ids;
+
+  QSqlQuery select(db);
+  select.prepare("SELECT id FROM sessions WHERE user_id = :uid AND revoked = 0 AND id <> :except");
+  select.bindValue(":uid", userId);
+  select.bindValue(":except", exceptSessionId);
+  if (select.exec()) {
+    while (select.next()) ids.push_back(select.value(0).toString());
+  }
+
+  QSqlQuery update(db);
+  update.prepare("UPDATE sessions SET revoked = 1 WHERE user_id = :uid AND id <> :except");
+  update.bindValue(":uid", userId);
+  update.bindValue(":except", exceptSessionId);
+  update.exec();
+  return ids;
+}
+
+std::vector<std::pair<QString, qint64>> Session::getRevoked(qint64 accessTokenTtl) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  std::vector<std::pair<QString, qint64>> revoked;
+
+  // Das letzte Access Token entstand beim Login bzw. letzten Refresh (last_used_at)
+  query.prepare(R"(
+        SELECT id, CAST(strftime('%s', last_used_at) AS INTEGER) + :ttl AS valid_until
+        FROM sessions
+        WHERE revoked = 1 AND CAST(strftime('%s', last_used_at) AS INTEGER) + :ttl > :now
+    )");
+  query.bindValue(":ttl", accessTokenTtl);
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  if (query.exec()) {
+    while (query.next()) {
+      revoked.emplace_back(query.value(0).toString(), query.value(1).toLongLong());
+    }
+  }
+  return revoked;
+}
+
+int Session::purgeStale(qint64 accessTokenTtl) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        DELETE FROM sessions
+        WHERE expires_at <= :now
+           OR (revoked = 1 AND CAST(strftime('%s', last_used_at) AS INTEGER) + :ttl <= :now)
+    )");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":ttl", accessTokenTtl);
+  if (!query.exec()) {
+    qWarning() << "Session::purgeStale error:" << query.lastError().text();
+    return 0;
+  }
+  return query.numRowsAffected();
+}
@@ -2,8 +2,8 @@
  * @file user_model.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief User Model Implementation
- * @version 0.3.6
- * @date 2026-01-03
+ * @version 0.9.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,6 +12,8 @@
 
 #include "models/user_model.hpp"
 #include "database.hpp"
+#include "services/async.hpp"
+#include "services/change_bus.hpp"
 #include <QSqlQuery>
 #include <QUuid>
 #include <QVariant>
@@ -33,6 +35,43 @@ std::pair<QString, QString> User::getGroupAndRole(const QString &userId) {
   return {}; // Leer, falls keine Gruppe
 }
 
+std::optional<rz::utils::AuthSnapshot> User::loadAuthSnapshot(const QString &userId) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare(R"(
+        SELECT u.full_name, u.is_active, u.is_admin,
+               gm.group_id, gm.role, g.name as group_name
+        FROM users u
+        LEFT JOIN group_members gm ON gm.user_id = u.id
+        LEFT JOIN groups g ON g.id = gm.group_id
+        WHERE u.id = :uid
+    )");
+  query.bindValue(":uid", userId);
+
+  if (!query.exec()) {
+    qWarning() << "User::loadAuthSnapshot error:" << query.lastError().text();
+    return std::nullopt;
+  }
+
+  std::optional<rz::utils::AuthSnapshot> snapshot;
+  while (query.next()) {
+    if (!snapshot) {
+      snapshot.emplace();
+      snapshot->userId = userId;
+      snapshot->displayName = query.value("full_name").toString();
+      snapshot->isActive = query.value("is_active").toBool();
+      snapshot->isAdmin = query.value("is_admin").toBool();
+    }
+    QString groupId = query.value("group_id").toString();
+    if (groupId.isEmpty()) continue;
+
+    QString role = query.value("role").toString();
+    snapshot->groups.push_back({groupId, query.value("group_name").toString(),
+                                role.isEmpty() ? QString("member") : role});
+  }
+  return snapshot;
+}
+
 // --- Business / DB Logic ---
 
 crow::json::wvalue User::toJson() const {
@@ -48,17 +87,24 @@ crow::json::wvalue User::toJson() const {
   json["isActive"] = is_active;
   json["mustChangePassword"] = must_change_password;
   json["has2FA"] = !totp_secret.isEmpty();
+  json["notifyNewEvents"] = notifyNewEvents;
+  json["notifyDigest"] = notifyDigest.toStdString();
   json["groupId"] = groupId.toStdString();
   json["groupRole"] = groupRole.toStdString();
   return json;
 }
 
+rz::service::Task<std::optional<User>> User::getByEmailAsync(QString email) {
+  co_return co_await rz::service::runOn(rz::service::Executors::Pool::DbRead,
+                                        [email]() { return getByEmail(email); });
+}
+
 std::optional<User> User::getByEmail(const QString &email) {
   auto db = DatabaseManager::instance().getDatabase();
   QSqlQuery query(db);
   // FIX 2: email_language im SELECT hinzufügen
   query.prepare("SELECT id, full_name, email, email_language, password_hash, is_active, "
-                "is_admin, totp_secret, must_change_password FROM users WHERE "
+                "is_admin, totp_secret, must_change_password, notify_new_events, notify_digest FROM users WHERE "
                 "email = :email");
   query.bindValue(":email", email);
 
@@ -76,6 +122,9 @@ std::optional<User> User::getByEmail(const QString &email) {
     u.is_active = query.value("is_active").toBool();
     u.is_admin = query.value("is_admin").toBool();
     u.must_change_password = query.value("must_change_password").toBool();
+    u.notifyNewEvents = query.value("notify_new_events").toBool();
+    u.notifyDigest = query.value("notify_digest").toString();
+    if (u.notifyDigest.isEmpty()) u.notifyDigest = "immediate";
     u.totp_secret = query.value("totp_secret").toString();
 
     // Gruppen-Infos nachladen
@@ -98,7 +147,8 @@ std::optional<User> User::getById(const QString &id) {
   // FIX 3: email_language im SELECT hinzufügen
   query.prepare(
       "SELECT id, full_name, email, email_language, password_hash, is_active, "
-      "is_admin, totp_secret, must_change_password FROM users WHERE id = :id");
+      "is_admin, totp_secret, must_change_password, notify_new_events, notify_digest "
+      "FROM users WHERE id = :id");
   query.bindValue(":id", id);
 
   if (query.exec() && query.next()) {
@@ -115,6 +165,9 @@ std::optional<User> User::getById(const QString &id) {
     u.is_active = query.value("is_active").toBool();
     u.is_admin = query.value("is_admin").toBool();
     u.must_change_password = query.value("must_change_password").toBool();
+    u.notifyNewEvents = query.value("notify_new_events").toBool();
+    u.notifyDigest = query.value("notify_digest").toString();
+    if (u.notifyDigest.isEmpty()) u.notifyDigest = "immediate";
     u.totp_secret = query.value("totp_secret").toString();
 
     // Gruppen-Infos nachladen
@@ -236,7 +289,9 @@ bool User::updateStatus(const QString &userId, bool isActive) {
   query.bindValue(":active", isActive);
   query.bindValue(":id", userId);
 
-  return query.exec();
+  bool ok = query.exec();
+  rz::service::ChangeBus::instance().invalidateUser(userId);
+  return ok;
 }
 
 bool User::setMustChangePassword(const QString &userId, bool mustChange) {
@@ -260,6 +315,17 @@ bool User::updatePassword(const QString &userId, const QString &newHash) {
   return query.exec();
 }
 
+bool User::updatePasswordHash(const QString &userId, const QString &newHash) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+
+  query.prepare("UPDATE users SET password_hash = :hash WHERE id = :id");
+  query.bindValue(":hash", newHash);
+  query.bindValue(":id", userId);
+
+  return query.exec();
+}
+
 std::vector<std::pair<QString, QString>> User::getAllGroups() {
   auto db = DatabaseManager::instance().getDatabase();
   QSqlQuery query(db);
@@ -287,7 +353,9 @@ bool User::assignToGroup(const QString &userId, const QString &groupId) {
   query.bindValue(":gid", groupId);
   query.bindValue(":uid", userId);
 
-  return query.exec();
+  bool ok = query.exec();
+  rz::service::ChangeBus::instance().invalidateUser(userId);
+  return ok;
 }
 
 bool User::setGroupRole(const QString &userId, const QString &groupId,
@@ -301,10 +369,9 @@ bool User::setGroupRole(const QString &userId, const QString &groupId,
   query.bindValue(":uid", userId);
   query.bindValue(":gid", groupId);
 
-  if (query.exec()) {
-    return query.numRowsAffected() > 0;
-  }
-  return false;
+  bool ok = query.exec() && query.numRowsAffected() > 0;
+  rz::service::ChangeBus::instance().invalidateUser(userId);
+  return ok;
 }
 
 QString User::getGroupRole(const QString &userId, const QString &groupId) {
@@ -334,6 +401,26 @@ bool User::softDelete(const QString& userId) {
         WHERE id = :id
     )");
     query.bindValue(":id", userId);
+    bool ok = query.exec();
+    rz::service::ChangeBus::instance().invalidateUser(userId);
+    return ok;
+}
+
+bool User::updateNotificationPrefs(const QString& userId, bool notifyNewEvents) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+    query.prepare("UPDATE users SET notify_new_events = :notify WHERE id = :id");
+    query.bindValue(":notify", notifyNewEvents ? 1 : 0);
+    query.bindValue(":id", userId);
+    return query.exec();
+}
+
+bool User::updateDigestMode(const QString& userId, const QString& mode) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+    query.prepare("UPDATE users SET notify_digest = :mode WHERE id = :id");
+    query.bindValue(":mode", mode);
+    query.bindValue(":id", userId);
     return query.exec();
 }
 
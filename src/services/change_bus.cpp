@@ -0,0 +1,255 @@
+/**
+ * @file change_bus.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Cross-process cache invalidation and realtime fan-out
+ * @version 0.5.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/change_bus.hpp"
+#include "models/session_model.hpp"
+#include "services/event_hub.hpp"
+#include "services/ws_hub.hpp"
+#include "utils/auth_context_cache.hpp"
+#include "utils/env_loader.hpp"
+#include "utils/mail_templates.hpp"
+#include "utils/revocation_list.hpp"
+#include "utils/token_utils.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <unistd.h>
+
+namespace rz {
+namespace service {
+
+// Änderungen pro Poll-Runde
+static constexpr int FETCH_LIMIT = 500;
+
+// Access Tokens einer widerrufenen Session laufen spätestens dann ab
+static qint64 revokedUntil() {
+  return QDateTime::currentSecsSinceEpoch() + rz::utils::TokenUtils::accessTokenTtl();
+}
+
+ChangeBus &ChangeBus::instance() {
+  static ChangeBus instance;
+  return instance;
+}
+
+ChangeBus::~ChangeBus() { stop(); }
+
+void ChangeBus::start(bool primary) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_thread.joinable()) return;
+
+  m_pollMs = std::max(5, rz::utils::EnvLoader::getInt("CAKE_CHANGE_POLL_MS", 50));
+  m_retentionSec = std::max(10, rz::utils::EnvLoader::getInt("CAKE_CHANGE_RETENTION_SEC", 60));
+  m_primary = primary;
+  m_origin = static_cast<qint64>(getpid());
+  m_stopping = false;
+  // Historie vor dem Start gehört zu Caches, die wir ohnehin frisch laden;
+  // ab hier vergibt die change_log die SSE-Ids
+  m_lastSeq.store(ChangeEntry::latestSeq(), std::memory_order_relaxed);
+  EventHub::instance().useSharedIds(static_cast<uint64_t>(m_lastSeq.load()));
+  m_shared.store(true, std::memory_order_release);
+  m_thread = std::thread([this]() { loop(); });
+
+  qInfo() << "[ChangeBus] Aktiv, Poll-Intervall" << m_pollMs << "ms";
+}
+
+void ChangeBus::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+  m_shared.store(false, std::memory_order_release);
+}
+
+void ChangeBus::publish(const std::string &topic, crow::json::wvalue payload,
+                        std::string coalesceKey) {
+  // Prefork: SSE kommt in allen Workern aus der change_log (Id = seq)
+  if (shared()) {
+    append(Realtime, QString::fromStdString(topic), QString::fromStdString(coalesceKey),
+           QString::fromStdString(payload.dump()));
+  } else {
+    EventHub::instance().publish(topic, payload);
+  }
+  WsHub::instance().publish(topic, std::move(payload), std::move(coalesceKey));
+}
+
+void ChangeBus::publishWs(const std::string &topic, crow::json::wvalue payload,
+                          std::string coalesceKey) {
+  if (shared()) {
+    append(RealtimeWs, QString::fromStdString(topic), QString::fromStdString(coalesceKey),
+           QString::fromStdString(payload.dump()));
+  }
+  WsHub::instance().publish(topic, std::move(payload), std::move(coalesceKey));
+}
+
+void ChangeBus::invalidateUser(const QString &userId) {
+  rz::utils::AuthContextCache::instance().invalidate(userId);
+  WsHub::instance().invalidateUser(userId);
+  if (shared()) append(InvalidateUser, {}, userId, {});
+}
+
+void ChangeBus::revokeSession(const QString &sessionId) {
+  rz::utils::RevocationList::instance().revoke(sessionId, revokedUntil());
+  WsHub::instance().revokeSession(sessionId);
+  if (shared()) append(RevokeSession, {}, sessionId, {});
+}
+
+void ChangeBus::reloadTemplates() {
+  // Lokal lädt der Admin-Endpoint selbst (er meldet das Ergebnis zurück)
+  if (shared()) append(ReloadTemplates, {}, {}, {});
+}
+
+void ChangeBus::wakeNotifications() {
+  if (m_wakeHandler) {
+    m_wakeHandler();
+  } else if (shared()) {
+    append(WakeNotifications, {}, {}, {});
+  }
+}
+
+void ChangeBus::append(int kind, QString topic, QString key, QString payload) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_outgoing.size() >= m_maxPending) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ChangeEntry entry;
+    entry.origin = m_origin;
+    entry.kind = kind;
+    entry.topic = std::move(topic);
+    entry.key = std::move(key);
+    entry.payload = std::move(payload);
+    m_outgoing.push_back(std::move(entry));
+  }
+  m_cv.notify_one();
+}
+
+void ChangeBus::apply(const ChangeEntry &entry) {
+  // Eigene Einträge wurden schon lokal angewendet, bis auf SSE (siehe publish)
+  const bool own = entry.origin == m_origin;
+  if (own && entry.kind != Realtime) return;
+
+  switch (entry.kind) {
+  case Realtime:
+  case RealtimeWs: {
+    auto json = crow::json::load(entry.payload.toStdString());
+    if (!json) return;
+    std::string t = entry.topic.toStdString();
+    crow::json::wvalue msg(json);
+    if (entry.kind == Realtime) {
+      EventHub::instance().publish(t, msg, static_cast<uint64_t>(entry.seq));
+      if (own) return;
+    }
+    WsHub::instance().publish(t, std::move(msg), entry.key.toStdString());
+    break;
+  }
+  case InvalidateUser:
+    rz::utils::AuthContextCache::instance().invalidate(entry.key);
+    WsHub::instance().invalidateUser(entry.key);
+    break;
+  case RevokeSession:
+    rz::utils::RevocationList::instance().revoke(entry.key, revokedUntil());
+    WsHub::instance().revokeSession(entry.key);
+    break;
+  case ReloadTemplates:
+    rz::utils::MailTemplates::instance().reload();
+    break;
+  case WakeNotifications:
+    if (m_wakeHandler) m_wakeHandler();
+    break;
+  default:
+    return; // unbekannt
+  }
+  m_applied.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChangeBus::resync(qint64 missedUpTo) {
+  qWarning() << "[ChangeBus] Einträge" << m_lastSeq.load() + 1 << "bis" << missedUpTo
+             << "wurden gelöscht, bevor dieser Worker sie gelesen hat: Resync";
+  m_resyncs.fetch_add(1, std::memory_order_relaxed);
+
+  // Verpasste Widerrufe und Rechte-Änderungen aus der DB nachholen
+  rz::utils::RevocationList::instance().load(
+      Session::getRevoked(rz::utils::TokenUtils::accessTokenTtl()));
+  rz::utils::AuthContextCache::instance().clear();
+  rz::utils::MailTemplates::instance().reload();
+  WsHub::instance().resync();
+  EventHub::instance().resync(static_cast<uint64_t>(missedUpTo));
+}
+
+void ChangeBus::loop() {
+  qint64 lastPurge = QDateTime::currentSecsSinceEpoch();
+  std::vector<ChangeEntry> batch;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      // Eigene Änderungen wecken sofort, fremde holt der Poll
+      m_cv.wait_for(lock, std::chrono::milliseconds(m_pollMs),
+                    [this] { return m_stopping || !m_outgoing.empty(); });
+      batch.swap(m_outgoing);
+      if (m_stopping && batch.empty()) break;
+    }
+
+    if (!batch.empty()) {
+      if (ChangeEntry::appendBatch(batch)) {
+        m_written.fetch_add(batch.size(), std::memory_order_relaxed);
+      } else {
+        m_dropped.fetch_add(batch.size(), std::memory_order_relaxed);
+      }
+      batch.clear();
+    }
+
+    // Änderungen in globaler Reihenfolge anwenden
+    while (true) {
+      auto entries =
+          ChangeEntry::fetchAfter(m_lastSeq.load(std::memory_order_relaxed), FETCH_LIMIT);
+      // seq ist lückenlos (AUTOINCREMENT, ein Writer): eine Lücke heißt, der
+      // Purge war schneller als dieser Worker
+      if (!entries.empty() && entries.front().seq > m_lastSeq.load(std::memory_order_relaxed) + 1) {
+        resync(entries.front().seq - 1);
+      }
+      for (const auto &entry : entries) {
+        apply(entry);
+        m_lastSeq.store(entry.seq, std::memory_order_relaxed);
+      }
+      if (static_cast<int>(entries.size()) < FETCH_LIMIT) break;
+    }
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (m_primary && now - lastPurge >= 10) {
+      ChangeEntry::purgeOlderThan(now - m_retentionSec);
+      lastPurge = now;
+    }
+  }
+}
+
+ChangeBus::Stats ChangeBus::stats() const {
+  Stats s;
+  s.shared = shared();
+  s.lastSeq = m_lastSeq.load(std::memory_order_relaxed);
+  s.written = m_written.load(std::memory_order_relaxed);
+  s.applied = m_applied.load(std::memory_order_relaxed);
+  s.dropped = m_dropped.load(std::memory_order_relaxed);
+  s.resyncs = m_resyncs.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s.pending = m_outgoing.size();
+  }
+  return s;
+}
+
+} // namespace service
+} // namespace rz
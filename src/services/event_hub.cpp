@@ -0,0 +1,328 @@
+/**
+ * @file event_hub.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Non-blocking Server-Sent Events hub
+ * @version 0.6.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/event_hub.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace rz {
+namespace service {
+
+struct EventHub::Subscriber {
+  uint64_t id = 0;
+  asio::io_context *io = nullptr;
+  crow::response *res = nullptr;
+  std::vector<std::string> topics;
+  asio::steady_timer heartbeat;
+  asio::steady_timer flushTimer;
+  std::string buffer;
+  uint64_t skipUpTo = 0; // Frames bis hier hat der Client schon (Prefork)
+  bool flushScheduled = false;
+  bool done = false;
+
+  explicit Subscriber(asio::io_context &ctx) : io(&ctx), heartbeat(ctx), flushTimer(ctx) {}
+};
+
+EventHub::EventHub() {
+  // Ids aus der Startzeit ableiten: auch über Neustarts hinweg monoton,
+  // alte Last-Event-IDs liegen damit immer vor m_firstEventId
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count();
+  m_lastEventId = static_cast<uint64_t>(ms) * 1000;
+  m_firstEventId = m_lastEventId + 1;
+}
+
+EventHub &EventHub::instance() {
+  static EventHub instance;
+  return instance;
+}
+
+void EventHub::configureFromEnv() {
+  m_heartbeat = std::chrono::seconds(
+      std::max(1, rz::utils::EnvLoader::getInt("CAKE_SSE_HEARTBEAT_SEC", 25)));
+  m_coalesce = std::chrono::milliseconds(
+      std::max(0, rz::utils::EnvLoader::getInt("CAKE_SSE_COALESCE_MS", 50)));
+  m_maxBufferBytes = static_cast<size_t>(
+      std::max(1024, rz::utils::EnvLoader::getInt("CAKE_SSE_MAX_BUFFER_BYTES", 64 * 1024)));
+  m_maxSubscribers = static_cast<size_t>(
+      std::max(1, rz::utils::EnvLoader::getInt("CAKE_SSE_MAX_SUBSCRIBERS", 10000)));
+  m_retryMs = rz::utils::EnvLoader::getInt("CAKE_SSE_RETRY_MS", 1000);
+  m_replaySize = static_cast<size_t>(
+      std::max(0, rz::utils::EnvLoader::getInt("CAKE_SSE_REPLAY_SIZE", 256)));
+
+  qInfo() << "[SSE] Heartbeat" << m_heartbeat.count() << "s, Coalescing" << m_coalesce.count()
+          << "ms, max." << m_maxSubscribers << "Subscriber, Replay" << m_replaySize
+          << "pro Topic";
+}
+
+void EventHub::useSharedIds(uint64_t lastSeq) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sharedIds = true;
+  m_lastEventId = lastSeq;
+  m_firstEventId = lastSeq + 1;
+  m_logs.clear();
+}
+
+std::string EventHub::groupTopic(const QString &groupId) {
+  return "group:" + groupId.toStdString();
+}
+
+bool EventHub::subscribe(const crow::request &req, crow::response &res,
+                         std::vector<std::string> topics) {
+  if (!req.io_context) return false;
+
+  // EventSource schickt den Header beim Reconnect; Query-Parameter für den ersten Connect
+  std::string lastIdText = req.get_header_value("Last-Event-ID");
+  if (lastIdText.empty() && req.url_params.get("lastEventId")) {
+    lastIdText = req.url_params.get("lastEventId");
+  }
+  uint64_t lastId = 0;
+  bool hasLastId = false;
+  if (!lastIdText.empty()) {
+    try {
+      lastId = std::stoull(lastIdText);
+      hasLastId = true;
+    } catch (const std::exception &) {
+      hasLastId = false;
+    }
+  }
+
+  auto sub = std::make_shared<Subscriber>(*req.io_context);
+  sub->id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+  sub->res = &res;
+  sub->topics = std::move(topics);
+
+  std::vector<std::pair<uint64_t, Frame>> replay;
+  bool resync = false;
+  uint64_t currentId = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_subscriberCount >= m_maxSubscribers) {
+      m_rejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    // Replay und Registrierung unter demselben Lock: nichts geht dazwischen verloren
+    if (hasLastId && m_sharedIds && lastId > m_lastEventId &&
+        lastId - m_lastEventId <= m_replaySize) {
+      // Id von einem Worker, der schon weiter ist: diese Frames nicht doppelt schicken
+      sub->skipUpTo = lastId;
+    } else if (hasLastId) {
+      resync = !collectReplay(sub->topics, lastId, replay);
+    }
+    currentId = std::max(m_lastEventId, sub->skipUpTo);
+    m_subscriberCount++;
+    for (const auto &topic : sub->topics) m_topics[topic].emplace(sub->id, sub);
+  }
+
+  res.set_header("Content-Type", "text/event-stream");
+  res.set_header("Cache-Control", "no-cache");
+  res.set_header("Connection", "keep-alive");
+  // Reconnect-Intervall für EventSource nach jedem abgeschlossenen Response
+  // Aktuelle Id mitschicken, damit auch Clients ohne bisherige Events beim
+  // nächsten Reconnect eine Last-Event-ID haben
+  sub->buffer = "retry: " + std::to_string(m_retryMs) + "\n";
+  if (!resync) sub->buffer += "id: " + std::to_string(currentId) + "\n";
+  sub->buffer += "\n";
+
+  if (resync) {
+    m_resyncs.fetch_add(1, std::memory_order_relaxed);
+    sub->buffer += "id: " + std::to_string(currentId) + "\ndata: {\"type\":\"RESYNC\"}\n\n";
+  } else {
+    for (const auto &entry : replay) sub->buffer += *entry.second;
+    m_replayedFrames.fetch_add(replay.size(), std::memory_order_relaxed);
+  }
+
+  // Verpasstes sofort (nach dem Coalescing-Fenster) ausliefern
+  if (resync || !replay.empty()) {
+    sub->flushScheduled = true;
+    sub->flushTimer.expires_after(m_coalesce);
+    sub->flushTimer.async_wait([this, sub](const asio::error_code &ec) {
+      if (ec || sub->done) return;
+      complete(sub);
+    });
+  }
+
+  // Läuft auf dem io_context der Verbindung; kein Worker-Thread wartet
+  sub->heartbeat.expires_after(m_heartbeat);
+  sub->heartbeat.async_wait([this, sub](const asio::error_code &ec) {
+    if (ec || sub->done) return;
+    sub->buffer += ": keepalive\n\n";
+    m_heartbeats.fetch_add(1, std::memory_order_relaxed);
+    complete(sub);
+  });
+  return true;
+}
+
+void EventHub::publish(const std::string &topic, const crow::json::wvalue &payload) {
+  publishFrame(topic, "data: " + payload.dump() + "\n\n", 0);
+}
+
+void EventHub::publish(const std::string &topic, const crow::json::wvalue &payload,
+                       uint64_t id) {
+  publishFrame(topic, "data: " + payload.dump() + "\n\n", id);
+}
+
+void EventHub::resync(uint64_t missedUpTo) {
+  std::vector<std::shared_ptr<Subscriber>> targets;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Ringe enthalten nur Ids vor der Lücke: Replay darüber hinweg unmöglich
+    m_firstEventId = std::max(m_firstEventId, missedUpTo + 1);
+    m_lastEventId = std::max(m_lastEventId, missedUpTo);
+    m_logs.clear();
+    for (const auto &[topic, subs] : m_topics) {
+      for (const auto &entry : subs) targets.push_back(entry.second);
+    }
+  }
+
+  // Mit Id der Lücke: der Reconnect setzt nahtlos danach wieder auf
+  auto frame = std::make_shared<const std::string>(
+      "id: " + std::to_string(missedUpTo) + "\ndata: {\"type\":\"RESYNC\"}\n\n");
+  for (const auto &sub : targets) {
+    asio::post(*sub->io, [this, sub, frame]() {
+      if (sub->done) return; // mehrere Topics: nur einmal
+      sub->buffer += *frame;
+      complete(sub);
+    });
+  }
+}
+
+void EventHub::publishFrame(const std::string &topic, const std::string &data, uint64_t id) {
+  m_published.fetch_add(1, std::memory_order_relaxed);
+
+  // Nur die Subscriber dieses Topics; andere Gruppen merken nichts davon
+  Frame frame;
+  std::vector<std::shared_ptr<Subscriber>> targets;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Id-Vergabe und Ring unter dem Lock, damit die Reihenfolge der Ids stimmt;
+    // vorgegebene Ids (change_log.seq) kommen bereits aufsteigend
+    if (id == 0) id = m_lastEventId + 1;
+    if (id <= m_lastEventId) return; // schon ausgeliefert
+    m_lastEventId = id;
+    frame = std::make_shared<const std::string>("id: " + std::to_string(id) + "\n" + data);
+
+    auto &log = m_logs[topic];
+    log.entries.emplace_back(id, frame);
+    while (log.entries.size() > m_replaySize) {
+      log.evictedUpTo = log.entries.front().first;
+      log.entries.pop_front();
+    }
+
+    auto it = m_topics.find(topic);
+    if (it == m_topics.end()) return;
+    targets.reserve(it->second.size());
+    for (const auto &entry : it->second) targets.push_back(entry.second);
+  }
+
+  for (const auto &sub : targets) {
+    asio::post(*sub->io, [this, sub, id, frame]() { deliver(sub, id, frame); });
+  }
+}
+
+void EventHub::deliver(const std::shared_ptr<Subscriber> &sub, uint64_t id, const Frame &frame) {
+  if (sub->done || id <= sub->skipUpTo) return;
+  sub->buffer += *frame;
+  m_framesDelivered.fetch_add(1, std::memory_order_relaxed);
+
+  // Puffer voll: sofort ausliefern statt unbegrenzt zu wachsen
+  if (sub->buffer.size() >= m_maxBufferBytes) {
+    m_overflowFlushes.fetch_add(1, std::memory_order_relaxed);
+    complete(sub);
+    return;
+  }
+
+  // Kurzes Fenster: weitere Events landen im selben Response
+  if (!sub->flushScheduled) {
+    sub->flushScheduled = true;
+    sub->flushTimer.expires_after(m_coalesce);
+    sub->flushTimer.async_wait([this, sub](const asio::error_code &ec) {
+      if (ec || sub->done) return;
+      complete(sub);
+    });
+  }
+}
+
+void EventHub::complete(const std::shared_ptr<Subscriber> &sub) {
+  if (sub->done) return;
+  sub->done = true;
+  sub->heartbeat.cancel();
+  sub->flushTimer.cancel();
+  unregister(*sub);
+
+  m_flushes.fetch_add(1, std::memory_order_relaxed);
+  sub->res->write(sub->buffer);
+  sub->res->end();
+  sub->res = nullptr;
+  std::string().swap(sub->buffer);
+}
+
+void EventHub::unregister(const Subscriber &sub) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_subscriberCount--;
+  for (const auto &topic : sub.topics) {
+    auto it = m_topics.find(topic);
+    if (it == m_topics.end()) continue;
+    it->second.erase(sub.id);
+    if (it->second.empty()) m_topics.erase(it);
+  }
+}
+
+bool EventHub::collectReplay(const std::vector<std::string> &topics, uint64_t lastId,
+                             std::vector<std::pair<uint64_t, Frame>> &out) const {
+  // Id aus einem früheren Prozess oder aus der Zukunft: Ring sagt nichts darüber
+  if (lastId + 1 < m_firstEventId || lastId > m_lastEventId) return false;
+
+  for (const auto &topic : topics) {
+    auto it = m_logs.find(topic);
+    if (it == m_logs.end()) continue;
+    const auto &log = it->second;
+    if (log.evictedUpTo > lastId) return false; // Lücke größer als der Ring
+
+    auto first = std::upper_bound(
+        log.entries.begin(), log.entries.end(), lastId,
+        [](uint64_t id, const std::pair<uint64_t, Frame> &entry) { return id < entry.first; });
+    out.insert(out.end(), first, log.entries.end());
+  }
+
+  // Mehrere Topics: global nach Id ordnen
+  std::sort(out.begin(), out.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  return true;
+}
+
+EventHub::Stats EventHub::stats() const {
+  Stats s;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s.subscribers = m_subscriberCount;
+    s.topics = m_topics.size();
+    s.lastEventId = m_lastEventId;
+  }
+  s.published = m_published.load(std::memory_order_relaxed);
+  s.framesDelivered = m_framesDelivered.load(std::memory_order_relaxed);
+  s.flushes = m_flushes.load(std::memory_order_relaxed);
+  s.overflowFlushes = m_overflowFlushes.load(std::memory_order_relaxed);
+  s.heartbeats = m_heartbeats.load(std::memory_order_relaxed);
+  s.rejected = m_rejected.load(std::memory_order_relaxed);
+  s.replayedFrames = m_replayedFrames.load(std::memory_order_relaxed);
+  s.resyncs = m_resyncs.load(std::memory_order_relaxed);
+  return s;
+}
+
+} // namespace service
+} // namespace rz
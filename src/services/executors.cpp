@@ -0,0 +1,331 @@
+/**
+ * @file executors.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Named thread pools for DB, CPU and background work
+ * @version 0.5.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/executors.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace rz {
+namespace service {
+
+// --- Executor (gemeinsame Statistik) ---
+
+void Executor::run(Job &job) {
+  auto started = Clock::now();
+  uint64_t waitUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(started - job.enqueuedAt).count();
+  m_waitUsTotal.fetch_add(waitUs, std::memory_order_relaxed);
+  uint64_t prevMax = m_maxWaitUs.load(std::memory_order_relaxed);
+  while (waitUs > prevMax &&
+         !m_maxWaitUs.compare_exchange_weak(prevMax, waitUs, std::memory_order_relaxed)) {
+  }
+
+  m_active.fetch_add(1);
+  try {
+    job.fn();
+  } catch (const std::exception &e) {
+    qWarning() << "[Executor]" << m_name.c_str() << "Job-Fehler:" << e.what();
+  }
+  m_active.fetch_sub(1);
+
+  uint64_t runUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count();
+  m_runUsTotal.fetch_add(runUs, std::memory_order_relaxed);
+  m_completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Executor::fillTimings(Stats &s) const {
+  s.name = m_name;
+  s.active = m_active.load();
+  s.completed = m_completed.load(std::memory_order_relaxed);
+  s.rejected = m_rejected.load(std::memory_order_relaxed);
+  s.waitSecondsTotal = m_waitUsTotal.load(std::memory_order_relaxed) / 1e6;
+  s.runSecondsTotal = m_runUsTotal.load(std::memory_order_relaxed) / 1e6;
+  if (s.completed > 0) {
+    s.avgWaitMs = s.waitSecondsTotal * 1000.0 / s.completed;
+    s.avgRunMs = s.runSecondsTotal * 1000.0 / s.completed;
+  }
+  s.maxWaitMs = m_maxWaitUs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+int Executor::retryAfterSeconds() const {
+  Stats s = stats();
+  if (s.workers == 0) return 1;
+  double pending = static_cast<double>(s.queued + s.active) / s.workers;
+  double runMs = s.avgRunMs > 0 ? s.avgRunMs : 250.0;
+  return std::max(1, static_cast<int>(std::ceil(pending * runMs / 1000.0)));
+}
+
+// --- ThreadPool ---
+
+void ThreadPool::start(int workers, int queueCapacity) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_threads.empty()) return;
+
+  workers = std::max(1, workers);
+  m_capacity = static_cast<size_t>(std::max(0, queueCapacity));
+  m_stopping = false;
+  for (int i = 0; i < workers; ++i) {
+    m_threads.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+void ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+  for (auto &t : m_threads) {
+    if (t.joinable()) t.join();
+  }
+  m_threads.clear();
+}
+
+bool ThreadPool::post(std::function<void()> fn) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Freie Worker zählen nicht gegen die Queue-Kapazität
+    size_t idle = m_threads.size() - std::min<size_t>(m_threads.size(), m_active.load());
+    if (m_stopping || m_threads.empty() || m_queue.size() >= m_capacity + idle) {
+      m_rejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    m_queue.push_back(Job{std::move(fn), Clock::now()});
+  }
+  m_cv.notify_one();
+  return true;
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+      if (m_queue.empty()) return; // stopping & leer
+      job = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+    run(job);
+  }
+}
+
+Executor::Stats ThreadPool::stats() const {
+  Stats s;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s.workers = static_cast<int>(m_threads.size());
+    s.capacity = static_cast<int>(m_capacity);
+    s.queued = static_cast<int>(m_queue.size());
+  }
+  fillTimings(s);
+  return s;
+}
+
+// --- WorkStealingPool ---
+
+namespace {
+// Worker-Index des aktuellen Threads (für lokale Posts)
+thread_local const WorkStealingPool *t_pool = nullptr;
+thread_local size_t t_index = 0;
+} // namespace
+
+void WorkStealingPool::start(int workers, int queueCapacity) {
+  std::lock_guard<std::mutex> lock(m_sleepMutex);
+  if (!m_threads.empty()) return;
+
+  workers = std::max(1, workers);
+  m_capacity = static_cast<size_t>(std::max(0, queueCapacity));
+  m_stopping = false;
+  m_workers.clear();
+  for (int i = 0; i < workers; ++i) m_workers.push_back(std::make_unique<Worker>());
+  for (int i = 0; i < workers; ++i) {
+    m_threads.emplace_back([this, i]() { workerLoop(static_cast<size_t>(i)); });
+  }
+}
+
+void WorkStealingPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+  for (auto &t : m_threads) {
+    if (t.joinable()) t.join();
+  }
+  m_threads.clear();
+}
+
+bool WorkStealingPool::post(std::function<void()> fn) {
+  const size_t count = m_workers.size();
+  if (count == 0 || m_stopping) {
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Platz vor dem Push reservieren: ein Dieb kann den Job sofort nehmen und
+  // dekrementieren, der Zähler darf dabei nicht unter 0 fallen
+  const int limit = static_cast<int>(std::min<size_t>(m_capacity + count, INT_MAX));
+  if (m_queued.fetch_add(1, std::memory_order_acq_rel) >= limit) {
+    m_queued.fetch_sub(1, std::memory_order_acq_rel);
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Vom eigenen Worker: lokal (Folgearbeit bleibt im Cache), sonst reihum
+  size_t index = t_pool == this ? t_index
+                                : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % count;
+  {
+    std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+    m_workers[index]->jobs.push_back(Job{std::move(fn), Clock::now()});
+  }
+
+  // Kurz locken, damit kein Worker zwischen Prüfung und wait() den Wakeup verpasst
+  { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+  m_cv.notify_one();
+  return true;
+}
+
+bool WorkStealingPool::popLocal(size_t index, Job &job) {
+  auto &worker = *m_workers[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.jobs.empty()) return false;
+  job = std::move(worker.jobs.back());
+  worker.jobs.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::steal(size_t index, Job &job) {
+  const size_t count = m_workers.size();
+  for (size_t k = 1; k < count; ++k) {
+    auto &victim = *m_workers[(index + k) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.jobs.empty()) continue;
+    // Ältesten Job nehmen: der Besitzer arbeitet am anderen Ende
+    job = std::move(victim.jobs.front());
+    victim.jobs.pop_front();
+    m_stolen.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+  t_pool = this;
+  t_index = index;
+
+  while (true) {
+    Job job;
+    if (popLocal(index, job) || steal(index, job)) {
+      m_queued.fetch_sub(1, std::memory_order_acq_rel);
+      run(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_cv.wait(lock, [this] { return m_stopping || m_queued.load(std::memory_order_acquire) > 0; });
+    if (m_stopping && m_queued.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+Executor::Stats WorkStealingPool::stats() const {
+  Stats s;
+  s.workers = static_cast<int>(m_workers.size());
+  s.capacity = static_cast<int>(m_capacity);
+  s.queued = m_queued.load(std::memory_order_relaxed);
+  s.stolen = m_stolen.load(std::memory_order_relaxed);
+  fillTimings(s);
+  return s;
+}
+
+// --- Executors ---
+
+namespace {
+
+struct PoolDefaults {
+  const char *name;
+  const char *env; // CAKE_POOL_<env>_THREADS / _QUEUE
+  int threads;
+  int queue;
+};
+
+int hardwareThreads() {
+  return std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+} // namespace
+
+Executors::Executors() {
+  m_pools[static_cast<size_t>(Pool::DbRead)] = std::make_unique<ThreadPool>("db-read");
+  m_pools[static_cast<size_t>(Pool::DbWrite)] = std::make_unique<ThreadPool>("db-write");
+  m_pools[static_cast<size_t>(Pool::Cpu)] = std::make_unique<WorkStealingPool>("cpu");
+  m_pools[static_cast<size_t>(Pool::Background)] = std::make_unique<ThreadPool>("background");
+}
+
+Executors::~Executors() { stop(); }
+
+Executors &Executors::instance() {
+  static Executors instance;
+  return instance;
+}
+
+void Executors::start() {
+  if (m_started) return;
+  m_started = true;
+
+  // Prefork: die Kerne teilen sich alle Worker-Prozesse
+  const int processes = std::max(1, rz::utils::EnvLoader::getInt("CAKE_WORKERS", 1));
+  const int hw = std::max(2, hardwareThreads() / processes);
+  m_httpThreads = std::max(1, rz::utils::EnvLoader::getInt("CAKE_HTTP_THREADS", hw));
+
+  // Reihenfolge wie enum Pool
+  const PoolDefaults defaults[POOL_COUNT] = {
+      {"db-read", "DB_READ", std::min(hw, 8), 512},
+      {"db-write", "DB_WRITE", 1, 1024},
+      {"cpu", "CPU", hw, 1024},
+      {"background", "BACKGROUND", 1, 1024},
+  };
+
+  for (size_t i = 0; i < POOL_COUNT; ++i) {
+    const auto &d = defaults[i];
+    std::string prefix = std::string("CAKE_POOL_") + d.env;
+    int threads = rz::utils::EnvLoader::getInt(prefix + "_THREADS", d.threads);
+    int queue = rz::utils::EnvLoader::getInt(prefix + "_QUEUE", d.queue);
+    m_pools[i]->start(threads, queue);
+    qInfo() << "[Executor]" << d.name << ":" << std::max(1, threads) << "Threads, Queue" << queue;
+  }
+  qInfo() << "[Executor] HTTP:" << m_httpThreads << "Threads";
+}
+
+void Executors::stop() {
+  // Hintergrund zuerst, DB-Writer zuletzt (nimmt noch Arbeit der anderen an)
+  for (Pool pool : {Pool::Background, Pool::Cpu, Pool::DbRead, Pool::DbWrite}) {
+    m_pools[static_cast<size_t>(pool)]->stop();
+  }
+}
+
+Executor &Executors::get(Pool pool) { return *m_pools[static_cast<size_t>(pool)]; }
+
+std::vector<Executor::Stats> Executors::stats() const {
+  std::vector<Executor::Stats> result;
+  result.reserve(POOL_COUNT);
+  for (const auto &pool : m_pools) result.push_back(pool->stats());
+  return result;
+}
+
+} // namespace service
+} // namespace rz
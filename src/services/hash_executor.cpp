@@ -0,0 +1,158 @@
+/**
+ * @file hash_executor.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Bounded executor for Argon2 password hashing
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/hash_executor.hpp"
+#include "services/executors.hpp"
+#include "utils/metrics.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace rz {
+namespace service {
+
+HashExecutor &HashExecutor::instance() {
+  static HashExecutor instance;
+  return instance;
+}
+
+void HashExecutor::start(int workers, int queueCapacity) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_workers = std::max(1, workers);
+  m_capacity = static_cast<size_t>(std::max(0, queueCapacity));
+  m_stopping = false;
+  qInfo() << "HashExecutor: max." << m_workers << "parallele Hashes (CPU-Pool), Queue"
+          << m_capacity;
+}
+
+void HashExecutor::stop() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stopping = true;
+}
+
+bool HashExecutor::enqueue(std::function<void()> fn) {
+  Job job{std::move(fn), Clock::now()};
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+      m_rejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    // Alle Slots belegt: warten, solange Platz in der Queue ist
+    if (m_active.load() >= m_workers) {
+      if (m_queue.size() >= m_capacity) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      m_queue.push_back(std::move(job));
+      return true;
+    }
+    m_active.fetch_add(1);
+  }
+  return launch(std::move(job));
+}
+
+bool HashExecutor::launch(Job job) {
+  auto shared = std::make_shared<Job>(std::move(job));
+  bool posted = Executors::instance().get(Executors::Pool::Cpu).post(
+      [this, shared]() { runSlot(std::move(*shared)); });
+
+  if (!posted) {
+    // CPU-Pool voll oder nicht gestartet: Slot freigeben
+    m_active.fetch_sub(1);
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+  }
+  return posted;
+}
+
+void HashExecutor::runSlot(Job job) {
+  // Slot auch dann freigeben, wenn ein Job wirft
+  struct SlotRelease {
+    std::atomic<int> &active;
+    bool armed = true;
+    ~SlotRelease() {
+      if (armed) active.fetch_sub(1);
+    }
+  } release{m_active};
+
+  // Wartende Jobs im selben Slot nacheinander abarbeiten: kein erneutes
+  // post(), das an einem vollen CPU-Pool scheitern und den Job verlieren könnte
+  while (true) {
+    runJob(job);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty()) {
+      // Unter dem Lock, damit enqueue() nicht noch in die Queue legt
+      release.armed = false;
+      m_active.fetch_sub(1);
+      return;
+    }
+    job = std::move(m_queue.front());
+    m_queue.pop_front();
+  }
+}
+
+void HashExecutor::runJob(Job &job) {
+  static auto &waitHistogram = rz::utils::MetricsRegistry::instance().histogram(
+      "cake_hash_queue_wait_seconds", "Argon2 jobs: time from submit to start.");
+  static auto &runHistogram = rz::utils::MetricsRegistry::instance().histogram(
+      "cake_hash_run_seconds", "Argon2 jobs: hash computation time.");
+
+  auto started = Clock::now();
+  waitHistogram.observe(started - job.enqueuedAt);
+  uint64_t waitUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(started - job.enqueuedAt).count();
+  m_waitUsTotal.fetch_add(waitUs, std::memory_order_relaxed);
+  uint64_t prevMax = m_maxWaitUs.load(std::memory_order_relaxed);
+  while (waitUs > prevMax &&
+         !m_maxWaitUs.compare_exchange_weak(prevMax, waitUs, std::memory_order_relaxed)) {
+  }
+
+  job.fn();
+
+  uint64_t runUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       Clock::now() - started).count();
+  m_runUsTotal.fetch_add(runUs, std::memory_order_relaxed);
+  runHistogram.observe(std::chrono::microseconds(runUs));
+  m_completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+HashExecutor::Stats HashExecutor::stats() const {
+  Stats s;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s.workers = m_workers;
+    s.capacity = static_cast<int>(m_capacity);
+    s.queued = static_cast<int>(m_queue.size());
+  }
+  s.active = m_active.load();
+  s.completed = m_completed.load(std::memory_order_relaxed);
+  s.rejected = m_rejected.load(std::memory_order_relaxed);
+  if (s.completed > 0) {
+    s.avgWaitMs = m_waitUsTotal.load(std::memory_order_relaxed) / 1000.0 / s.completed;
+    s.avgRunMs = m_runUsTotal.load(std::memory_order_relaxed) / 1000.0 / s.completed;
+  }
+  s.maxWaitMs = m_maxWaitUs.load(std::memory_order_relaxed) / 1000.0;
+  return s;
+}
+
+int HashExecutor::retryAfterSeconds() const {
+  Stats s = stats();
+  if (s.workers == 0) return 1;
+  double pending = static_cast<double>(s.queued + s.active) / s.workers;
+  double runMs = s.avgRunMs > 0 ? s.avgRunMs : 250.0;
+  return std::max(1, static_cast<int>(std::ceil(pending * runMs / 1000.0)));
+}
+
+} // namespace service
+} // namespace rz
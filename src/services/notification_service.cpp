@@ -2,8 +2,8 @@
  * @file notification_service.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Notification Service Implementation
- * @version 0.1.0
- * @date 2026-01-03
+ * @version 0.7.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,60 +12,204 @@
 
 #include "services/notification_service.hpp"
 #include "database.hpp"
+#include "models/digest_model.hpp"
+#include "models/notification_job_model.hpp"
+#include "models/outbox_model.hpp"
+#include "services/change_bus.hpp"
+#include "services/notification_worker.hpp"
+#include "services/outbox_dispatcher.hpp"
+#include "utils/env_loader.hpp"
+#include <QDateTime>
 #include <QSqlQuery>
+#include <QJsonObject>
 #include <QVariant>
 #include <QDebug>
 
 namespace rz {
 namespace service {
 
-NotificationService::NotificationService(SmtpService* smtp)
-    : m_smtp(smtp) {}
+NotificationService::NotificationService(OutboxDispatcher* dispatcher)
+    : m_dispatcher(dispatcher) {
+    m_dailyHour = rz::utils::EnvLoader::getInt("CAKE_DIGEST_DAILY_HOUR", 7);
+}
+
+void NotificationService::dispatch() {
+    // Prefork: die Pipeline läuft nur in Worker 0, ihn über den Bus wecken
+    if (!m_worker && !m_dispatcher) {
+        rz::service::ChangeBus::instance().wakeNotifications();
+        return;
+    }
+    if (m_worker) m_worker->wake();
+    if (m_dispatcher) m_dispatcher->wake();
+}
+
+bool NotificationService::enqueue(const QString& kind, const QString& reference, const QString& to,
+                                  const QString& fairnessKey, const rz::utils::RenderedMail& mail) {
+    OutboxMessage msg;
+    msg.priority = kind == "new_user" ? OutboxMessage::High
+                 : kind == "digest"   ? OutboxMessage::Bulk
+                                      : OutboxMessage::Normal;
+    msg.fairnessKey = fairnessKey;
+    msg.id = OutboxMessage::makeId(kind, reference, to);
+    msg.recipient = to;
+    msg.subject = mail.subject;
+    msg.body = mail.text;
+    msg.htmlBody = mail.html;
+    return msg.enqueue();
+}
+
+bool NotificationService::deliver(const Recipient& to, const QString& kind, const QString& reference,
+                                  const QString& fairnessKey, const rz::utils::TemplateVars& vars) {
+    const auto& templates = rz::utils::MailTemplates::instance();
+    rz::utils::TemplateVars personal = vars;
+    personal["name"] = to.name;
+
+    if (to.digest.isEmpty() || to.digest == DigestItem::IMMEDIATE) {
+        return enqueue(kind, reference, to.email, fairnessKey, templates.render(kind, to.language, personal));
+    }
+
+    DigestItem item;
+    item.recipient = to.email;
+    item.language = to.language;
+    item.kind = kind;
+    item.reference = reference;
+    item.line = templates.renderPart(kind, to.language, rz::utils::MailTemplates::Line, personal);
+    item.dueAt = DigestItem::windowEnd(to.digest, QDateTime::currentSecsSinceEpoch(), m_dailyHour);
+    return item.add();
+}
 
-std::vector<QString> NotificationService::getGlobalAdminEmails() {
-    std::vector<QString> emails;
+std::vector<NotificationService::Recipient> NotificationService::getGlobalAdmins() {
+    std::vector<Recipient> admins;
     auto db = DatabaseManager::instance().getDatabase();
     QSqlQuery query(db);
     // Hole alle User mit is_admin = 1
-    query.prepare("SELECT email FROM users WHERE is_admin = 1 AND is_active = 1");
+    query.prepare("SELECT email, full_name, email_language, notify_digest FROM users WHERE is_admin = 1 AND is_active = 1");
     if (query.exec()) {
         while (query.next()) {
-            emails.push_back(query.value("email").toString());
+            admins.push_back({query.value("email").toString(),
+                              query.value("full_name").toString(),
+                              query.value("email_language").toString(),
+                              query.value("notify_digest").toString()});
         }
     }
-    return emails;
+    return admins;
 }
 
-void NotificationService::notifyAdminsNewUser(const QString& newUserName, const QString& newUserEmail) {
-    auto admins = getGlobalAdminEmails();
+bool NotificationService::notifyAdminsNewUser(const QString& newUserName, const QString& newUserEmail) {
+    auto admins = getGlobalAdmins();
     if (admins.empty()) {
         qWarning() << "No admins found to notify.";
-        return;
+        return true;
     }
 
-    QString subject = "CakePlanner: Neuer User registriert";
-    QString body = QString("Ein neuer User hat sich registriert:\n\nName: %1\nEmail: %2\n\nBitte prüfen und ggf. Gruppe zuweisen.")
-                   .arg(newUserName, newUserEmail);
+    rz::utils::TemplateVars vars{{"userName", newUserName}, {"userEmail", newUserEmail}};
 
-    for (const auto& adminEmail : admins) {
-        m_smtp->sendEmailAsync(adminEmail, subject, body);
+    bool ok = true;
+    for (const auto& admin : admins) {
+        ok = deliver(admin, "new_user", newUserEmail, "admin", vars) && ok;
     }
+    return ok;
 }
 
-void NotificationService::notifyGroupNewEvent(const QString& groupName, const QString& bakerName, const QString& date, const std::vector<QString>& recipientsDe, const std::vector<QString>& recipientsEn) {
-    // Deutsch
-    if (!recipientsDe.empty()) {
-        QString subject = QString("Neuer Kuchen in %1!").arg(groupName);
-        QString body = QString("Hallo,\n\n%1 bringt am %2 einen Kuchen mit!\n\nYummy!").arg(bakerName, date);
-        for (const auto& mail : recipientsDe) m_smtp->sendEmailAsync(mail, subject, body);
+bool NotificationService::notifyGroupNewEvent(const QString& eventId, const QString& groupId, const QString& groupName, const QString& bakerId, const QString& bakerName, const QString& date) {
+    QJsonObject payload;
+    payload["eventId"] = eventId;
+    payload["groupId"] = groupId;
+    payload["groupName"] = groupName;
+    payload["bakerId"] = bakerId;
+    payload["bakerName"] = bakerName;
+    payload["date"] = date;
+    return NotificationJob::enqueue("new_event", eventId, payload);
+}
+
+bool NotificationService::processJob(const NotificationJob& job, QString& error) {
+    if (job.kind == "new_event") {
+        const auto& p = job.payload;
+        std::vector<Recipient> recipients;
+        if (!getGroupRecipients(p["groupId"].toString(), p["bakerId"].toString(), recipients)) {
+            error = "Could not resolve group recipients";
+            return false;
+        }
+
+        QString eventId = p["eventId"].toString();
+        QString groupId = p["groupId"].toString();
+        rz::utils::TemplateVars vars{{"group", p["groupName"].toString()},
+                                     {"baker", p["bakerName"].toString()},
+                                     {"date", p["date"].toString()}};
+
+        for (const auto& r : recipients) {
+            if (!deliver(r, "new_event", eventId, groupId, vars)) {
+                error = "Could not write outbox";
+                return false;
+            }
+        }
+        return true;
     }
 
-    // Englisch
-    if (!recipientsEn.empty()) {
-        QString subject = QString("New Cake in %1!").arg(groupName);
-        QString body = QString("Hello,\n\n%1 is bringing a cake on %2!\n\nYummy!").arg(bakerName, date);
-        for (const auto& mail : recipientsEn) m_smtp->sendEmailAsync(mail, subject, body);
+    // Unbekannte Jobs nicht endlos wiederholen
+    qWarning() << "Unknown notification job kind:" << job.kind;
+    return true;
+}
+
+bool NotificationService::getGroupRecipients(const QString& groupId, const QString& excludeUserId, std::vector<Recipient>& recipients) {
+    auto db = DatabaseManager::instance().getDatabase();
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT u.email, u.full_name, u.email_language, u.notify_digest
+        FROM users u
+        JOIN group_members gm ON gm.user_id = u.id
+        WHERE gm.group_id = :gid AND u.id != :exclude
+          AND u.is_active = 1 AND u.notify_new_events = 1
+    )");
+    query.bindValue(":gid", groupId);
+    query.bindValue(":exclude", excludeUserId);
+    if (!query.exec()) return false;
+
+    while (query.next()) {
+        recipients.push_back({query.value("email").toString(),
+                              query.value("full_name").toString(),
+                              query.value("email_language").toString(),
+                              query.value("notify_digest").toString()});
     }
+    return true;
+}
+
+int NotificationService::flushDigests(int maxRecipients) {
+    auto db = DatabaseManager::instance().getDatabase();
+    int sent = 0;
+
+    for (const auto& recipient : DigestItem::dueRecipients(QDateTime::currentSecsSinceEpoch(), maxRecipients)) {
+        // Alle offenen Items des Empfängers in eine Mail (auch noch nicht fällige)
+        db.transaction();
+        auto items = DigestItem::getForRecipient(recipient);
+        if (items.empty()) {
+            db.rollback();
+            continue;
+        }
+
+        QString itemsText, itemsHtml;
+        for (const auto& item : items) {
+            itemsText += "- " + item.line + "\n";
+            itemsHtml += "<li>" + rz::utils::MailTemplates::escapeHtml(item.line) + "</li>";
+        }
+        rz::utils::TemplateVars vars{{"count", QString::number(items.size())},
+                                     {"items", itemsText},
+                                     {"itemsHtml", itemsHtml}};
+        auto mail = rz::utils::MailTemplates::instance().render("digest", items.back().language, vars);
+
+        // Referenz = letzte Item-ID -> erneuter Flush nach Absturz bleibt idempotent
+        qint64 maxId = items.back().id;
+        if (enqueue("digest", QString::number(maxId), recipient, "digest", mail) &&
+            DigestItem::removeUpTo(recipient, maxId) && db.commit()) {
+            sent++;
+        } else {
+            db.rollback();
+            qWarning() << "[Digest] Flush fehlgeschlagen für" << recipient;
+        }
+    }
+
+    if (sent > 0 && m_dispatcher) m_dispatcher->wake();
+    return sent;
 }
 
 } // namespace service
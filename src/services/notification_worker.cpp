@@ -0,0 +1,162 @@
+/**
+ * @file notification_worker.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Background fan-out of notification jobs into the e-mail outbox
+ * @version 0.5.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/notification_worker.hpp"
+#include "database.hpp"
+#include "models/notification_job_model.hpp"
+#include "models/session_model.hpp"
+#include "services/executors.hpp"
+#include "services/notification_service.hpp"
+#include "services/outbox_dispatcher.hpp"
+#include "utils/env_loader.hpp"
+#include "utils/revocation_list.hpp"
+#include "utils/token_utils.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMetaObject>
+#include <QTimer>
+#include <algorithm>
+
+namespace rz {
+namespace service {
+
+// Erledigte Jobs einen Tag aufheben (Nachvollziehbarkeit)
+static constexpr qint64 DONE_RETENTION_SEC = 24 * 3600;
+static constexpr qint64 RETRY_BASE_SEC = 30;
+
+NotificationWorker::NotificationWorker(NotificationService* service, OutboxDispatcher* outbox,
+                                       QObject* parent)
+    : QObject(parent), m_service(service), m_outbox(outbox) {
+    m_batchSize = rz::utils::EnvLoader::getInt("CAKE_NOTIFY_BATCH", 20);
+    m_maxAttempts = rz::utils::EnvLoader::getInt("CAKE_NOTIFY_MAX_ATTEMPTS", 5);
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(rz::utils::EnvLoader::getInt("CAKE_NOTIFY_POLL_MS", 2000));
+    connect(m_pollTimer, &QTimer::timeout, this, &NotificationWorker::drain);
+
+    // Digest-Fenster enden auf volle Stunden: minütlich prüfen reicht
+    m_digestTimer = new QTimer(this);
+    m_digestTimer->setInterval(rz::utils::EnvLoader::getInt("CAKE_DIGEST_CHECK_MS", 60000));
+    connect(m_digestTimer, &QTimer::timeout, this, &NotificationWorker::flushDigests);
+
+    m_housekeepingTimer = new QTimer(this);
+    m_housekeepingTimer->setInterval(3600 * 1000);
+    connect(m_housekeepingTimer, &QTimer::timeout, this, &NotificationWorker::housekeeping);
+}
+
+void NotificationWorker::start() {
+    int recovered = NotificationJob::resetInFlight();
+    if (recovered > 0) {
+        qInfo() << "[Notify]" << recovered << "unterbrochene Jobs erneut eingeplant";
+    }
+    m_pollTimer->start();
+    m_digestTimer->start();
+    m_housekeepingTimer->start();
+    wake();
+}
+
+void NotificationWorker::wake() {
+    QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void NotificationWorker::drain() {
+    // Ein Batch zur Zeit; der nächste Poll oder batchDone() holt den Rest
+    if (m_running) return;
+    m_running = true;
+
+    // Empfänger auflösen und Outbox füllen nicht im Qt-Thread (SMTP, Outbox)
+    auto run = [this]() {
+        int claimed = 0;
+        bool queuedMail = processBatch(claimed);
+        QMetaObject::invokeMethod(
+            this, [this, queuedMail, claimed]() { batchDone(queuedMail, claimed); },
+            Qt::QueuedConnection);
+    };
+    if (!Executors::instance().get(Executors::Pool::DbWrite).post(run)) {
+        m_running = false; // Pool voll: nächster Poll
+    }
+}
+
+void NotificationWorker::batchDone(bool queuedMail, int claimed) {
+    m_running = false;
+    if (queuedMail && m_outbox) m_outbox->wake();
+
+    // Volle Batch: es warten vermutlich weitere Jobs
+    if (claimed == m_batchSize) wake();
+}
+
+bool NotificationWorker::processBatch(int& claimed) {
+    auto db = DatabaseManager::instance().getDatabase();
+    bool queuedMail = false;
+
+    auto jobs = NotificationJob::claimBatch(m_batchSize);
+    claimed = static_cast<int>(jobs.size());
+    for (const auto& job : jobs) {
+        // Empfänger auflösen + Outbox füllen + Job abschließen: alles oder nichts
+        db.transaction();
+        QString error;
+        if (m_service->processJob(job, error) && NotificationJob::markDone(job.id) && db.commit()) {
+            queuedMail = true;
+            continue;
+        }
+        db.rollback();
+
+        int attempt = job.attempts + 1;
+        bool dead = attempt >= m_maxAttempts;
+        qint64 delay = std::min<qint64>(RETRY_BASE_SEC << std::clamp(attempt - 1, 0, 10), 3600);
+        NotificationJob::markFailed(job.id, error.isEmpty() ? db.lastError().text() : error,
+                                    QDateTime::currentSecsSinceEpoch() + delay, dead);
+        qWarning() << "[Notify] Job" << job.id << "fehlgeschlagen:" << error;
+    }
+    return queuedMail;
+}
+
+void NotificationWorker::flushDigests() {
+    if (m_digestRunning) return;
+    m_digestRunning = true;
+
+    // Gleicher Grund wie drain(); weckt die Outbox selbst (thread-safe)
+    auto run = [this]() {
+        int sent = m_service->flushDigests(m_batchSize * 10);
+        if (sent > 0) {
+            qInfo() << "[Notify]" << sent << "Digest-Mails eingeplant";
+        }
+        QMetaObject::invokeMethod(
+            this, [this]() { m_digestRunning = false; }, Qt::QueuedConnection);
+    };
+    if (!Executors::instance().get(Executors::Pool::DbWrite).post(run)) {
+        m_digestRunning = false;
+    }
+}
+
+void NotificationWorker::housekeeping() {
+    // Großes DELETE nicht im Qt-Thread (SMTP, Outbox) ausführen
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    qint64 cutoff = now - DONE_RETENTION_SEC;
+    auto purge = [now, cutoff]() {
+        NotificationJob::purgeDone(cutoff);
+
+        // Abgelaufene und widerrufene Sessions, deren Access Tokens nicht mehr gelten
+        int sessions = Session::purgeStale(rz::utils::TokenUtils::accessTokenTtl());
+        size_t revoked = rz::utils::RevocationList::instance().prune(now);
+        if (sessions > 0 || revoked > 0) {
+            qInfo() << "[Housekeeping]" << sessions << "Sessions gelöscht," << revoked
+                    << "Widerrufe verworfen";
+        }
+    };
+    auto& background = Executors::instance().get(Executors::Pool::Background);
+    if (!background.post(purge)) purge();
+}
+
+} // namespace service
+} // namespace rz
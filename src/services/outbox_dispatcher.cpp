@@ -0,0 +1,133 @@
+/**
+ * @file outbox_dispatcher.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Drains the e-mail outbox with retries and exponential backoff
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/outbox_dispatcher.hpp"
+#include "models/outbox_model.hpp"
+#include "services/send_scheduler.hpp"
+#include "services/smtp_service.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMetaObject>
+#include <QTimer>
+#include <algorithm>
+
+namespace rz {
+namespace service {
+
+// Versendete Mails bleiben 7 Tage zur Nachverfolgung in der Tabelle
+static constexpr qint64 SENT_RETENTION_SEC = 7 * 24 * 3600;
+
+// Obergrenze für SQL-Parameter beim Ausfiltern gedrosselter Domains
+static constexpr int MAX_EXCLUDED_DOMAINS = 256;
+
+OutboxDispatcher::OutboxDispatcher(SmtpService* smtp, QObject* parent)
+    : QObject(parent), m_smtp(smtp) {
+    m_batchSize = rz::utils::EnvLoader::getInt("CAKE_OUTBOX_BATCH", 50);
+    m_maxAttempts = rz::utils::EnvLoader::getInt("CAKE_OUTBOX_MAX_ATTEMPTS", 8);
+    m_backoffBaseSec = rz::utils::EnvLoader::getInt("CAKE_OUTBOX_BACKOFF_BASE_SEC", 30);
+    m_backoffMaxSec = rz::utils::EnvLoader::getInt("CAKE_OUTBOX_BACKOFF_MAX_SEC", 3600);
+
+    SendScheduler::instance().configureFromEnv();
+
+    // Gedrosselte Mails: erneut versuchen, sobald wieder Tokens da sind
+    m_throttleTimer = new QTimer(this);
+    m_throttleTimer->setSingleShot(true);
+    connect(m_throttleTimer, &QTimer::timeout, this, &OutboxDispatcher::drain);
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(rz::utils::EnvLoader::getInt("CAKE_OUTBOX_POLL_MS", 2000));
+    connect(m_pollTimer, &QTimer::timeout, this, &OutboxDispatcher::drain);
+
+    m_housekeepingTimer = new QTimer(this);
+    m_housekeepingTimer->setInterval(3600 * 1000);
+    connect(m_housekeepingTimer, &QTimer::timeout, this, &OutboxDispatcher::housekeeping);
+}
+
+void OutboxDispatcher::start() {
+    int recovered = OutboxMessage::resetInFlight();
+    if (recovered > 0) {
+        qInfo() << "[Outbox]" << recovered << "unterbrochene Mails erneut eingeplant";
+    }
+    m_pollTimer->start();
+    m_housekeepingTimer->start();
+    wake();
+}
+
+void OutboxDispatcher::wake() {
+    QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void OutboxDispatcher::drain() {
+    // Nicht mehr als einen Batch gleichzeitig an SMTP übergeben
+    if (m_inFlight > 0) return;
+
+    // Mehr Kandidaten laden, als versendet werden: der Scheduler wählt nach
+    // Priorität, Gruppen-Fairness und Domain-Limits aus. Pro Gruppe höchstens
+    // ein Batch, gedrosselte Domains gar nicht erst laden
+    auto& scheduler = SendScheduler::instance();
+    auto candidates = OutboxMessage::fetchDue(m_batchSize * 4, m_batchSize,
+                                              scheduler.blockedDomains(MAX_EXCLUDED_DOMAINS));
+    if (candidates.empty()) return;
+
+    auto batch = scheduler.select(candidates, m_batchSize);
+    if (batch.size() < candidates.size() && !m_throttleTimer->isActive()) {
+        m_throttleTimer->start(std::max(scheduler.msUntilNextToken(), 1000));
+    }
+    if (batch.empty() || !OutboxMessage::claim(batch)) return;
+
+    for (const auto& msg : batch) {
+        m_inFlight++;
+        QString id = msg.id;
+        int attempts = msg.attempts;
+        m_smtp->sendEmail(msg.recipient, msg.subject, msg.body, msg.htmlBody,
+                          [this, id, attempts](bool ok, const QString& error) {
+                              onSent(id, attempts, ok, error);
+                          });
+    }
+}
+
+void OutboxDispatcher::onSent(const QString& id, int attempts, bool ok, const QString& error) {
+    if (ok) {
+        OutboxMessage::markSent(id);
+    } else {
+        int attempt = attempts + 1;
+        bool dead = attempt >= m_maxAttempts;
+        qint64 next = QDateTime::currentSecsSinceEpoch() + backoffSeconds(attempt);
+        OutboxMessage::markFailed(id, error, next, dead);
+        if (dead) {
+            qWarning() << "[Outbox] Mail" << id << "nach" << attempt
+                       << "Versuchen in die Dead-Letters verschoben";
+        }
+    }
+
+    // Batch fertig: sofort den nächsten holen, falls weitere fällig sind
+    if (--m_inFlight == 0) wake();
+}
+
+qint64 OutboxDispatcher::backoffSeconds(int attempts) const {
+    // base * 2^(attempts-1), gedeckelt
+    int shift = std::clamp(attempts - 1, 0, 20);
+    qint64 delay = static_cast<qint64>(m_backoffBaseSec) << shift;
+    return std::min<qint64>(delay, m_backoffMaxSec);
+}
+
+void OutboxDispatcher::housekeeping() {
+    int purged = OutboxMessage::purgeSent(QDateTime::currentSecsSinceEpoch() - SENT_RETENTION_SEC);
+    if (purged > 0) {
+        qInfo() << "[Outbox]" << purged << "versendete Mails aufgeräumt";
+    }
+}
+
+} // namespace service
+} // namespace rz
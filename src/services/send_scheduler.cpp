@@ -0,0 +1,215 @@
+/**
+ * @file send_scheduler.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Provider-aware throttling, priorities and fairness for outbound mail
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/send_scheduler.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <unordered_set>
+
+namespace rz {
+namespace service {
+
+// Ab dieser Größe werden voll aufgefüllte Domain-Buckets entfernt
+static constexpr size_t DOMAIN_SWEEP_THRESHOLD = 1024;
+
+void SendScheduler::Bucket::refill(qint64 nowMs) {
+    if (perMs <= 0.0) return;
+    tokens = std::min(burst, tokens + (nowMs - lastMs) * perMs);
+    lastMs = nowMs;
+}
+
+bool SendScheduler::Bucket::available(qint64 nowMs) {
+    if (perMs <= 0.0) return true;
+    refill(nowMs);
+    return tokens >= 1.0;
+}
+
+SendScheduler &SendScheduler::instance() {
+    static SendScheduler instance;
+    return instance;
+}
+
+SendScheduler::SendScheduler() {
+    m_clock.start();
+}
+
+SendScheduler::Bucket SendScheduler::makeBucket(double perMinute, double burst) const {
+    Bucket b;
+    b.perMs = perMinute / 60000.0;
+    b.burst = std::max(1.0, burst);
+    b.tokens = b.burst;
+    b.lastMs = m_clock.elapsed();
+    return b;
+}
+
+void SendScheduler::configureFromEnv() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double perMin = rz::utils::EnvLoader::getInt("CAKE_SMTP_RATE_PER_MIN", 60);
+    double burst = rz::utils::EnvLoader::getInt("CAKE_SMTP_BURST", 20);
+    m_global = makeBucket(perMin, burst);
+
+    m_domainPerMinute = rz::utils::EnvLoader::getInt("CAKE_SMTP_DOMAIN_RATE_PER_MIN", 30);
+    m_domainBurst = rz::utils::EnvLoader::getInt("CAKE_SMTP_DOMAIN_BURST", 10);
+
+    // Format: "gmail.com=20:5,web.de=10" (pro Minute[:Burst])
+    m_domainOverrides.clear();
+    m_domains.clear();
+    const QString spec = rz::utils::EnvLoader::get("CAKE_SMTP_DOMAIN_LIMITS", "");
+    for (const QString &entry : spec.split(',', Qt::SkipEmptyParts)) {
+        QString domain = entry.section('=', 0, 0).trimmed().toLower();
+        QString limits = entry.section('=', 1);
+        bool ok = false;
+        double rate = limits.section(':', 0, 0).toDouble(&ok);
+        if (domain.isEmpty() || !ok) {
+            qWarning() << "[Mail] Ungültiges Domain-Limit ignoriert:" << entry;
+            continue;
+        }
+        double domainBurst = limits.contains(':') ? limits.section(':', 1).toDouble() : m_domainBurst;
+        m_domainOverrides[domain] = {rate, domainBurst};
+    }
+
+    qInfo() << "[Mail] Versandlimit global" << perMin << "/min (Burst" << burst << "), pro Domain"
+            << m_domainPerMinute << "/min," << m_domainOverrides.size() << "Domain-Overrides";
+}
+
+QString SendScheduler::domainOf(const QString &recipient) {
+    return recipient.section('@', -1).trimmed().toLower();
+}
+
+SendScheduler::Bucket &SendScheduler::domainBucket(const QString &domain, qint64 nowMs) {
+    auto it = m_domains.find(domain);
+    if (it != m_domains.end()) return it->second;
+
+    if (m_domains.size() >= DOMAIN_SWEEP_THRESHOLD) {
+        std::erase_if(m_domains, [nowMs](auto &entry) {
+            entry.second.refill(nowMs);
+            return entry.second.tokens >= entry.second.burst;
+        });
+    }
+
+    auto limits = m_domainOverrides.find(domain);
+    Bucket b = limits != m_domainOverrides.end()
+                   ? makeBucket(limits->second.first, limits->second.second)
+                   : makeBucket(m_domainPerMinute, m_domainBurst);
+    return m_domains.emplace(domain, b).first->second;
+}
+
+std::vector<OutboxMessage> SendScheduler::select(const std::vector<OutboxMessage> &candidates,
+                                                 int max) {
+    std::vector<OutboxMessage> picked;
+    if (candidates.empty() || max <= 0) return picked;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    qint64 nowMs = m_clock.elapsed();
+    qint64 nowSec = QDateTime::currentSecsSinceEpoch();
+
+    // Pro Priorität: Warteschlangen je Fairness-Key in Ankunftsreihenfolge
+    std::map<int, std::vector<std::pair<QString, std::deque<const OutboxMessage *>>>> classes;
+    for (const auto &msg : candidates) {
+        auto &queues = classes[msg.priority];
+        auto it = std::find_if(queues.begin(), queues.end(),
+                               [&](const auto &q) { return q.first == msg.fairnessKey; });
+        if (it == queues.end()) {
+            queues.push_back({msg.fairnessKey, {}});
+            it = std::prev(queues.end());
+        }
+        it->second.push_back(&msg);
+    }
+
+    std::unordered_set<QString> blockedDomains;
+    for (auto &[priority, queues] : classes) {
+        // Round-Robin über die Gruppen dieser Klasse
+        bool progress = true;
+        while (progress && static_cast<int>(picked.size()) < max) {
+            progress = false;
+            for (auto &[key, queue] : queues) {
+                if (static_cast<int>(picked.size()) >= max) break;
+
+                // Nächste Mail dieser Gruppe, deren Domain noch Tokens hat
+                while (!queue.empty()) {
+                    const OutboxMessage *msg = queue.front();
+                    QString domain = domainOf(msg->recipient);
+                    if (blockedDomains.count(domain)) {
+                        queue.pop_front();
+                        continue;
+                    }
+                    if (!m_global.available(nowMs)) {
+                        m_stats.throttledGlobal++;
+                        return picked;
+                    }
+                    Bucket &domainTokens = domainBucket(domain, nowMs);
+                    if (!domainTokens.available(nowMs)) {
+                        m_stats.throttledDomain++;
+                        blockedDomains.insert(domain);
+                        queue.pop_front();
+                        continue;
+                    }
+
+                    m_global.take();
+                    domainTokens.take();
+                    queue.pop_front();
+
+                    double delay = static_cast<double>(std::max<qint64>(0, nowSec - msg->createdAt));
+                    m_totalDelaySec += delay;
+                    m_stats.maxQueueDelaySec = std::max(m_stats.maxQueueDelaySec, delay);
+                    m_stats.scheduled++;
+                    if (msg->priority >= 0 && msg->priority < OutboxMessage::PRIORITY_COUNT) {
+                        m_stats.sentByPriority[msg->priority]++;
+                    }
+                    picked.push_back(*msg);
+                    progress = true;
+                    break;
+                }
+            }
+        }
+    }
+    return picked;
+}
+
+int SendScheduler::msUntilNextToken() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_global.perMs <= 0.0) return 0;
+    m_global.refill(m_clock.elapsed());
+    if (m_global.tokens >= 1.0) return 0;
+    return static_cast<int>(std::ceil((1.0 - m_global.tokens) / m_global.perMs));
+}
+
+QStringList SendScheduler::blockedDomains(int max) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QStringList blocked;
+    qint64 nowMs = m_clock.elapsed();
+    for (auto &[domain, bucket] : m_domains) {
+        if (blocked.size() >= max) break;
+        if (!bucket.available(nowMs)) blocked << domain;
+    }
+    return blocked;
+}
+
+SendScheduler::Stats SendScheduler::stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s = m_stats;
+    if (s.scheduled > 0) s.avgQueueDelaySec = m_totalDelaySec / s.scheduled;
+    m_global.refill(m_clock.elapsed());
+    s.globalTokens = m_global.tokens;
+    s.domainBuckets = m_domains.size();
+    return s;
+}
+
+} // namespace service
+} // namespace rz
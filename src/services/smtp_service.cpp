@@ -2,8 +2,8 @@
  * @file smtp_service.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief SMTP Service Implementation
- * @version 0.2.1
- * @date 2026-01-03
+ * @version 0.6.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -11,17 +11,22 @@
  */
 
 #include "services/smtp_service.hpp"
+#include "utils/metrics.hpp"
 
 // KORREKTUR: Direkte Includes (ohne "SimpleMail/" Prefix), da FetchContent genutzt wird
 #include "server.h"
 #include "mimemessage.h"
 #include "mimetext.h"
+#include "mimehtml.h"
+#include "mimemultipart.h"
 #include "emailaddress.h"
 #include "serverreply.h"
 
 #include <QDebug>
 #include <QCoreApplication>
 #include <QMetaObject>
+#include <QTimer>
+#include <chrono>
 
 namespace rz {
 namespace service {
@@ -29,6 +34,13 @@ namespace service {
 SmtpService::SmtpService(const model::ConfigModel& config, QObject* parent)
     : QObject(parent), m_config(config) {
     qRegisterMetaType<QString>("QString");
+
+    m_pool.resize(m_config.getSmtpPoolSize());
+
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setInterval(qMax(1000, m_config.getSmtpIdleTimeoutSec() * 1000 / 4));
+    connect(m_idleTimer, &QTimer::timeout, this, &SmtpService::closeIdleConnections);
+    m_idleTimer->start();
 }
 
 SmtpService::~SmtpService() = default;
@@ -40,9 +52,7 @@ void SmtpService::sendEmailAsync(const QString& to, const QString& subject, cons
                               Q_ARG(QString, body));
 }
 
-void SmtpService::doSendEmail(const QString& to, const QString& subject, const QString& body) {
-    qInfo() << "[SMTP] Preparing email to:" << to;
-
+SimpleMail::Server* SmtpService::createServer() {
     auto server = new SimpleMail::Server(this);
     server->setHost(m_config.getSmtpServer());
     server->setPort(m_config.getSmtpPort());
@@ -54,6 +64,54 @@ void SmtpService::doSendEmail(const QString& to, const QString& subject, const Q
     } else {
         server->setConnectionType(SimpleMail::Server::TcpConnection);
     }
+    return server;
+}
+
+SmtpService::PooledConnection& SmtpService::acquireConnection() {
+    PooledConnection* best = nullptr;
+    PooledConnection* empty = nullptr;
+
+    // Verbindung mit der kürzesten Warteschlange bevorzugen
+    for (auto& conn : m_pool) {
+        if (!conn.server) {
+            if (!empty) empty = &conn;
+            continue;
+        }
+        if (conn.retiring) continue;
+        if (!best || conn.inFlight < best->inFlight) best = &conn;
+    }
+
+    // Neue Verbindung nur, wenn alle bestehenden beschäftigt sind
+    if (empty && (!best || best->inFlight > 0)) {
+        empty->server = createServer();
+        empty->sent = 0;
+        empty->inFlight = 0;
+        empty->retiring = false;
+        empty->lastUsed.start();
+        qInfo() << "[SMTP] Neue Pool-Verbindung zu" << m_config.getSmtpServer();
+        return *empty;
+    }
+
+    if (best) return *best;
+
+    // Alle Slots sind im Ruhestand und noch belegt: zusätzliche Verbindung anlegen
+    m_pool.push_back(PooledConnection{});
+    PooledConnection& extra = m_pool.back();
+    extra.server = createServer();
+    extra.lastUsed.start();
+    return extra;
+}
+
+void SmtpService::doSendEmail(const QString& to, const QString& subject, const QString& body) {
+    sendEmail(to, subject, body, QString(), nullptr);
+}
+
+void SmtpService::sendEmail(const QString& to, const QString& subject, const QString& body,
+                            const QString& htmlBody, SendCallback done) {
+    qInfo() << "[SMTP] Preparing email to:" << to;
+
+    PooledConnection& conn = acquireConnection();
+    SimpleMail::Server* server = conn.server;
 
     SimpleMail::MimeMessage message;
     message.setSender(SimpleMail::EmailAddress(m_config.getSmtpFrom(), "CakePlanner Bot"));
@@ -62,20 +120,89 @@ void SmtpService::doSendEmail(const QString& to, const QString& subject, const Q
 
     auto textPart = std::make_shared<SimpleMail::MimeText>();
     textPart->setText(body);
-    message.addPart(textPart);
+    if (htmlBody.isEmpty()) {
+        message.addPart(textPart);
+    } else {
+        // Text + HTML als Alternativen: der Client wählt die passende Darstellung
+        auto htmlPart = std::make_shared<SimpleMail::MimeHtml>();
+        htmlPart->setHtml(htmlBody);
+        auto alternative = std::make_shared<SimpleMail::MimeMultiPart>(SimpleMail::MimeMultiPart::Alternative);
+        alternative->addPart(textPart);
+        alternative->addPart(htmlPart);
+        message.addPart(alternative);
+    }
+
+    conn.inFlight++;
+    conn.sent++;
+    conn.lastUsed.restart();
+    if (conn.sent >= m_config.getSmtpMaxMessagesPerConnection()) {
+        conn.retiring = true;
+    }
 
+    static auto& registry = rz::utils::MetricsRegistry::instance();
+    static auto& sentOk = registry.counter("cake_smtp_sends_total", "SMTP sends by result.",
+                                           {{"result", "ok"}});
+    static auto& sentFailed = registry.counter("cake_smtp_sends_total", "SMTP sends by result.",
+                                               {{"result", "failed"}});
+    static auto& sendSeconds = registry.histogram("cake_smtp_send_seconds",
+                                                  "SMTP send time until the server replied.");
+
+    auto started = std::chrono::steady_clock::now();
     SimpleMail::ServerReply* reply = server->sendMail(message);
 
-    connect(reply, &SimpleMail::ServerReply::finished, [reply, server, to]() {
-        if (reply->error()) {
+    connect(reply, &SimpleMail::ServerReply::finished, this,
+            [this, reply, server, to, started, done = std::move(done)]() {
+        bool failed = reply->error();
+        (failed ? sentFailed : sentOk).inc();
+        sendSeconds.observeSince<std::chrono::steady_clock>(started);
+        if (failed) {
             qWarning() << "[SMTP] Failed to send to" << to << ":" << reply->responseText();
         } else {
             qInfo() << "[SMTP] Sent successfully to" << to;
         }
+        QString error = failed ? reply->responseText() : QString();
         reply->deleteLater();
-        server->deleteLater();
+        releaseConnection(server, failed);
+        if (done) done(!failed, error);
     });
 }
 
+void SmtpService::releaseConnection(SimpleMail::Server* server, bool failed) {
+    // Der Vektor kann gewachsen sein: Slot über den Server-Pointer suchen
+    for (auto& conn : m_pool) {
+        if (conn.server != server) continue;
+
+        conn.inFlight--;
+        conn.lastUsed.restart();
+        // Reconnect-on-Error: fehlerhafte Sessions werden nicht wiederverwendet
+        if (failed) conn.retiring = true;
+        if (conn.retiring && conn.inFlight <= 0) destroyConnection(conn);
+        break;
+    }
+
+    // Zusätzliche Slots jenseits der Poolgröße wieder abbauen
+    while (m_pool.size() > static_cast<size_t>(m_config.getSmtpPoolSize()) &&
+           !m_pool.back().server) {
+        m_pool.pop_back();
+    }
+}
+
+void SmtpService::destroyConnection(PooledConnection& conn) {
+    if (conn.server) {
+        conn.server->deleteLater();
+    }
+    conn = PooledConnection{};
+}
+
+void SmtpService::closeIdleConnections() {
+    const qint64 idleMs = static_cast<qint64>(m_config.getSmtpIdleTimeoutSec()) * 1000;
+    for (auto& conn : m_pool) {
+        if (conn.server && conn.inFlight <= 0 && conn.lastUsed.elapsed() >= idleMs) {
+            qInfo() << "[SMTP] Schließe unbenutzte Pool-Verbindung";
+            destroyConnection(conn);
+        }
+    }
+}
+
 } // namespace service
 } // namespace rz
@@ -0,0 +1,219 @@
+/**
+ * @file supervisor.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Prefork supervisor for multi-process worker mode
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/supervisor.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDebug>
+#include <QDir>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+namespace rz {
+namespace service {
+
+namespace {
+
+volatile sig_atomic_t g_stopSignal = 0;
+
+void onStopSignal(int sig) { g_stopSignal = sig; }
+
+void installHandlers(void (*handler)(int)) {
+  struct sigaction sa = {};
+  sa.sa_handler = handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0; // kein SA_RESTART: waitpid() soll mit EINTR zurückkehren
+  sigaction(SIGTERM, &sa, nullptr);
+  sigaction(SIGINT, &sa, nullptr);
+}
+
+struct Slot {
+  pid_t pid = 0;
+  int recentCrashes = 0;
+  std::chrono::steady_clock::time_point startedAt;
+};
+
+// Ein Supervisor pro Port: sonst könnte eine zweite Instanz (gleicher User)
+// per SO_REUSEPORT still mitlauschen. Der Descriptor bleibt in allen Workern
+// offen, die Sperre hält also, solange noch ein Prozess der Instanz lebt.
+bool lockPort(int port) {
+  QByteArray path =
+      QDir(QDir::tempPath()).filePath(QString("cakeplanner-%1.lock").arg(port)).toLocal8Bit();
+  int fd = open(path.constData(), O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    qCritical() << "[Supervisor] Lock-Datei" << path << "nicht nutzbar:" << strerror(errno);
+    return false;
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    qCritical() << "[Supervisor] Port" << port << "wird schon von einer anderen Instanz bedient ("
+                << path << ")";
+    close(fd);
+    return false;
+  }
+  return true;
+}
+
+// Startet dieses Programm neu als Worker (fork + exec): der Worker baut
+// Qt, Threads und DB-Verbindungen selbst auf, nichts davon überquert fork()
+bool spawn(int index, Slot &slot, char *argv[], pid_t supervisorPid) {
+  const std::string indexText = std::to_string(index);
+  pid_t pid = fork();
+  if (pid < 0) {
+    qCritical() << "[Supervisor] fork() fehlgeschlagen:" << strerror(errno);
+    return false;
+  }
+  if (pid > 0) {
+    slot.pid = pid;
+    slot.startedAt = std::chrono::steady_clock::now();
+    qInfo() << "[Supervisor] Worker" << index << "gestartet, PID" << pid;
+    return true;
+  }
+
+  // Kind: Signale wieder normal behandeln (Crow installiert eigene Handler)
+  installHandlers(SIG_DFL);
+#ifdef __linux__
+  prctl(PR_SET_PDEATHSIG, SIGTERM); // bleibt über execv() erhalten
+#endif
+  // Supervisor schon weg, bevor PDEATHSIG gesetzt war
+  if (getppid() != supervisorPid) _exit(1);
+  setenv("CAKE_WORKER_INDEX", indexText.c_str(), 1);
+
+  execv("/proc/self/exe", argv);
+  execv(argv[0], argv); // ohne /proc
+  _exit(127);
+}
+
+} // namespace
+
+int Supervisor::workerIndex() {
+  // Vom Supervisor gesetzt; fest für die Lebensdauer des Prozesses
+  static const int index = []() {
+    const char *value = std::getenv("CAKE_WORKER_INDEX");
+    if (!value || !*value) return -1;
+    char *end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    return (*end == '\0' && parsed >= 0) ? static_cast<int>(parsed) : -1;
+  }();
+  return index;
+}
+
+int Supervisor::run(int workers, char *argv[]) {
+  workers = std::max(1, workers);
+  const int stopTimeoutSec =
+      std::max(1, rz::utils::EnvLoader::getInt("CAKE_WORKER_STOP_TIMEOUT_SEC", 10));
+  const pid_t supervisorPid = getpid();
+
+  if (!lockPort(rz::utils::EnvLoader::getInt("CAKE_SERVER_PORT", 8080))) {
+    return 1;
+  }
+
+  installHandlers(onStopSignal);
+  qInfo() << "[Supervisor] Prefork-Modus mit" << workers << "Workern, PID" << supervisorPid;
+
+  std::vector<Slot> slots(static_cast<size_t>(workers));
+  for (int i = 0; i < workers; ++i) spawn(i, slots[i], argv, supervisorPid);
+
+  // --- Überwachen und neu starten ---
+  while (!g_stopSignal) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) continue;
+      break; // ECHILD: keine Kinder mehr
+    }
+
+    auto it = std::find_if(slots.begin(), slots.end(), [pid](const Slot &s) { return s.pid == pid; });
+    if (it == slots.end()) continue;
+    int index = static_cast<int>(it - slots.begin());
+    it->pid = 0;
+    if (g_stopSignal) break;
+
+    if (WIFSIGNALED(status)) {
+      qWarning() << "[Supervisor] Worker" << index << "durch Signal" << WTERMSIG(status) << "beendet";
+    } else {
+      qWarning() << "[Supervisor] Worker" << index << "beendet mit Code" << WEXITSTATUS(status);
+    }
+
+    // Crash-Schleife bremsen: lief der Worker keine 10 s, wächst die Pause
+    auto uptime = std::chrono::steady_clock::now() - it->startedAt;
+    it->recentCrashes = uptime < std::chrono::seconds(10) ? it->recentCrashes + 1 : 0;
+    if (it->recentCrashes > 0) {
+      int delayMs = std::min(30000, 250 << std::min(it->recentCrashes, 7));
+      qWarning() << "[Supervisor] Neustart von Worker" << index << "in" << delayMs << "ms";
+      std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+      if (g_stopSignal) break;
+    }
+
+    spawn(index, *it, argv, supervisorPid);
+  }
+
+  // --- Herunterfahren ---
+  int sig = g_stopSignal ? static_cast<int>(g_stopSignal) : SIGTERM;
+  qInfo() << "[Supervisor] Beende Worker (Signal" << sig << ")";
+  for (const auto &slot : slots) {
+    if (slot.pid > 0) kill(slot.pid, SIGTERM);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(stopTimeoutSec);
+  int exitCode = 0;
+  auto running = [&slots]() {
+    return std::any_of(slots.begin(), slots.end(), [](const Slot &s) { return s.pid > 0; });
+  };
+  while (running()) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, WNOHANG);
+    if (pid > 0) {
+      for (auto &slot : slots) {
+        if (slot.pid == pid) slot.pid = 0;
+      }
+      if (WIFSIGNALED(status) || WEXITSTATUS(status) != 0) exitCode = 1;
+      continue;
+    }
+    if (pid < 0 && errno == ECHILD) break;
+
+    if (std::chrono::steady_clock::now() >= deadline) {
+      for (auto &slot : slots) {
+        if (slot.pid <= 0) continue;
+        qWarning() << "[Supervisor] Worker PID" << slot.pid << "reagiert nicht, SIGKILL";
+        kill(slot.pid, SIGKILL);
+        waitpid(slot.pid, nullptr, 0);
+        slot.pid = 0;
+      }
+      exitCode = 1;
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  qInfo() << "[Supervisor] Alle Worker beendet";
+  return exitCode;
+}
+
+} // namespace service
+} // namespace rz
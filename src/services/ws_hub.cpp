@@ -0,0 +1,416 @@
+/**
+ * @file ws_hub.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief WebSocket realtime channel (/api/ws)
+ * @version 0.4.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "services/ws_hub.hpp"
+#include "middleware/auth_middleware.hpp"
+#include "services/change_bus.hpp"
+#include "services/event_hub.hpp"
+#include "services/executors.hpp"
+#include "utils/env_loader.hpp"
+#include "utils/revocation_list.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <unordered_set>
+
+namespace rz {
+namespace service {
+
+WsHub &WsHub::instance() {
+  static WsHub instance;
+  return instance;
+}
+
+WsHub::~WsHub() { stop(); }
+
+void WsHub::configureFromEnv() {
+  m_queueCapacity = static_cast<size_t>(
+      std::max(8, rz::utils::EnvLoader::getInt("CAKE_WS_QUEUE", 256)));
+  m_maxConnections = static_cast<size_t>(
+      std::max(1, rz::utils::EnvLoader::getInt("CAKE_WS_MAX_CONNECTIONS", 10000)));
+  m_maxInbox = static_cast<size_t>(
+      std::max(100, rz::utils::EnvLoader::getInt("CAKE_WS_MAX_INBOX", 10000)));
+  m_maxMessageBytes = static_cast<size_t>(
+      std::max(256, rz::utils::EnvLoader::getInt("CAKE_WS_MAX_MESSAGE_BYTES", 4096)));
+
+  qInfo() << "[WS] Queue" << m_queueCapacity << "pro Verbindung, max." << m_maxConnections
+          << "Verbindungen";
+}
+
+void WsHub::start() {
+  std::lock_guard<std::mutex> lock(m_inboxMutex);
+  if (m_thread.joinable()) return;
+  m_stopping = false;
+  m_thread = std::thread([this]() { broadcasterLoop(); });
+}
+
+void WsHub::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    m_stopping = true;
+  }
+  m_inboxCv.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+}
+
+bool WsHub::accept(const crow::request &req, void **userdata) {
+  if (!req.io_context) return false;
+
+  // Browser können beim Handshake keine Header setzen: Token als Query-Parameter
+  std::string token;
+  if (const char *param = req.url_params.get("token")) token = param;
+  std::string header = req.get_header_value("Authorization");
+  if (token.empty() && header.starts_with("Bearer ")) token = header.substr(7);
+  if (token.empty()) return false;
+
+  rz::middleware::AuthMiddleware::context ctx;
+  std::string error;
+  if (!rz::middleware::AuthMiddleware::authenticate(token, ctx, error)) return false;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_connections.size() >= m_maxConnections) {
+      m_rejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  auto c = std::make_shared<Connection>(m_queueCapacity, *req.io_context);
+  c->user = ctx.currentUser;
+  c->auth = ctx.auth;
+  for (const auto &m : ctx.auth->groups) c->topics.push_back(EventHub::groupTopic(m.groupId));
+
+  // Bis onopen in den Userdata der Verbindung geparkt
+  *userdata = new std::shared_ptr<Connection>(std::move(c));
+  return true;
+}
+
+void WsHub::open(crow::websocket::connection &conn) {
+  auto *pending = static_cast<std::shared_ptr<Connection> *>(conn.userdata());
+  if (!pending) {
+    conn.close("unauthorized");
+    return;
+  }
+  std::shared_ptr<Connection> c = std::move(*pending);
+  delete pending;
+  c->conn = &conn;
+  conn.userdata(c.get());
+
+  bool firstForUser = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connections.emplace(c.get(), c);
+    for (const auto &topic : c->topics) m_topics[topic].emplace(c.get(), c);
+    if (!c->user.sessionId.isEmpty()) m_sessions[c->user.sessionId].emplace(c.get(), c);
+    auto &userConns = m_users[c->user.userId];
+    userConns.emplace(c.get(), c);
+    firstForUser = userConns.size() == 1;
+  }
+  if (firstForUser) publishPresence(*c, true);
+
+  // Token läuft ab: Verbindung schließen, der Client verbindet sich mit neuem Token
+  if (c->user.expiresAt > 0) {
+    qint64 left = c->user.expiresAt - QDateTime::currentSecsSinceEpoch();
+    c->expiry.expires_after(std::chrono::seconds(std::max<qint64>(0, left)));
+    c->expiry.async_wait([this, c](const asio::error_code &ec) {
+      if (!ec) kick(c, "token expired");
+    });
+  }
+}
+
+void WsHub::close(crow::websocket::connection &conn) {
+  auto *raw = static_cast<const Connection *>(conn.userdata());
+  if (!raw) return;
+  conn.userdata(nullptr);
+
+  std::shared_ptr<Connection> c;
+  bool lastForUser = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_connections.find(raw);
+    if (it == m_connections.end()) return;
+    c = it->second;
+    m_connections.erase(it);
+    for (const auto &topic : c->topics) {
+      auto t = m_topics.find(topic);
+      if (t == m_topics.end()) continue;
+      t->second.erase(raw);
+      if (t->second.empty()) m_topics.erase(t);
+    }
+    auto s = m_sessions.find(c->user.sessionId);
+    if (s != m_sessions.end()) {
+      s->second.erase(raw);
+      if (s->second.empty()) m_sessions.erase(s);
+    }
+    auto u = m_users.find(c->user.userId);
+    if (u != m_users.end()) {
+      u->second.erase(raw);
+      if (u->second.empty()) {
+        m_users.erase(u);
+        lastForUser = true;
+      }
+    }
+  }
+
+  // Noch geplante Drains sehen 'closed' und fassen conn nicht mehr an
+  c->closed = true;
+  c->conn = nullptr;
+  c->expiry.cancel();
+  if (lastForUser) publishPresence(*c, false);
+}
+
+void WsHub::message(crow::websocket::connection &conn, const std::string &data, bool isBinary) {
+  auto *c = static_cast<const Connection *>(conn.userdata());
+  if (!c || isBinary) return;
+  m_clientMessages.fetch_add(1, std::memory_order_relaxed);
+
+  auto json = crow::json::load(data);
+  auto isString = [&json](const char *key) {
+    return json.has(key) && json[key].t() == crow::json::type::String;
+  };
+  if (!json || !isString("type")) return;
+  std::string type = json["type"].s();
+
+  if (type == "PING") {
+    conn.send_text("{\"type\":\"PONG\"}");
+  } else if (type == "TYPING" && isString("groupId") && isString("eventId")) {
+    // Nur in eigene Gruppen; mehrfaches Tippen wird pro Event zusammengefasst
+    QString groupId = QString::fromStdString(json["groupId"].s());
+    if (!c->auth->isMemberOf(groupId)) return;
+    std::string eventId = json["eventId"].s();
+
+    crow::json::wvalue msg;
+    msg["type"] = "TYPING";
+    msg["groupId"] = groupId.toStdString();
+    msg["eventId"] = eventId;
+    msg["userId"] = c->user.userId.toStdString();
+    msg["userName"] = c->auth->displayName.toStdString();
+    ChangeBus::instance().publishWs(EventHub::groupTopic(groupId), std::move(msg),
+                                    "TYPING:" + c->user.userId.toStdString() + ":" + eventId);
+  }
+
+  // Sofortige Quittung, wenn der Client eine Referenz mitschickt
+  if (isString("ref")) {
+    crow::json::wvalue ack;
+    ack["type"] = "ACK";
+    ack["ref"] = json["ref"].s();
+    conn.send_text(ack.dump());
+  }
+}
+
+void WsHub::publish(const std::string &topic, crow::json::wvalue payload,
+                    std::string coalesceKey) {
+  {
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    if (m_stopping || !m_thread.joinable()) return;
+    if (m_inbox.size() >= m_maxInbox) {
+      m_rejected.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    m_inbox.push_back(Outgoing{topic, std::move(payload), std::move(coalesceKey)});
+  }
+  m_published.fetch_add(1, std::memory_order_relaxed);
+  m_inboxCv.notify_one();
+}
+
+std::vector<std::shared_ptr<WsHub::Connection>> WsHub::connectionsOf(
+    const std::unordered_map<QString, ConnectionMap> &index, const QString &key) const {
+  std::vector<std::shared_ptr<Connection>> result;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = index.find(key);
+  if (it == index.end()) return result;
+  result.reserve(it->second.size());
+  for (const auto &entry : it->second) result.push_back(entry.second);
+  return result;
+}
+
+void WsHub::kick(const std::shared_ptr<Connection> &c, const std::string &reason) {
+  // Auf dem io-Thread der Verbindung; close() räumt den Index auf
+  asio::post(*c->io, [c, reason]() {
+    if (c->closed || !c->conn) return;
+    c->conn->close(reason);
+  });
+}
+
+void WsHub::revokeSession(const QString &sessionId) {
+  if (sessionId.isEmpty()) return;
+  for (const auto &c : connectionsOf(m_sessions, sessionId)) kick(c, "session revoked");
+}
+
+void WsHub::invalidateUser(const QString &userId) {
+  auto targets = connectionsOf(m_users, userId);
+  if (targets.empty()) return;
+
+  // Snapshot neu laden (DB) nicht auf dem aufrufenden Thread
+  auto recheck = [this, userId, targets]() {
+    auto auth = rz::utils::AuthContextCache::instance().get(userId);
+    std::vector<std::string> topics;
+    if (auth) {
+      for (const auto &m : auth->groups) topics.push_back(EventHub::groupTopic(m.groupId));
+    }
+    for (const auto &c : targets) {
+      if (!auth || !auth->isActive || topics != c->topics) {
+        // Inaktiv oder andere Gruppen: neu verbinden, dann mit passenden Topics
+        kick(c, "auth changed");
+        continue;
+      }
+      asio::post(*c->io, [c, auth]() {
+        if (!c->closed) c->auth = auth;
+      });
+    }
+  };
+  if (!Executors::instance().get(Executors::Pool::DbRead).post(recheck)) {
+    // Pool voll: lieber schließen als mit altem Stand weiterlaufen
+    for (const auto &c : targets) kick(c, "auth changed");
+  }
+}
+
+void WsHub::resync() {
+  std::vector<QString> revoked;
+  std::vector<QString> users;
+  std::vector<std::shared_ptr<Connection>> all;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &revocations = rz::utils::RevocationList::instance();
+    for (const auto &[sessionId, conns] : m_sessions) {
+      if (revocations.isRevoked(sessionId)) revoked.push_back(sessionId);
+    }
+    users.reserve(m_users.size());
+    for (const auto &[userId, conns] : m_users) users.push_back(userId);
+    all.reserve(m_connections.size());
+    for (const auto &entry : m_connections) all.push_back(entry.second);
+  }
+
+  for (const auto &sessionId : revoked) revokeSession(sessionId);
+  for (const auto &userId : users) invalidateUser(userId);
+
+  // Wie beim Überlauf: Queue verwerfen, drain() schickt RESYNC
+  for (const auto &c : all) {
+    c->overflowed.store(true, std::memory_order_release);
+    if (!c->drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+      asio::post(*c->io, [this, c]() { drain(c); });
+    }
+  }
+}
+
+void WsHub::publishPresence(const Connection &c, bool online) {
+  for (const auto &topic : c.topics) {
+    crow::json::wvalue msg;
+    msg["type"] = "PRESENCE";
+    msg["userId"] = c.user.userId.toStdString();
+    msg["userName"] = c.auth->displayName.toStdString();
+    msg["online"] = online;
+    ChangeBus::instance().publishWs(topic, std::move(msg),
+                                    "PRESENCE:" + c.user.userId.toStdString());
+  }
+}
+
+void WsHub::broadcasterLoop() {
+  std::deque<Outgoing> batch;
+  std::vector<std::shared_ptr<Connection>> targets;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_inboxMutex);
+      m_inboxCv.wait(lock, [this] { return m_stopping || !m_inbox.empty(); });
+      if (m_inbox.empty()) return; // stopping & leer
+      batch.swap(m_inbox);
+    }
+
+    for (auto &out : batch) {
+      // Einmal serialisieren, die Bytes teilen sich alle Empfänger
+      Frame frame{std::make_shared<const std::string>(out.payload.dump()), std::move(out.key)};
+
+      targets.clear();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_topics.find(out.topic);
+        if (it == m_topics.end()) continue;
+        targets.reserve(it->second.size());
+        for (const auto &entry : it->second) targets.push_back(entry.second);
+      }
+      for (const auto &c : targets) enqueue(c, frame);
+    }
+    batch.clear();
+  }
+}
+
+void WsHub::enqueue(const std::shared_ptr<Connection> &c, const Frame &frame) {
+  if (c->queue.push(frame)) {
+    m_framesQueued.fetch_add(1, std::memory_order_relaxed);
+  } else if (!c->overflowed.exchange(true, std::memory_order_acq_rel)) {
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Höchstens ein ausstehender Drain pro Verbindung
+  if (!c->drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+    asio::post(*c->io, [this, c]() { drain(c); });
+  }
+}
+
+void WsHub::drain(const std::shared_ptr<Connection> &c) {
+  c->drainScheduled.store(false, std::memory_order_release);
+
+  std::vector<Frame> frames;
+  Frame frame;
+  while (c->queue.pop(frame)) frames.push_back(std::move(frame));
+  if (c->closed) return;
+
+  // Client kam nicht hinterher: Rest verwerfen, Client lädt neu
+  if (c->overflowed.exchange(false, std::memory_order_acq_rel)) {
+    c->conn->send_text("{\"type\":\"RESYNC\"}");
+    return;
+  }
+
+  // Gleicher Schlüssel: nur die neueste Nachricht ausliefern
+  std::vector<bool> keep(frames.size(), true);
+  std::unordered_set<std::string> seen;
+  for (size_t i = frames.size(); i-- > 0;) {
+    if (frames[i].key.empty()) continue;
+    if (!seen.insert(frames[i].key).second) keep[i] = false;
+  }
+
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (!keep[i]) {
+      m_coalesced.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    // Crow übernimmt den Text als eigenen String in seine Schreib-Queue
+    c->conn->send_text(*frames[i].bytes);
+    m_framesSent.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+WsHub::Stats WsHub::stats() const {
+  Stats s;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s.connections = m_connections.size();
+    s.topics = m_topics.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    s.inbox = m_inbox.size();
+  }
+  s.published = m_published.load(std::memory_order_relaxed);
+  s.framesQueued = m_framesQueued.load(std::memory_order_relaxed);
+  s.framesSent = m_framesSent.load(std::memory_order_relaxed);
+  s.coalesced = m_coalesced.load(std::memory_order_relaxed);
+  s.overflows = m_overflows.load(std::memory_order_relaxed);
+  s.rejected = m_rejected.load(std::memory_order_relaxed);
+  s.clientMessages = m_clientMessages.load(std::memory_order_relaxed);
+  return s;
+}
+
+} // namespace service
+} // namespace rz
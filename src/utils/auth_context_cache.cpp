@@ -0,0 +1,82 @@
+/**
+ * @file auth_context_cache.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Cached per-user authorization snapshot
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/auth_context_cache.hpp"
+#include "models/user_model.hpp"
+
+#include <QDateTime>
+#include <mutex>
+
+namespace rz {
+namespace utils {
+
+AuthContextCache &AuthContextCache::instance() {
+  static AuthContextCache instance;
+  return instance;
+}
+
+void AuthContextCache::setTtl(int seconds) {
+  m_ttlSeconds.store(seconds > 0 ? seconds : 1, std::memory_order_relaxed);
+}
+
+AuthContextCache::Shard &AuthContextCache::shardFor(const QString &userId) {
+  return m_shards[qHash(userId) % SHARD_COUNT];
+}
+
+std::shared_ptr<const AuthSnapshot> AuthContextCache::get(const QString &userId) {
+  Shard &shard = shardFor(userId);
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+  uint64_t generation;
+
+  {
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.entries.find(userId);
+    if (it != shard.entries.end() &&
+        now - it->second->loadedAt < m_ttlSeconds.load(std::memory_order_relaxed)) {
+      m_hits.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+    generation = shard.generation;
+  }
+
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+  auto loaded = User::loadAuthSnapshot(userId);
+  if (!loaded) return nullptr;
+
+  loaded->loadedAt = now;
+  auto snapshot = std::make_shared<const AuthSnapshot>(std::move(*loaded));
+
+  std::unique_lock lock(shard.mutex);
+  // Nur cachen, wenn zwischenzeitlich nichts invalidiert wurde
+  if (shard.generation == generation) {
+    shard.entries[userId] = snapshot;
+  }
+  return snapshot;
+}
+
+void AuthContextCache::invalidate(const QString &userId) {
+  Shard &shard = shardFor(userId);
+  std::unique_lock lock(shard.mutex);
+  shard.entries.erase(userId);
+  shard.generation++;
+}
+
+void AuthContextCache::clear() {
+  for (auto &shard : m_shards) {
+    std::unique_lock lock(shard.mutex);
+    shard.entries.clear();
+    shard.generation++;
+  }
+}
+
+} // namespace utils
+} // namespace rz
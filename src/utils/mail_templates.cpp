@@ -0,0 +1,296 @@
+/**
+ * @file mail_templates.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Precompiled, multilingual e-mail templates
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/mail_templates.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+
+namespace rz {
+namespace utils {
+
+namespace {
+
+struct BuiltIn {
+  const char *type;
+  const char *lang;
+  const char *subject;
+  const char *text;
+  const char *html;
+  const char *line;
+};
+
+// Mitgelieferte Vorlagen; Dateien im Template-Verzeichnis überschreiben sie
+const BuiltIn BUILT_INS[] = {
+    {"new_event", "de", "Neuer Kuchen in {{group}}!",
+     "Hallo {{name}},\n\n{{baker}} bringt am {{date}} einen Kuchen mit!\n\nYummy!",
+     "<p>Hallo {{name}},</p>\n<p><strong>{{baker}}</strong> bringt am {{date}} "
+     "einen Kuchen mit!</p>\n<p>Yummy!</p>",
+     "{{baker}} bringt am {{date}} einen Kuchen mit ({{group}})"},
+    {"new_event", "en", "New Cake in {{group}}!",
+     "Hello {{name}},\n\n{{baker}} is bringing a cake on {{date}}!\n\nYummy!",
+     "<p>Hello {{name}},</p>\n<p><strong>{{baker}}</strong> is bringing a cake "
+     "on {{date}}!</p>\n<p>Yummy!</p>",
+     "{{baker}} is bringing a cake on {{date}} ({{group}})"},
+    {"new_user", "de", "CakePlanner: Neuer User registriert",
+     "Ein neuer User hat sich registriert:\n\nName: {{userName}}\nEmail: "
+     "{{userEmail}}\n\nBitte prüfen und ggf. Gruppe zuweisen.",
+     "<p>Ein neuer User hat sich registriert:</p>\n<p>Name: {{userName}}<br>"
+     "Email: {{userEmail}}</p>\n<p>Bitte prüfen und ggf. Gruppe zuweisen.</p>",
+     "Neuer User registriert: {{userName}} ({{userEmail}})"},
+    {"new_user", "en", "CakePlanner: New user registered",
+     "A new user has registered:\n\nName: {{userName}}\nEmail: "
+     "{{userEmail}}\n\nPlease review and assign a group if needed.",
+     "<p>A new user has registered:</p>\n<p>Name: {{userName}}<br>"
+     "Email: {{userEmail}}</p>\n<p>Please review and assign a group if needed.</p>",
+     "New user registered: {{userName}} ({{userEmail}})"},
+    {"digest", "de", "CakePlanner: {{count}} Neuigkeiten",
+     "Hallo,\n\nhier deine Zusammenfassung:\n\n{{items}}\nYummy!",
+     "<p>Hallo,</p>\n<p>hier deine Zusammenfassung:</p>\n<ul>{{{itemsHtml}}}</ul>\n"
+     "<p>Yummy!</p>",
+     nullptr},
+    {"digest", "en", "CakePlanner: {{count}} updates",
+     "Hello,\n\nhere is your summary:\n\n{{items}}\nYummy!",
+     "<p>Hello,</p>\n<p>here is your summary:</p>\n<ul>{{{itemsHtml}}}</ul>\n"
+     "<p>Yummy!</p>",
+     nullptr},
+};
+
+const char *PART_SUFFIX[] = {"subject", "txt", "html", "line"};
+
+QString normalizeLang(const QString &lang) {
+  return lang.trimmed().toLower().replace('_', '-');
+}
+
+// "de-at" -> "de" -> Default-Sprache -> "en" (ohne Duplikate)
+QStringList fallbackChain(const QString &lang, const QString &defaultLang) {
+  QStringList chain;
+  for (const QString &c : {lang, lang.section('-', 0, 0), defaultLang, QStringLiteral("en")}) {
+    if (!c.isEmpty() && !chain.contains(c)) chain.append(c);
+  }
+  return chain;
+}
+
+} // namespace
+
+MailTemplates &MailTemplates::instance() {
+  static MailTemplates instance;
+  return instance;
+}
+
+MailTemplates::MailTemplates() {
+  // Built-ins sind auch ohne load() sofort nutzbar
+  load(QString());
+}
+
+MailTemplates::Compiled MailTemplates::compile(const QString &source) {
+  Compiled tokens;
+  qsizetype pos = 0;
+
+  auto pushLiteral = [&tokens](const QString &text) {
+    if (text.isEmpty()) return;
+    // Aufeinanderfolgende Literale zusammenfassen
+    if (!tokens.empty() && tokens.back().kind == Token::Literal) {
+      tokens.back().text += text;
+    } else {
+      tokens.push_back({Token::Literal, text});
+    }
+  };
+
+  while (pos < source.size()) {
+    qsizetype open = source.indexOf(QLatin1String("{{"), pos);
+    if (open < 0) break;
+
+    bool raw = source.mid(open, 3) == QLatin1String("{{{");
+    QLatin1String closeTag = raw ? QLatin1String("}}}") : QLatin1String("}}");
+    qsizetype nameStart = open + (raw ? 3 : 2);
+    qsizetype close = source.indexOf(closeTag, nameStart);
+    if (close < 0) break; // Nicht geschlossen: Rest bleibt Literal
+
+    pushLiteral(source.mid(pos, open - pos));
+    QString name = source.mid(nameStart, close - nameStart).trimmed();
+    tokens.push_back({raw ? Token::RawVar : Token::Var, name});
+    pos = close + closeTag.size();
+  }
+  pushLiteral(source.mid(pos));
+  return tokens;
+}
+
+QString MailTemplates::escapeHtml(const QString &value) {
+  return value.toHtmlEscaped();
+}
+
+QString MailTemplates::renderCompiled(const Compiled &tokens, const TemplateVars &vars,
+                                      bool escape) {
+  QString out;
+  out.reserve(256);
+  for (const auto &token : tokens) {
+    if (token.kind == Token::Literal) {
+      out += token.text;
+      continue;
+    }
+    auto it = vars.constFind(token.text);
+    if (it == vars.constEnd()) continue;
+    out += (escape && token.kind == Token::Var) ? escapeHtml(it.value()) : it.value();
+  }
+  return out;
+}
+
+int MailTemplates::load(const QString &dir) {
+  auto next = std::make_shared<Catalog>();
+
+  for (const auto &b : BUILT_INS) {
+    Template &t = (*next)[QString("%1/%2").arg(b.type, b.lang)];
+    const char *sources[PartCount] = {b.subject, b.text, b.html, b.line};
+    for (int p = 0; p < PartCount; ++p) {
+      if (!sources[p]) continue;
+      t.parts[p] = compile(QString::fromUtf8(sources[p]));
+      t.has[p] = true;
+    }
+  }
+
+  int fromFiles = 0;
+  if (!dir.isEmpty() && QDir(dir).exists()) {
+    // <dir>/<type>/<lang>.<part>
+    for (const QFileInfo &typeDir : QDir(dir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+      for (const QFileInfo &file : QDir(typeDir.absoluteFilePath()).entryInfoList(QDir::Files)) {
+        int part = -1;
+        for (int p = 0; p < PartCount; ++p) {
+          if (file.suffix() == QLatin1String(PART_SUFFIX[p])) part = p;
+        }
+        if (part < 0) continue;
+
+        QFile f(file.absoluteFilePath());
+        if (!f.open(QIODevice::ReadOnly)) {
+          qWarning() << "[Templates] Kann nicht lesen:" << file.absoluteFilePath();
+          continue;
+        }
+        QString source = QString::fromUtf8(f.readAll());
+        // Betreff und Zeile sind einzeilig
+        if (part == Subject || part == Line) source = source.trimmed();
+
+        Template &t = (*next)[typeDir.fileName() + '/' + normalizeLang(file.completeBaseName())];
+        t.parts[part] = compile(source);
+        t.has[part] = true;
+        fromFiles++;
+      }
+    }
+  }
+
+  // Fehlende Teile schon hier aus der Fallback-Kette ergänzen: eine "de-at"-
+  // Vorlage mit eigenem Betreff bekommt Text und HTML von "de" statt gar keine
+  QString defaultLang;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    defaultLang = m_defaultLang;
+  }
+  const Catalog own = *next;
+  for (auto &[key, t] : *next) {
+    const QString type = key.section('/', 0, 0);
+    const QString lang = key.section('/', 1);
+    for (int p = 0; p < PartCount; ++p) {
+      if (t.has[p]) continue;
+      for (const QString &c : fallbackChain(lang, defaultLang)) {
+        auto it = own.find(type + '/' + c);
+        if (it == own.end() || !it->second.has[p]) continue;
+        t.parts[p] = it->second.parts[p];
+        t.has[p] = true;
+        break;
+      }
+    }
+  }
+
+  int count = static_cast<int>(next->size());
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_catalog = std::move(next);
+    m_dir = dir;
+  }
+
+  if (!dir.isEmpty()) {
+    qInfo() << "[Templates]" << count << "Vorlagen geladen," << fromFiles << "Dateien aus" << dir;
+  }
+  return count;
+}
+
+int MailTemplates::reload() {
+  QString dir;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    dir = m_dir;
+  }
+  return load(dir);
+}
+
+void MailTemplates::setDefaultLanguage(const QString &lang) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_defaultLang = normalizeLang(lang);
+}
+
+std::shared_ptr<const MailTemplates::Catalog> MailTemplates::catalog() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_catalog;
+}
+
+const MailTemplates::Template *MailTemplates::find(const Catalog &catalog, const QString &type,
+                                                   const QString &lang) const {
+  QString defaultLang;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    defaultLang = m_defaultLang;
+  }
+
+  for (const auto &c : fallbackChain(normalizeLang(lang), defaultLang)) {
+    auto it = catalog.find(type + '/' + c);
+    if (it != catalog.end()) return &it->second;
+  }
+  return nullptr;
+}
+
+RenderedMail MailTemplates::render(const QString &type, const QString &lang,
+                                   const TemplateVars &vars) const {
+  RenderedMail mail;
+  auto cat = catalog();
+  const Template *t = find(*cat, type, lang);
+  if (!t) {
+    qWarning() << "[Templates] Keine Vorlage für" << type << lang;
+    return mail;
+  }
+
+  mail.subject = renderCompiled(t->parts[Subject], vars, false);
+  mail.text = renderCompiled(t->parts[Text], vars, false);
+  if (t->has[Html]) mail.html = renderCompiled(t->parts[Html], vars, true);
+  return mail;
+}
+
+QString MailTemplates::renderPart(const QString &type, const QString &lang, Part part,
+                                  const TemplateVars &vars) const {
+  auto cat = catalog();
+  const Template *t = find(*cat, type, lang);
+  if (!t || !t->has[part]) return QString();
+  return renderCompiled(t->parts[part], vars, part == Html);
+}
+
+QStringList MailTemplates::languages() const {
+  auto cat = catalog();
+  QSet<QString> langs;
+  for (const auto &entry : *cat) langs.insert(entry.first.section('/', 1));
+  QStringList result(langs.begin(), langs.end());
+  result.sort();
+  return result;
+}
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,335 @@
+/**
+ * @file metrics.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Lock-free metrics registry with Prometheus text exposition
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/metrics.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+namespace rz {
+namespace utils {
+
+namespace {
+
+std::string escapeLabel(const std::string &value) {
+  std::string out;
+  out.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+std::string formatNumber(double value) {
+  if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.15g", value);
+  return buf;
+}
+
+// {a="b"} aus konstanten und eigenen Labels zusammensetzen
+std::string joinLabels(const std::string &constLabels, const std::string &labels,
+                       const std::string &extra = {}) {
+  std::string inner = constLabels;
+  // labels liegt bereits als "{...}" vor
+  if (labels.size() > 2) {
+    if (!inner.empty()) inner += ',';
+    inner.append(labels, 1, labels.size() - 2);
+  }
+  if (!extra.empty()) {
+    if (!inner.empty()) inner += ',';
+    inner += extra;
+  }
+  return inner.empty() ? std::string() : "{" + inner + "}";
+}
+
+void describe(std::string &out, const std::string &name, const std::string &help,
+              const char *type) {
+  out += "# HELP " + name + " " + help + "\n";
+  out += "# TYPE " + name + " " + type + "\n";
+}
+
+} // namespace
+
+// --- Counter / Histogram ---
+
+uint64_t Counter::value() const {
+  uint64_t sum = 0;
+  for (const auto &shard : m_shards) sum += shard.value.load(std::memory_order_relaxed);
+  return sum;
+}
+
+Histogram::Histogram(std::vector<double> bounds) : m_bounds(std::move(bounds)) {
+  std::sort(m_bounds.begin(), m_bounds.end());
+  if (m_bounds.size() > metrics::MAX_BUCKETS) m_bounds.resize(metrics::MAX_BUCKETS);
+  for (double b : m_bounds) m_boundsNs.push_back(static_cast<uint64_t>(b * 1e9));
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  Snapshot s;
+  s.counts.assign(m_bounds.size() + 1, 0);
+  uint64_t sumNs = 0;
+  for (const auto &shard : m_shards) {
+    for (size_t i = 0; i < s.counts.size(); ++i) {
+      s.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+    }
+    sumNs += shard.sumNs.load(std::memory_order_relaxed);
+  }
+  for (uint64_t c : s.counts) s.count += c;
+  s.sumSeconds = sumNs / 1e9;
+  return s;
+}
+
+std::vector<double> Histogram::latencyBuckets() {
+  return {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+          0.025,  0.05,    0.1,    0.25,  0.5,    1.0,   2.5, 5.0, 10.0};
+}
+
+// --- MetricsWriter ---
+
+void MetricsWriter::counter(const std::string &name, const std::string &help, double value,
+                            const MetricLabels &labels) {
+  sample(name, help, "counter", value, labels);
+}
+
+void MetricsWriter::gauge(const std::string &name, const std::string &help, double value,
+                          const MetricLabels &labels) {
+  sample(name, help, "gauge", value, labels);
+}
+
+void MetricsWriter::sample(const std::string &name, const std::string &help, const char *type,
+                           double value, const MetricLabels &labels) {
+  if (m_described.insert(name).second) describe(m_out, name, help, type);
+  m_out += name + joinLabels(m_constLabels, MetricsRegistry::formatLabels(labels)) + " " +
+           formatNumber(value) + "\n";
+}
+
+// --- MetricsRegistry ---
+
+MetricsRegistry &MetricsRegistry::instance() {
+  static MetricsRegistry instance;
+  return instance;
+}
+
+std::string MetricsRegistry::formatLabels(const MetricLabels &labels) {
+  if (labels.empty()) return {};
+  std::string out = "{";
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (i > 0) out += ',';
+    out += labels[i].first + "=\"" + escapeLabel(labels[i].second) + "\"";
+  }
+  return out + "}";
+}
+
+MetricsRegistry::Family &MetricsRegistry::family(const std::string &name, const std::string &help,
+                                                 Type type) {
+  auto [it, inserted] = m_families.try_emplace(name);
+  if (inserted) {
+    it->second.help = help;
+    it->second.type = type;
+  }
+  return it->second;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help,
+                                  const MetricLabels &labels) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &slot = family(name, help, Type::Counter).counters[formatLabels(labels)];
+  if (!slot) slot = std::make_unique<Counter>();
+  return *slot;
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help,
+                              const MetricLabels &labels) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &slot = family(name, help, Type::Gauge).gauges[formatLabels(labels)];
+  if (!slot) slot = std::make_unique<Gauge>();
+  return *slot;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                      const MetricLabels &labels, std::vector<double> bounds) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &slot = family(name, help, Type::Histogram).histograms[formatLabels(labels)];
+  if (!slot) slot = std::make_unique<Histogram>(std::move(bounds));
+  return *slot;
+}
+
+void MetricsRegistry::setConstLabel(const std::string &name, const std::string &value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_constLabels.empty()) m_constLabels += ',';
+  m_constLabels += name + "=\"" + escapeLabel(value) + "\"";
+}
+
+void MetricsRegistry::addCollector(std::function<void(MetricsWriter &)> collector) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_collectors.push_back(std::move(collector));
+}
+
+std::string MetricsRegistry::render() const {
+  std::string out;
+  out.reserve(16 * 1024);
+
+  std::vector<std::function<void(MetricsWriter &)>> collectors;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    collectors = m_collectors;
+
+    for (const auto &[name, fam] : m_families) {
+      switch (fam.type) {
+      case Type::Counter:
+        describe(out, name, fam.help, "counter");
+        for (const auto &[labels, c] : fam.counters) {
+          out += name + joinLabels(m_constLabels, labels) + " " + std::to_string(c->value()) + "\n";
+        }
+        break;
+      case Type::Gauge:
+        describe(out, name, fam.help, "gauge");
+        for (const auto &[labels, g] : fam.gauges) {
+          out += name + joinLabels(m_constLabels, labels) + " " + std::to_string(g->value()) + "\n";
+        }
+        break;
+      case Type::Histogram:
+        describe(out, name, fam.help, "histogram");
+        for (const auto &[labels, h] : fam.histograms) {
+          auto snap = h->snapshot();
+          uint64_t cumulative = 0;
+          for (size_t i = 0; i < snap.counts.size(); ++i) {
+            cumulative += snap.counts[i];
+            std::string le = i < h->bounds().size() ? formatNumber(h->bounds()[i]) : "+Inf";
+            out += name + "_bucket" + joinLabels(m_constLabels, labels, "le=\"" + le + "\"") +
+                   " " + std::to_string(cumulative) + "\n";
+          }
+          out += name + "_sum" + joinLabels(m_constLabels, labels) + " " +
+                 formatNumber(snap.sumSeconds) + "\n";
+          out += name + "_count" + joinLabels(m_constLabels, labels) + " " +
+                 std::to_string(snap.count) + "\n";
+        }
+        break;
+      }
+    }
+  }
+
+  // Collector ohne Lock: sie fragen andere Singletons ab
+  MetricsWriter writer(out, m_constLabels);
+  for (const auto &collect : collectors) collect(writer);
+  return out;
+}
+
+// --- HttpMetrics ---
+
+namespace {
+
+struct RouteMetrics {
+  Histogram *latency = nullptr;
+  std::array<Counter *, 5> byClass{}; // 1xx..5xx
+};
+
+std::mutex g_routeMutex;
+std::unordered_map<std::string, std::unique_ptr<RouteMetrics>> g_routes;
+
+RouteMetrics *routeMetrics(const std::string &method, const std::string &route, size_t maxRoutes) {
+  std::string key = method + ' ' + route;
+
+  // Pro Thread gemerkt: kein Lock nach dem ersten Request einer Route
+  thread_local std::unordered_map<std::string, RouteMetrics *> local;
+  auto hit = local.find(key);
+  if (hit != local.end()) return hit->second;
+
+  RouteMetrics *metrics = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_routeMutex);
+    auto it = g_routes.find(key);
+    if (it != g_routes.end()) {
+      metrics = it->second.get();
+    } else if (g_routes.size() >= maxRoutes && route != "other") {
+      return nullptr; // Aufrufer zählt unter "other"
+    } else {
+      auto &registry = MetricsRegistry::instance();
+      auto created = std::make_unique<RouteMetrics>();
+      created->latency = &registry.histogram("cake_http_request_duration_seconds",
+                                             "HTTP request latency by route template.",
+                                             {{"method", method}, {"route", route}});
+      for (size_t i = 0; i < created->byClass.size(); ++i) {
+        created->byClass[i] = &registry.counter(
+            "cake_http_requests_total", "HTTP requests by route template and status class.",
+            {{"method", method}, {"route", route}, {"status", std::to_string(i + 1) + "xx"}});
+      }
+      metrics = created.get();
+      g_routes.emplace(key, std::move(created));
+    }
+  }
+  local.emplace(std::move(key), metrics);
+  return metrics;
+}
+
+bool isRouteKnown(const std::string &method, const std::string &route) {
+  std::lock_guard<std::mutex> lock(g_routeMutex);
+  return g_routes.contains(method + ' ' + route);
+}
+
+} // namespace
+
+std::string HttpMetrics::routeTemplate(std::string_view url) {
+  url = url.substr(0, url.find('?'));
+  std::string route;
+  route.reserve(url.size());
+  size_t pos = 0;
+  while (pos < url.size()) {
+    size_t end = url.find('/', pos + 1);
+    if (end == std::string_view::npos) end = url.size();
+    std::string_view segment = url.substr(pos, end - pos); // inkl. führendem '/'
+    std::string_view value = segment.substr(segment.starts_with('/') ? 1 : 0);
+
+    bool hasDigit = std::any_of(value.begin(), value.end(),
+                                [](unsigned char c) { return std::isdigit(c); });
+    bool allDigits = !value.empty() && std::all_of(value.begin(), value.end(), [](unsigned char c) {
+      return std::isdigit(c);
+    });
+    if (allDigits || (hasDigit && value.size() >= 8)) {
+      route += "/<string>";
+    } else {
+      route += segment;
+    }
+    pos = end;
+  }
+  return route.empty() ? "/" : route;
+}
+
+void HttpMetrics::record(const std::string &method, const std::string &url, int status,
+                         std::chrono::steady_clock::time_point started) {
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  std::string route = routeTemplate(url);
+  // Unbekannte Pfade (Scanner) erzeugen keine eigenen Labels
+  if (status == 404 && !isRouteKnown(method, route)) route = "unmatched";
+
+  RouteMetrics *metrics = routeMetrics(method, route, MAX_ROUTES);
+  if (!metrics) metrics = routeMetrics(method, "other", MAX_ROUTES);
+  if (!metrics) return;
+
+  int cls = std::clamp(status / 100, 1, 5) - 1;
+  metrics->byClass[static_cast<size_t>(cls)]->inc();
+  metrics->latency->observe(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+}
+
+} // namespace utils
+} // namespace rz
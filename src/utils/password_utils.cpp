@@ -2,55 +2,67 @@
  * @file password_utils.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief Password Hashing Utilities
- * @version 0.1.1
- * @date 2026-01-03
+ * @version 0.5.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
  * SPDX-License-Identifier: MIT
  */
 
-// (OWASP Empfehlungen).
+// (OWASP Empfehlungen) als Default, per Environment oder Kalibrierung änderbar.
 // Time Cost(t) : 3 Iterationen
 // Memory Cost(m) : 64 MB(65536 KB)
 // Parallelism(p) : 4 Threads
 
 #include "utils/password_utils.hpp"
+#include "utils/env_loader.hpp"
+#include "services/async.hpp"
 #include "argon2.h"
 #include <QByteArray>
 #include <QDebug>
+#include <QRegularExpression>
+#include <QStringList>
 #include <QUuid>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <random>
 #include <vector>
 
-// Interne Konstanten für Argon2id Sicherheit
-const uint32_t T_COST = 3;      // 3 Iterationen
-const uint32_t M_COST = 65536;  // 64 MiB RAM Nutzung
-const uint32_t PARALLELISM = 4; // 4 Lanes
+// Interne Konstanten für Argon2id
 const uint32_t SALT_LEN = 16;   // 16 Bytes Salt
 const uint32_t HASH_LEN = 32;   // 32 Bytes Output Hash
+const uint32_t MIN_MEMORY_KIB = 19456; // OWASP Minimum (19 MiB)
+
+// Aktive Parameter für neue Hashes
+static std::mutex g_paramsMutex;
+static rz::utils::Argon2Params g_params;
+
+// Vom Supervisor an die Prefork-Worker vererbt ("t,m,p"), nicht für die .env gedacht
+static const char *WORKER_PARAMS_ENV = "CAKE_ARGON2_WORKER_PARAMS";
 
 // Namespace rz::utils
 namespace rz {
 namespace utils {
 
-QString PasswordUtils::hashPassword(const QString &plainText) {
+static QString hashWithParams(const QString &plainText, const Argon2Params &p) {
   uint8_t salt[SALT_LEN];
   std::random_device rd;
-  std::uniform_int_distribution<uint8_t> dist(0, 255);
+  std::uniform_int_distribution<uint16_t> dist(0, 255);
   for (uint32_t i = 0; i < SALT_LEN; ++i) {
-    salt[i] = dist(rd);
+    salt[i] = static_cast<uint8_t>(dist(rd));
   }
 
-  size_t encodedLen = argon2_encodedlen(T_COST, M_COST, PARALLELISM, SALT_LEN,
-                                        HASH_LEN, Argon2_id);
+  size_t encodedLen = argon2_encodedlen(p.timeCost, p.memoryCostKiB, p.parallelism,
+                                        SALT_LEN, HASH_LEN, Argon2_id);
   std::vector<char> encoded(encodedLen);
 
   QByteArray pwdBytes = plainText.toUtf8();
 
   int result = argon2id_hash_encoded(
-      T_COST, M_COST, PARALLELISM, pwdBytes.data(), pwdBytes.length(), salt,
-      SALT_LEN, HASH_LEN, encoded.data(), encodedLen);
+      p.timeCost, p.memoryCostKiB, p.parallelism, pwdBytes.data(), pwdBytes.length(),
+      salt, SALT_LEN, HASH_LEN, encoded.data(), encodedLen);
 
   if (result != ARGON2_OK) {
     qCritical() << "Argon2 Hashing fehlgeschlagen, Error Code:" << result;
@@ -60,6 +72,10 @@ QString PasswordUtils::hashPassword(const QString &plainText) {
   return QString::fromLatin1(encoded.data());
 }
 
+QString PasswordUtils::hashPassword(const QString &plainText) {
+  return hashWithParams(plainText, currentParams());
+}
+
 bool PasswordUtils::verifyPassword(const QString &plainText,
                                    const QString &encodedHash) {
   if (encodedHash.isEmpty())
@@ -74,5 +90,128 @@ bool PasswordUtils::verifyPassword(const QString &plainText,
   return (result == ARGON2_OK);
 }
 
+Argon2Params PasswordUtils::currentParams() {
+  std::lock_guard<std::mutex> lock(g_paramsMutex);
+  return g_params;
+}
+
+void PasswordUtils::setParams(const Argon2Params &params) {
+  std::lock_guard<std::mutex> lock(g_paramsMutex);
+  g_params = params;
+}
+
+void PasswordUtils::configureFromEnv() {
+  Argon2Params params = currentParams();
+
+  // Prefork-Worker übernehmen die Werte des Supervisors: eigene Kalibrierungen
+  // konkurrieren um dieselben Kerne, landen bei anderen t/m und needsRehash
+  // würde bei jedem Login auf einem anderen Worker neu hashen
+  const QStringList inherited = qEnvironmentVariable(WORKER_PARAMS_ENV).split(',');
+  bool inheritedOk = inherited.size() == 3;
+  Argon2Params fromSupervisor;
+  if (inheritedOk) {
+    bool okT = false, okM = false, okP = false;
+    fromSupervisor.timeCost = inherited[0].toUInt(&okT);
+    fromSupervisor.memoryCostKiB = inherited[1].toUInt(&okM);
+    fromSupervisor.parallelism = inherited[2].toUInt(&okP);
+    inheritedOk = okT && okM && okP;
+  }
+
+  if (inheritedOk) {
+    params = fromSupervisor;
+  } else if (EnvLoader::get("CAKE_ARGON2_CALIBRATE", "false").compare("true", Qt::CaseInsensitive) == 0) {
+    params = calibrate(EnvLoader::getInt("CAKE_ARGON2_TARGET_MS", 250),
+                       EnvLoader::getInt("CAKE_ARGON2_MAX_MEMORY_KIB", 65536),
+                       EnvLoader::getInt("CAKE_ARGON2_P", params.parallelism));
+  } else {
+    params.timeCost = EnvLoader::getInt("CAKE_ARGON2_T", params.timeCost);
+    params.memoryCostKiB = EnvLoader::getInt("CAKE_ARGON2_M_KIB", params.memoryCostKiB);
+    params.parallelism = EnvLoader::getInt("CAKE_ARGON2_P", params.parallelism);
+  }
+
+  setParams(params);
+  qInfo() << "Argon2id Parameter: t =" << params.timeCost << "m =" << params.memoryCostKiB
+          << "KiB p =" << params.parallelism;
+}
+
+void PasswordUtils::exportToWorkers() {
+  const Argon2Params params = currentParams();
+  qputenv(WORKER_PARAMS_ENV, QByteArray::number(params.timeCost) + ',' +
+                                 QByteArray::number(params.memoryCostKiB) + ',' +
+                                 QByteArray::number(params.parallelism));
+}
+
+Argon2Params PasswordUtils::calibrate(uint32_t targetMs, uint32_t maxMemoryKiB,
+                                      uint32_t parallelism) {
+  using Clock = std::chrono::steady_clock;
+  const QString probe = QUuid::createUuid().toString();
+
+  // Bestes von 3 Läufen, um Ausreißer (Scheduler, Page Faults) zu glätten
+  auto measureMs = [&probe](const Argon2Params &p) {
+    double best = 0.0;
+    for (int i = 0; i < 3; ++i) {
+      auto start = Clock::now();
+      hashWithParams(probe, p);
+      double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+  };
+
+  Argon2Params p;
+  p.parallelism = parallelism > 0 ? parallelism : 1;
+  p.memoryCostKiB = std::max(maxMemoryKiB, MIN_MEMORY_KIB);
+  p.timeCost = 1;
+
+  // 1. Speicher reduzieren, bis t=1 ins Budget passt
+  double ms = measureMs(p);
+  while (ms > targetMs && p.memoryCostKiB / 2 >= MIN_MEMORY_KIB) {
+    p.memoryCostKiB /= 2;
+    ms = measureMs(p);
+  }
+
+  // 2. Iterationen erhöhen, solange die Ziel-Latenz gehalten wird
+  while (true) {
+    Argon2Params next = p;
+    next.timeCost = p.timeCost + 1;
+    // Laufzeit skaliert linear mit t: Messung nur, wenn es plausibel passt
+    if (ms * next.timeCost / p.timeCost > targetMs * 1.1) break;
+    double nextMs = measureMs(next);
+    if (nextMs > targetMs) break;
+    p = next;
+    ms = nextMs;
+  }
+
+  qInfo() << "Argon2id Kalibrierung:" << ms << "ms pro Hash (Ziel" << targetMs << "ms)";
+  return p;
+}
+
+std::optional<Argon2Params> PasswordUtils::parseParams(const QString &encodedHash) {
+  static const QRegularExpression re(
+      R"(^\$argon2id\$v=19\$m=(\d+),t=(\d+),p=(\d+)\$)");
+  auto match = re.match(encodedHash);
+  if (!match.hasMatch()) return std::nullopt;
+
+  Argon2Params p;
+  p.memoryCostKiB = match.captured(1).toUInt();
+  p.timeCost = match.captured(2).toUInt();
+  p.parallelism = match.captured(3).toUInt();
+  return p;
+}
+
+bool PasswordUtils::needsRehash(const QString &encodedHash) {
+  auto params = parseParams(encodedHash);
+  return !params || *params != currentParams();
+}
+
+rz::service::Task<QString> PasswordUtils::hashPasswordAsync(QString plainText) {
+  co_return co_await rz::service::runHashed([plainText]() { return hashPassword(plainText); });
+}
+
+rz::service::Task<bool> PasswordUtils::verifyPasswordAsync(QString plainText, QString encodedHash) {
+  co_return co_await rz::service::runHashed(
+      [plainText, encodedHash]() { return verifyPassword(plainText, encodedHash); });
+}
+
 } // namespace utils
 } // namespace rz
@@ -0,0 +1,144 @@
+/**
+ * @file rate_limiter.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Sharded token bucket rate limiter
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/rate_limiter.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rz {
+namespace utils {
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void RateLimiter::configure(double perMinute, double burst) {
+  m_ratePerSecond.store(perMinute / 60.0, std::memory_order_relaxed);
+  m_burst.store(std::max(1.0, burst), std::memory_order_relaxed);
+}
+
+int RateLimiter::acquire(const std::string &key) {
+  double ratePerSecond = m_ratePerSecond.load(std::memory_order_relaxed);
+  if (ratePerSecond <= 0.0) {
+    m_allowed.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+  double burst = m_burst.load(std::memory_order_relaxed);
+  double ratePerNs = ratePerSecond / 1e9;
+
+  int64_t now = nowNs();
+  Shard &shard = m_shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (++shard.opsSinceSweep >= SWEEP_INTERVAL) {
+    sweep(shard, now, ratePerNs, burst);
+  }
+
+  auto [it, inserted] = shard.buckets.try_emplace(key, Bucket{burst, now});
+  Bucket &b = it->second;
+  if (!inserted) {
+    b.tokens = std::min(burst, b.tokens + (now - b.lastRefillNs) * ratePerNs);
+    b.lastRefillNs = now;
+  }
+
+  if (b.tokens >= 1.0) {
+    b.tokens -= 1.0;
+    m_allowed.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  m_limited.fetch_add(1, std::memory_order_relaxed);
+  return std::max(1, static_cast<int>(std::ceil((1.0 - b.tokens) / ratePerSecond)));
+}
+
+void RateLimiter::sweep(Shard &shard, int64_t now, double ratePerNs, double burst) {
+  shard.opsSinceSweep = 0;
+  // Voll aufgefüllte Buckets tragen keinen Zustand mehr
+  std::erase_if(shard.buckets, [&](const auto &entry) {
+    const Bucket &b = entry.second;
+    bool full = b.tokens + (now - b.lastRefillNs) * ratePerNs >= burst;
+    if (full) m_evicted.fetch_add(1, std::memory_order_relaxed);
+    return full;
+  });
+}
+
+RateLimiter::Stats RateLimiter::stats() const {
+  Stats s;
+  s.allowed = m_allowed.load(std::memory_order_relaxed);
+  s.limited = m_limited.load(std::memory_order_relaxed);
+  s.evicted = m_evicted.load(std::memory_order_relaxed);
+  for (const auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    s.buckets += shard.buckets.size();
+  }
+  return s;
+}
+
+AuthRateLimiter &AuthRateLimiter::instance() {
+  static AuthRateLimiter instance;
+  return instance;
+}
+
+void AuthRateLimiter::configureFromEnv() {
+  double ipPerMin = EnvLoader::getInt("CAKE_RATE_IP_PER_MIN", 20);
+  double ipBurst = EnvLoader::getInt("CAKE_RATE_IP_BURST", 10);
+  double mailPerMin = EnvLoader::getInt("CAKE_RATE_EMAIL_PER_MIN", 5);
+  double mailBurst = EnvLoader::getInt("CAKE_RATE_EMAIL_BURST", 5);
+
+  m_byIp.configure(ipPerMin, ipBurst);
+  m_byEmail.configure(mailPerMin, mailBurst);
+  // Anzahl vertrauenswürdiger Proxies; "true"/"false" wie bisher als 1/0
+  QString trust = EnvLoader::get("CAKE_TRUST_PROXY", "0").trimmed();
+  int hops = trust.compare("true", Qt::CaseInsensitive) == 0 ? 1 : std::max(0, trust.toInt());
+  m_trustedHops.store(hops, std::memory_order_relaxed);
+
+  qInfo() << "Rate-Limits Login/Registrierung: IP" << ipPerMin << "/min (Burst" << ipBurst
+          << "), E-Mail" << mailPerMin << "/min (Burst" << mailBurst << "), Proxies" << hops;
+}
+
+std::string AuthRateLimiter::clientIp(const std::string &remoteIp,
+                                      const std::string &forwarded) const {
+  const int hops = m_trustedHops.load(std::memory_order_relaxed);
+  if (hops <= 0 || forwarded.empty()) return remoteIp;
+
+  // Von rechts zählen: der letzte Eintrag stammt vom nächsten Proxy
+  std::vector<std::string> entries;
+  size_t start = 0;
+  while (start <= forwarded.size()) {
+    size_t end = forwarded.find(',', start);
+    if (end == std::string::npos) end = forwarded.size();
+    size_t first = forwarded.find_first_not_of(" \t", start);
+    size_t last = forwarded.find_last_not_of(" \t", end == 0 ? 0 : end - 1);
+    if (first != std::string::npos && first < end && last >= first) {
+      entries.push_back(forwarded.substr(first, last - first + 1));
+    }
+    start = end + 1;
+  }
+  if (entries.empty()) return remoteIp;
+
+  // Weniger Einträge als Proxies: der Request kam nicht über alle, der
+  // linkeste Eintrag ist dann die vom ersten Proxy gesehene Adresse
+  size_t index = entries.size() > static_cast<size_t>(hops) ? entries.size() - hops : 0;
+  return entries[index];
+}
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,171 @@
+/**
+ * @file request_trace.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Per-request phase timing, Server-Timing header and trace sampling
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/request_trace.hpp"
+#include "utils/env_loader.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace rz {
+namespace utils {
+
+namespace {
+
+thread_local RequestTrace *t_current = nullptr;
+
+// Schneller Zufall für das Sampling (xorshift64, pro Thread)
+uint64_t nextRandom() {
+  thread_local uint64_t state =
+      static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) |
+      1;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+void appendTiming(std::string &out, const char *name, int64_t ns) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%s%s;dur=%.3f", out.empty() ? "" : ", ", name, ns / 1e6);
+  out += buf;
+}
+
+} // namespace
+
+// --- RequestTrace ---
+
+RequestTrace *RequestTrace::current() { return t_current; }
+
+void RequestTrace::begin() {
+  auto &buffer = TraceBuffer::instance();
+  t_current = buffer.enabled() ? this : nullptr;
+  if (!t_current) return;
+  m_active = true;
+  m_sampled = buffer.sample();
+  m_count = 0;
+  m_started = Clock::now();
+}
+
+void RequestTrace::add(const char *name, std::chrono::nanoseconds duration) {
+  for (size_t i = 0; i < m_count; ++i) {
+    if (m_phases[i].name == name || std::strcmp(m_phases[i].name, name) == 0) {
+      m_phases[i].ns += duration.count();
+      return;
+    }
+  }
+  if (m_count < MAX_PHASES) m_phases[m_count++] = {name, duration.count()};
+}
+
+std::string RequestTrace::finish(const std::string &method, const std::string &url, int status,
+                                 const std::string &userId) {
+  if (!m_active) return {};
+  m_active = false;
+  if (t_current == this) t_current = nullptr;
+
+  int64_t totalNs = (Clock::now() - m_started).count();
+  auto &buffer = TraceBuffer::instance();
+
+  bool slow = buffer.slowNs() > 0 && totalNs >= buffer.slowNs();
+  if (m_sampled || slow) {
+    TraceBuffer::Record record;
+    record.startedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count() -
+                         totalNs / 1000000;
+    record.method = method;
+    record.path = url.substr(0, url.find('?'));
+    record.userId = userId;
+    record.status = status;
+    record.totalUs = totalNs / 1000;
+    record.slow = slow;
+    for (size_t i = 0; i < m_count; ++i) {
+      record.phasesUs.emplace_back(m_phases[i].name, m_phases[i].ns / 1000);
+    }
+    buffer.push(std::move(record));
+  }
+
+  if (!buffer.serverTiming()) return {};
+  std::string header;
+  for (size_t i = 0; i < m_count; ++i) appendTiming(header, m_phases[i].name, m_phases[i].ns);
+  appendTiming(header, "total", totalNs);
+  return header;
+}
+
+// --- TraceBuffer ---
+
+TraceBuffer &TraceBuffer::instance() {
+  static TraceBuffer instance;
+  return instance;
+}
+
+void TraceBuffer::configureFromEnv() {
+  m_serverTiming = EnvLoader::getInt("CAKE_SERVER_TIMING", 0) != 0;
+  m_sampleRate = std::clamp(EnvLoader::get("CAKE_TRACE_SAMPLE_RATE", "0").toDouble(), 0.0, 1.0);
+  m_slowNs = static_cast<int64_t>(std::max(0, EnvLoader::getInt("CAKE_TRACE_SLOW_MS", 0))) *
+             1000000;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_capacity = static_cast<size_t>(std::max(1, EnvLoader::getInt("CAKE_TRACE_BUFFER", 256)));
+  m_ring.clear();
+  m_ring.reserve(m_capacity);
+  m_next = 0;
+
+  qInfo() << "[Trace] Server-Timing" << (m_serverTiming ? "an" : "aus") << ", Sampling"
+          << m_sampleRate << ", langsam ab" << m_slowNs / 1000000 << "ms";
+}
+
+bool TraceBuffer::sample() const {
+  if (m_sampleRate <= 0.0) return false;
+  if (m_sampleRate >= 1.0) return true;
+  // Obere 53 Bit als Zahl in [0, 1)
+  return static_cast<double>(nextRandom() >> 11) * 0x1.0p-53 < m_sampleRate;
+}
+
+void TraceBuffer::push(Record record) {
+  record.id = m_recorded.fetch_add(1, std::memory_order_relaxed) + 1;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_ring.size() < m_capacity) {
+    m_ring.push_back(std::move(record));
+  } else {
+    m_ring[m_next] = std::move(record);
+  }
+  m_next = (m_next + 1) % m_capacity;
+}
+
+std::vector<TraceBuffer::Record> TraceBuffer::recent(size_t limit, int minMs) const {
+  std::vector<Record> result;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const size_t size = m_ring.size();
+  for (size_t i = 1; i <= size && result.size() < limit; ++i) {
+    const auto &record = m_ring[(m_next + m_capacity - i) % m_capacity];
+    if (record.totalUs >= static_cast<int64_t>(minMs) * 1000) result.push_back(record);
+  }
+  return result;
+}
+
+TraceBuffer::Stats TraceBuffer::stats() const {
+  Stats s;
+  s.sampleRate = m_sampleRate;
+  s.slowMs = static_cast<int>(m_slowNs / 1000000);
+  s.serverTiming = m_serverTiming;
+  s.recorded = m_recorded.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  s.capacity = m_capacity;
+  s.stored = m_ring.size();
+  return s;
+}
+
+} // namespace utils
+} // namespace rz
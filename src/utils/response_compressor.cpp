@@ -0,0 +1,374 @@
+/**
+ * @file response_compressor.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Negotiated HTTP response compression (gzip/deflate, brotli/zstd)
+ * @version 0.3.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/response_compressor.hpp"
+#include "utils/env_loader.hpp"
+#include "utils/request_trace.hpp"
+
+#include <QDebug>
+#include <QString>
+#include <QStringList>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <zlib.h>
+#ifdef CAKE_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef CAKE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace rz {
+namespace utils {
+
+namespace {
+
+// q-Wert eines Tokens in "gzip;q=0.8, br" (0 = nicht akzeptiert)
+double qualityOf(std::string_view acceptEncoding, std::string_view token) {
+  double wildcard = -1;
+  size_t pos = 0;
+  while (pos < acceptEncoding.size()) {
+    size_t end = acceptEncoding.find(',', pos);
+    if (end == std::string_view::npos) end = acceptEncoding.size();
+    std::string_view item = acceptEncoding.substr(pos, end - pos);
+    pos = end + 1;
+
+    size_t semi = item.find(';');
+    std::string_view coding = item.substr(0, semi);
+    while (!coding.empty() && std::isspace(static_cast<unsigned char>(coding.front())))
+      coding.remove_prefix(1);
+    while (!coding.empty() && std::isspace(static_cast<unsigned char>(coding.back())))
+      coding.remove_suffix(1);
+
+    double q = 1.0;
+    if (semi != std::string_view::npos) {
+      size_t qpos = item.find("q=", semi);
+      if (qpos != std::string_view::npos) q = std::atof(std::string(item.substr(qpos + 2)).c_str());
+    }
+
+    std::string lower(coding);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == token) return q;
+    if (lower == "*") wildcard = q;
+  }
+  return wildcard < 0 ? 0.0 : wildcard;
+}
+
+std::string zlibEncode(std::string_view body, int level, bool gzip) {
+  z_stream stream = {};
+  // 15 = zlib-Format ("deflate" in HTTP), +16 = gzip-Header
+  if (deflateInit2(&stream, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return {};
+  }
+  std::string out;
+  out.resize(deflateBound(&stream, static_cast<uLong>(body.size())) + 32);
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+  stream.avail_in = static_cast<uInt>(body.size());
+  stream.next_out = reinterpret_cast<Bytef *>(out.data());
+  stream.avail_out = static_cast<uInt>(out.size());
+
+  int rc = deflate(&stream, Z_FINISH);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return rc == Z_STREAM_END ? out : std::string();
+}
+
+} // namespace
+
+ResponseCompressor &ResponseCompressor::instance() {
+  static ResponseCompressor instance;
+  return instance;
+}
+
+void ResponseCompressor::configureFromEnv() {
+  m_enabled = EnvLoader::getInt("CAKE_COMPRESS", 1) != 0;
+  m_minBytes = static_cast<size_t>(std::max(0, EnvLoader::getInt("CAKE_COMPRESS_MIN_BYTES", 1024)));
+  m_maxBytes = static_cast<size_t>(
+      std::max(1024, EnvLoader::getInt("CAKE_COMPRESS_MAX_BYTES", 8 * 1024 * 1024)));
+  m_minSavingPct = std::clamp(EnvLoader::getInt("CAKE_COMPRESS_MIN_SAVING_PCT", 10), 0, 90);
+  m_gzipLevel = std::clamp(EnvLoader::getInt("CAKE_COMPRESS_GZIP_LEVEL", 4), 1, 9);
+  m_brotliLevel = std::clamp(EnvLoader::getInt("CAKE_COMPRESS_BROTLI_LEVEL", 4), 0, 11);
+  m_zstdLevel = std::clamp(EnvLoader::getInt("CAKE_COMPRESS_ZSTD_LEVEL", 3), 1, 19);
+  m_cacheCapacity = static_cast<size_t>(
+      std::max(0, EnvLoader::getInt("CAKE_COMPRESS_CACHE_BYTES", 8 * 1024 * 1024)));
+
+  // SSE, WebSocket und Fotos nie; eigene Regeln überschreiben gleiche Präfixe
+  QString spec = "/api/events/stream=off,/api/ws=off,/api/uploads=off,/static=off," +
+                 EnvLoader::get("CAKE_COMPRESS_ROUTES", "");
+  m_routes.clear();
+  for (const auto &item : spec.split(',', Qt::SkipEmptyParts)) {
+    auto parts = item.trimmed().split('=');
+    if (parts.size() != 2 || !parts[0].startsWith('/')) continue;
+    RoutePolicy policy;
+    policy.prefix = parts[0].trimmed().toStdString();
+    QString value = parts[1].trimmed().toLower();
+    policy.enabled = value != "off";
+    if (policy.enabled && value != "on") policy.level = value.toInt();
+
+    auto existing = std::find_if(m_routes.begin(), m_routes.end(),
+                                 [&](const RoutePolicy &r) { return r.prefix == policy.prefix; });
+    if (existing != m_routes.end()) {
+      *existing = policy;
+    } else {
+      m_routes.push_back(policy);
+    }
+  }
+  std::sort(m_routes.begin(), m_routes.end(), [](const RoutePolicy &a, const RoutePolicy &b) {
+    return a.prefix.size() > b.prefix.size();
+  });
+
+  QStringList encodings;
+  for (const auto &e : stats().encodings) encodings << QString::fromStdString(e);
+  qInfo() << "[Compress]" << (m_enabled ? "aktiv:" : "aus:") << encodings.join(", ") << "ab"
+          << m_minBytes << "Bytes, gzip-Level" << m_gzipLevel;
+}
+
+const char *ResponseCompressor::name(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::Deflate:
+    return "deflate";
+  case Encoding::Gzip:
+    return "gzip";
+  case Encoding::Brotli:
+    return "br";
+  case Encoding::Zstd:
+    return "zstd";
+  default:
+    return "identity";
+  }
+}
+
+ResponseCompressor::Encoding ResponseCompressor::negotiate(std::string_view acceptEncoding) const {
+  if (acceptEncoding.empty()) return Encoding::Identity;
+
+  // Bei gleichem q-Wert gewinnt die Reihenfolge (bestes Verhältnis zuerst)
+  Encoding best = Encoding::Identity;
+  double bestQ = 0.0;
+  auto consider = [&](Encoding encoding) {
+    double q = qualityOf(acceptEncoding, name(encoding));
+    if (q > bestQ) {
+      best = encoding;
+      bestQ = q;
+    }
+  };
+#ifdef CAKE_HAVE_ZSTD
+  consider(Encoding::Zstd);
+#endif
+#ifdef CAKE_HAVE_BROTLI
+  consider(Encoding::Brotli);
+#endif
+  consider(Encoding::Gzip);
+  consider(Encoding::Deflate);
+  return best;
+}
+
+const ResponseCompressor::RoutePolicy *ResponseCompressor::policyFor(std::string_view path) const {
+  for (const auto &route : m_routes) {
+    if (path.starts_with(route.prefix)) return &route;
+  }
+  return nullptr;
+}
+
+bool ResponseCompressor::compressibleType(std::string_view contentType) {
+  // Ohne Content-Type: Crow-Text-Antworten
+  if (contentType.empty()) return true;
+  if (contentType.starts_with("text/event-stream")) return false;
+  return contentType.starts_with("text/") || contentType.starts_with("application/json") ||
+         contentType.starts_with("application/javascript") ||
+         contentType.starts_with("application/xml") || contentType.starts_with("image/svg+xml");
+}
+
+int ResponseCompressor::defaultLevel(Encoding encoding) const {
+  switch (encoding) {
+  case Encoding::Brotli:
+    return m_brotliLevel;
+  case Encoding::Zstd:
+    return m_zstdLevel;
+  default:
+    return m_gzipLevel;
+  }
+}
+
+std::string ResponseCompressor::encode(std::string_view body, Encoding encoding, int level) const {
+  switch (encoding) {
+  case Encoding::Gzip:
+    return zlibEncode(body, std::clamp(level, 1, 9), true);
+  case Encoding::Deflate:
+    return zlibEncode(body, std::clamp(level, 1, 9), false);
+#ifdef CAKE_HAVE_BROTLI
+  case Encoding::Brotli: {
+    std::string out(BrotliEncoderMaxCompressedSize(body.size()), '\0');
+    size_t outSize = out.size();
+    if (!BrotliEncoderCompress(std::clamp(level, 0, 11), BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               body.size(), reinterpret_cast<const uint8_t *>(body.data()),
+                               &outSize, reinterpret_cast<uint8_t *>(out.data()))) {
+      return {};
+    }
+    out.resize(outSize);
+    return out;
+  }
+#endif
+#ifdef CAKE_HAVE_ZSTD
+  case Encoding::Zstd: {
+    // Kontext pro Thread wiederverwenden (spart die Allokation pro Antwort)
+    thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> ctx(ZSTD_createCCtx(),
+                                                                          ZSTD_freeCCtx);
+    std::string out(ZSTD_compressBound(body.size()), '\0');
+    size_t size = ZSTD_compressCCtx(ctx.get(), out.data(), out.size(), body.data(), body.size(),
+                                    std::clamp(level, 1, 19));
+    if (ZSTD_isError(size)) return {};
+    out.resize(size);
+    return out;
+  }
+#endif
+  default:
+    return {};
+  }
+}
+
+void ResponseCompressor::apply(const crow::request &req, crow::response &res) {
+  if (!m_enabled || req.method == crow::HTTPMethod::Head) return;
+  if (res.code < 200 || res.code == 204 || (res.code != 304 && res.body.empty())) return;
+  if (!res.get_header_value("Content-Encoding").empty()) return;
+  if (!compressibleType(res.get_header_value("Content-Type"))) return;
+
+  const RoutePolicy *policy = policyFor(req.url);
+  if (policy && !policy->enabled) return;
+
+  // Ab hier hängt die Darstellung von Accept-Encoding ab
+  res.add_header("Vary", "Accept-Encoding");
+  Encoding encoding = negotiate(req.get_header_value("Accept-Encoding"));
+  if (encoding == Encoding::Identity) return;
+
+  std::string etag = res.get_header_value("ETag");
+  if (res.code == 304) {
+    // Gleiche (schwache) ETag wie die komprimierte 200-Antwort
+    if (!etag.empty() && !etag.starts_with("W/")) res.set_header("ETag", "W/" + etag);
+    return;
+  }
+
+  if (res.body.size() < m_minBytes || res.body.size() > m_maxBytes) {
+    m_skippedSmall.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  m_eligible.fetch_add(1, std::memory_order_relaxed);
+
+  int level = policy && policy->level > 0 ? policy->level : defaultLevel(encoding);
+  std::string key;
+  Bytes bytes;
+  bool cached = false;
+  if (!etag.empty() && m_cacheCapacity > 0) {
+    key = etag + '|' + name(encoding) + '|' + std::to_string(level);
+    cached = cacheGet(key, bytes);
+  }
+
+  if (cached) {
+    m_cacheHits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    auto started = std::chrono::steady_clock::now();
+    std::string out = encode(res.body, encoding, level);
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    m_cpuUs.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+                      std::memory_order_relaxed);
+    // Läuft nach AuthMiddleware::after_handle: eigener Eintrag, aber nur wo
+    // die schon Server-Timing gesetzt hat (Admins, nie öffentliche Routen)
+    if (TraceBuffer::instance().serverTiming() &&
+        !res.get_header_value("Server-Timing").empty()) {
+      char timing[48];
+      std::snprintf(timing, sizeof(timing), "compress;dur=%.3f",
+                    std::chrono::duration<double, std::milli>(elapsed).count());
+      res.add_header("Server-Timing", timing);
+    }
+
+    // Lohnt sich nicht (schon komprimiert, zu klein): Original senden
+    size_t limit = res.body.size() * static_cast<size_t>(100 - m_minSavingPct) / 100;
+    if (!out.empty() && out.size() <= limit) {
+      bytes = std::make_shared<const std::string>(std::move(out));
+    }
+    if (!key.empty()) cachePut(key, bytes);
+  }
+
+  if (!bytes) {
+    m_skippedNotWorth.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  m_compressed.fetch_add(1, std::memory_order_relaxed);
+  m_bytesIn.fetch_add(res.body.size(), std::memory_order_relaxed);
+  m_bytesOut.fetch_add(bytes->size(), std::memory_order_relaxed);
+  res.body = *bytes;
+  res.set_header("Content-Encoding", name(encoding));
+  if (!etag.empty() && !etag.starts_with("W/")) res.set_header("ETag", "W/" + etag);
+}
+
+bool ResponseCompressor::cacheGet(const std::string &key, Bytes &out) {
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  auto it = m_cache.find(key);
+  if (it == m_cache.end()) return false;
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+  out = it->second.bytes;
+  return true;
+}
+
+void ResponseCompressor::cachePut(const std::string &key, Bytes bytes) {
+  // Auch "lohnt nicht" merken, damit es nicht erneut versucht wird
+  size_t size = key.size() + (bytes ? bytes->size() : 0);
+  if (size > m_cacheCapacity / 4) return;
+
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  if (m_cache.contains(key)) return;
+  m_lru.push_front(key);
+  m_cache.emplace(key, CacheEntry{std::move(bytes), m_lru.begin()});
+  m_cacheBytes += size;
+
+  while (m_cacheBytes > m_cacheCapacity && !m_lru.empty()) {
+    auto victim = m_cache.find(m_lru.back());
+    m_cacheBytes -= victim->first.size() + (victim->second.bytes ? victim->second.bytes->size() : 0);
+    m_cache.erase(victim);
+    m_lru.pop_back();
+  }
+}
+
+ResponseCompressor::Stats ResponseCompressor::stats() const {
+  Stats s;
+  s.eligible = m_eligible.load(std::memory_order_relaxed);
+  s.compressed = m_compressed.load(std::memory_order_relaxed);
+  s.skippedSmall = m_skippedSmall.load(std::memory_order_relaxed);
+  s.skippedNotWorth = m_skippedNotWorth.load(std::memory_order_relaxed);
+  s.cacheHits = m_cacheHits.load(std::memory_order_relaxed);
+  s.bytesIn = m_bytesIn.load(std::memory_order_relaxed);
+  s.bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+  s.cpuUs = m_cpuUs.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    s.cacheBytes = m_cacheBytes;
+    s.cacheEntries = m_cache.size();
+  }
+#ifdef CAKE_HAVE_ZSTD
+  s.encodings.push_back("zstd");
+#endif
+#ifdef CAKE_HAVE_BROTLI
+  s.encodings.push_back("br");
+#endif
+  s.encodings.push_back("gzip");
+  s.encodings.push_back("deflate");
+  return s;
+}
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,98 @@
+/**
+ * @file reuse_port.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief SO_REUSEPORT for the HTTP listener in prefork mode
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/reuse_port.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace rz {
+namespace utils {
+
+namespace {
+std::atomic<int> g_port{0}; // 0 = aus
+} // namespace
+
+bool ReusePort::enable(int port) {
+#ifdef SO_REUSEPORT
+  if (port <= 0 || port > 65535) return false;
+  g_port.store(port, std::memory_order_release);
+  return true;
+#else
+  (void)port;
+  return false;
+#endif
+}
+
+bool ReusePort::enabled() { return g_port.load(std::memory_order_acquire) != 0; }
+
+int ReusePort::port() { return g_port.load(std::memory_order_acquire); }
+
+} // namespace utils
+} // namespace rz
+
+#ifndef __THROW
+#define __THROW // nicht-glibc: Deklaration ohne Exception-Spezifikation
+#endif
+
+namespace {
+
+using BindFn = int (*)(int, const struct sockaddr *, socklen_t);
+
+BindFn resolveBind() {
+  auto fn = reinterpret_cast<BindFn>(dlsym(RTLD_NEXT, "bind"));
+  if (!fn) {
+    // Ohne das echte bind() kann kein Socket mehr gebunden werden: sofort laut abbrechen
+    std::fprintf(stderr, "[ReusePort] bind() der libc nicht gefunden: %s\n", dlerror());
+    std::abort();
+  }
+  return fn;
+}
+
+// Zielport des bind()-Aufrufs, 0 für andere Adressfamilien
+int boundPort(const struct sockaddr *addr, socklen_t len) {
+  if (!addr) return 0;
+  if (addr->sa_family == AF_INET && len >= sizeof(sockaddr_in)) {
+    return ntohs(reinterpret_cast<const sockaddr_in *>(addr)->sin_port);
+  }
+  if (addr->sa_family == AF_INET6 && len >= sizeof(sockaddr_in6)) {
+    return ntohs(reinterpret_cast<const sockaddr_in6 *>(addr)->sin6_port);
+  }
+  return 0;
+}
+
+} // namespace
+
+// Ersetzt bind() der libc für dieses Programm (asio/Crow rufen ::bind direkt).
+// Nur der TCP-Socket auf dem HTTP-Port bekommt SO_REUSEPORT; alles andere
+// (und jeder Aufruf ohne enable()) reicht unverändert durch.
+extern "C" int bind(int fd, const struct sockaddr *addr, socklen_t len) __THROW {
+  static const BindFn realBind = resolveBind();
+
+#ifdef SO_REUSEPORT
+  const int port = rz::utils::ReusePort::port();
+  if (port != 0 && boundPort(addr, len) == port) {
+    int type = 0;
+    socklen_t typeLen = sizeof(type);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &typeLen) == 0 && type == SOCK_STREAM) {
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    }
+  }
+#endif
+
+  return realBind(fd, addr, len);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file revocation_list.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief In-memory set of revoked session ids
+ * @version 0.2.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/revocation_list.hpp"
+
+#include <QDateTime>
+#include <algorithm>
+#include <mutex>
+
+namespace rz {
+namespace utils {
+
+RevocationList &RevocationList::instance() {
+  static RevocationList instance;
+  return instance;
+}
+
+// Aufräumen im Worker nach so vielen Widerrufen (ohne Housekeeping-Job)
+static constexpr size_t SWEEP_EVERY = 256;
+
+void RevocationList::load(const std::vector<std::pair<QString, qint64>> &sessions) {
+  std::unique_lock lock(m_mutex);
+  for (const auto &[id, expiresAt] : sessions) {
+    auto &until = m_revoked[id];
+    until = std::max(until, expiresAt);
+  }
+}
+
+void RevocationList::revoke(const QString &sessionId, qint64 expiresAt) {
+  if (sessionId.isEmpty()) return;
+  std::unique_lock lock(m_mutex);
+  auto &until = m_revoked[sessionId];
+  until = std::max(until, expiresAt);
+  if (++m_sinceSweep >= SWEEP_EVERY) pruneLocked(QDateTime::currentSecsSinceEpoch());
+}
+
+bool RevocationList::isRevoked(const QString &sessionId) const {
+  if (sessionId.isEmpty()) return false;
+  std::shared_lock lock(m_mutex);
+  return m_revoked.contains(sessionId);
+}
+
+size_t RevocationList::prune(qint64 now) {
+  std::unique_lock lock(m_mutex);
+  return pruneLocked(now);
+}
+
+size_t RevocationList::pruneLocked(qint64 now) {
+  m_sinceSweep = 0;
+  return std::erase_if(m_revoked, [now](const auto &entry) { return entry.second <= now; });
+}
+
+size_t RevocationList::size() const {
+  std::shared_lock lock(m_mutex);
+  return m_revoked.size();
+}
+
+} // namespace utils
+} // namespace rz
@@ -0,0 +1,109 @@
+/**
+ * @file token_cache.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Sharded LRU cache for verified JWT payloads
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utils/token_cache.hpp"
+
+#include <QDateTime>
+#include <openssl/sha.h>
+
+namespace rz {
+namespace utils {
+
+TokenCache &TokenCache::instance() {
+  static TokenCache instance;
+  return instance;
+}
+
+void TokenCache::setCapacity(size_t capacity) {
+  size_t perShard = capacity / SHARD_COUNT;
+  m_shardCapacity.store(perShard > 0 ? perShard : 1, std::memory_order_relaxed);
+}
+
+std::string TokenCache::hashToken(const std::string &rawToken) {
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(rawToken.data()),
+         rawToken.size(), digest);
+  return std::string(reinterpret_cast<const char *>(digest), sizeof(digest));
+}
+
+TokenCache::Shard &TokenCache::shardFor(const std::string &key) {
+  // Erstes Byte des SHA-256 ist gleichverteilt
+  return m_shards[static_cast<unsigned char>(key[0]) % SHARD_COUNT];
+}
+
+std::optional<TokenPayload> TokenCache::get(const std::string &rawToken) {
+  std::string key = hashToken(rawToken);
+  Shard &shard = shardFor(key);
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  if (it->second->payload.expiresAt <= now) {
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  m_hits.fetch_add(1, std::memory_order_relaxed);
+  return it->second->payload;
+}
+
+void TokenCache::put(const std::string &rawToken, const TokenPayload &payload) {
+  if (payload.expiresAt <= QDateTime::currentSecsSinceEpoch()) return;
+
+  std::string key = hashToken(rawToken);
+  Shard &shard = shardFor(key);
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    it->second->payload = payload;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return;
+  }
+
+  shard.lru.push_front(Entry{key, payload});
+  shard.index.emplace(std::move(key), shard.lru.begin());
+  evictOverflow(shard);
+}
+
+void TokenCache::invalidateUser(const QString &userId) {
+  for (auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+      if (it->payload.userId == userId) {
+        shard.index.erase(it->key);
+        it = shard.lru.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+void TokenCache::evictOverflow(Shard &shard) {
+  size_t capacity = m_shardCapacity.load(std::memory_order_relaxed);
+  while (shard.lru.size() > capacity) {
+    shard.index.erase(shard.lru.back().key);
+    shard.lru.pop_back();
+  }
+}
+
+} // namespace utils
+} // namespace rz
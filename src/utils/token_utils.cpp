@@ -2,8 +2,8 @@
  * @file token_utils.cpp
  * @author ZHENG Robert (robert@hase-zheng.net)
  * @brief JWT Token Utilities Implementation
- * @version 0.1.1
- * @date 2026-01-03
+ * @version 0.2.0
+ * @date 2026-10-18
  *
  * @copyright Copyright (c) 2025 ZHENG Robert
  *
@@ -12,8 +12,11 @@
 
 #include "utils/token_utils.hpp"
 #include "utils/env_loader.hpp"
+#include <QByteArray>
+#include <QCryptographicHash>
 #include <chrono>
 #include <iostream>
+#include <openssl/rand.h>
 
 // Zugriff auf JSON Traits für Bool-Konvertierung
 using json_value = jwt::traits::kazuho_picojson::value_type;
@@ -22,30 +25,77 @@ using json_value = jwt::traits::kazuho_picojson::value_type;
 namespace rz {
 namespace utils {
 
-// Helper im Namespace (findet jetzt EnvLoader)
-static std::string getSecret() {
-  QString secret = EnvLoader::get("CAKE_JWT_SECRET", "");
-  if (secret.isEmpty()) {
-    std::cerr
-        << "WARNUNG: CAKE_JWT_SECRET nicht gesetzt! Nutze unsicheren Default."
-        << std::endl;
-    return "CHANGE_ME_IN_PRODUCTION_THIS_IS_UNSAFE";
+// Secret wird genau einmal aus dem Environment gelesen (thread-safe static init)
+static const std::string &getSecret() {
+  static const std::string secret = [] {
+    QString value = EnvLoader::get("CAKE_JWT_SECRET", "");
+    if (value.isEmpty()) {
+      std::cerr
+          << "WARNUNG: CAKE_JWT_SECRET nicht gesetzt! Nutze unsicheren Default."
+          << std::endl;
+      return std::string("CHANGE_ME_IN_PRODUCTION_THIS_IS_UNSAFE");
+    }
+    return value.toStdString();
+  }();
+  return secret;
+}
+
+// Unveränderlicher Verifier, von allen Worker-Threads gemeinsam genutzt
+// (verifier::verify ist const und hält keinen veränderlichen Zustand)
+static const auto &getVerifier() {
+  static const auto verifier =
+      jwt::verify()
+          .allow_algorithm(jwt::algorithm::hs256{getSecret()})
+          .with_issuer("CakePlanner");
+  return verifier;
+}
+
+void TokenUtils::init() {
+  (void)getVerifier();
+  (void)accessTokenTtl();
+  (void)refreshTokenTtl();
+}
+
+qint64 TokenUtils::accessTokenTtl() {
+  static const qint64 ttl =
+      static_cast<qint64>(EnvLoader::getInt("CAKE_ACCESS_TOKEN_MINUTES", 15)) * 60;
+  return ttl;
+}
+
+qint64 TokenUtils::refreshTokenTtl() {
+  static const qint64 ttl =
+      static_cast<qint64>(EnvLoader::getInt("CAKE_REFRESH_TOKEN_DAYS", 30)) * 24 * 3600;
+  return ttl;
+}
+
+QString TokenUtils::generateRefreshToken() {
+  unsigned char bytes[32];
+  if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+    return QString();
   }
-  return secret.toStdString();
+  return QString::fromLatin1(
+      QByteArray(reinterpret_cast<const char *>(bytes), sizeof(bytes))
+          .toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals));
+}
+
+QString TokenUtils::hashRefreshToken(const QString &refreshToken) {
+  return QString::fromLatin1(
+      QCryptographicHash::hash(refreshToken.toUtf8(), QCryptographicHash::Sha256).toHex());
 }
 
 QString TokenUtils::generateToken(const QString &userId, const QString &email,
-                                  bool isAdmin) {
+                                  bool isAdmin, const QString &sessionId) {
   auto now = std::chrono::system_clock::now();
 
   auto token = jwt::create()
                    .set_issuer("CakePlanner")
                    .set_type("JWS")
                    .set_issued_at(now)
-                   .set_expires_at(now + std::chrono::hours(24))
+                   .set_expires_at(now + std::chrono::seconds(accessTokenTtl()))
                    .set_payload_claim("uid", jwt::claim(userId.toStdString()))
                    .set_payload_claim("sub", jwt::claim(email.toStdString()))
                    .set_payload_claim("adm", jwt::claim(json_value(isAdmin)))
+                   .set_payload_claim("sid", jwt::claim(sessionId.toStdString()))
                    .sign(jwt::algorithm::hs256{getSecret()});
 
   return QString::fromStdString(token);
@@ -54,12 +104,8 @@ QString TokenUtils::generateToken(const QString &userId, const QString &email,
 std::optional<TokenPayload>
 TokenUtils::verifyToken(const std::string &rawToken) {
   try {
-    auto verifier = jwt::verify()
-                        .allow_algorithm(jwt::algorithm::hs256{getSecret()})
-                        .with_issuer("CakePlanner");
-
     auto decoded = jwt::decode(rawToken);
-    verifier.verify(decoded);
+    getVerifier().verify(decoded);
 
     TokenPayload payload;
     payload.userId =
@@ -77,6 +123,15 @@ TokenUtils::verifyToken(const std::string &rawToken) {
       payload.isAdmin = false;
     }
 
+    if (decoded.has_payload_claim("sid")) {
+      payload.sessionId =
+          QString::fromStdString(decoded.get_payload_claim("sid").as_string());
+    }
+
+    payload.expiresAt = std::chrono::duration_cast<std::chrono::seconds>(
+                            decoded.get_expires_at().time_since_epoch())
+                            .count();
+
     return payload;
 
   } catch (const std::exception &e) {
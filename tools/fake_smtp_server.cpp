@@ -0,0 +1,302 @@
+/**
+ * @file fake_smtp_server.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief Local SMTP stand-in for tests and mail benchmarks
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Usage:
+ *   cake_fake_smtp [--port 2525] [--out-dir DIR] [--latency-ms N]
+ *                  [--fail-rate 0.0-1.0] [--fail-code 451]
+ *                  [--tls-cert cert.pem --tls-key key.pem]
+ *
+ * Without --out-dir messages are only counted (in memory). With a
+ * certificate the server advertises STARTTLS; plain sessions still work.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QSslKey>
+#include <QSslSocket>
+#include <QTcpServer>
+#include <QTextStream>
+#include <QTimer>
+
+#include <memory>
+
+namespace {
+
+struct Options {
+  quint16 port = 2525;
+  QString outDir;
+  int latencyMs = 0;
+  double failRate = 0.0;
+  int failCode = 451;
+  QSslConfiguration tls; // leer = kein STARTTLS
+  bool tlsEnabled = false;
+};
+
+struct Counters {
+  quint64 connections = 0;
+  quint64 accepted = 0;
+  quint64 rejected = 0;
+  quint64 bytes = 0;
+};
+
+// Ein SMTP-Dialog pro Verbindung
+class Session {
+public:
+  Session(QSslSocket *socket, const Options &opt, Counters &counters)
+      : m_socket(socket), m_opt(opt), m_counters(counters) {}
+
+  void start() { reply("220 cake-fake-smtp ESMTP ready"); }
+
+  void onReadyRead() {
+    m_buffer += m_socket->readAll();
+    qsizetype eol;
+    while (!m_waitingForLatency && (eol = m_buffer.indexOf("\r\n")) >= 0) {
+      QByteArray line = m_buffer.left(eol);
+      m_buffer.remove(0, eol + 2);
+      if (m_inData) {
+        dataLine(line);
+      } else {
+        command(line);
+      }
+    }
+  }
+
+private:
+  void reply(const QByteArray &text) {
+    m_socket->write(text + "\r\n");
+  }
+
+  void command(const QByteArray &line) {
+    if (m_authStep > 0) {
+      // Antworten auf AUTH LOGIN (Benutzer, Passwort)
+      if (--m_authStep > 0) {
+        reply("334 UGFzc3dvcmQ6");
+      } else {
+        reply("235 2.7.0 Authentication successful");
+      }
+      return;
+    }
+
+    QByteArray verb = line.left(line.indexOf(' ')).toUpper();
+    if (verb.isEmpty()) verb = line.toUpper();
+
+    if (verb == "EHLO") {
+      reply("250-cake-fake-smtp");
+      if (m_opt.tlsEnabled && !m_socket->isEncrypted()) reply("250-STARTTLS");
+      reply("250-AUTH PLAIN LOGIN");
+      reply("250-8BITMIME");
+      reply("250 PIPELINING");
+    } else if (verb == "HELO") {
+      reply("250 cake-fake-smtp");
+    } else if (verb == "STARTTLS") {
+      if (!m_opt.tlsEnabled || m_socket->isEncrypted()) {
+        reply("454 TLS not available");
+        return;
+      }
+      reply("220 Ready to start TLS");
+      m_socket->flush();
+      m_socket->setSslConfiguration(m_opt.tls);
+      m_socket->startServerEncryption();
+    } else if (verb == "AUTH") {
+      // Jede Anmeldung wird akzeptiert
+      if (line.toUpper().startsWith("AUTH LOGIN")) {
+        m_authStep = line.count(' ') >= 2 ? 1 : 2;
+        reply(m_authStep == 2 ? "334 VXNlcm5hbWU6" : "334 UGFzc3dvcmQ6");
+      } else {
+        reply("235 2.7.0 Authentication successful");
+      }
+    } else if (verb == "MAIL") {
+      m_from = line.mid(line.indexOf(':') + 1).trimmed();
+      m_rcpt.clear();
+      reply("250 2.1.0 OK");
+    } else if (verb == "RCPT") {
+      m_rcpt << line.mid(line.indexOf(':') + 1).trimmed();
+      reply("250 2.1.5 OK");
+    } else if (verb == "DATA") {
+      m_inData = true;
+      m_message.clear();
+      reply("354 End data with <CR><LF>.<CR><LF>");
+    } else if (verb == "RSET") {
+      m_from.clear();
+      m_rcpt.clear();
+      reply("250 2.0.0 OK");
+    } else if (verb == "NOOP") {
+      reply("250 2.0.0 OK");
+    } else if (verb == "QUIT") {
+      reply("221 2.0.0 Bye");
+      m_socket->disconnectFromHost();
+    } else {
+      reply("502 5.5.2 Command not recognized");
+    }
+  }
+
+  void dataLine(const QByteArray &line) {
+    if (line != ".") {
+      // Dot-Stuffing rückgängig machen
+      m_message += line.startsWith("..") ? line.mid(1) : line;
+      m_message += "\r\n";
+      return;
+    }
+
+    m_inData = false;
+    if (m_opt.latencyMs <= 0) {
+      finishMessage();
+      return;
+    }
+    // Keine weiteren Kommandos verarbeiten, bis die Antwort raus ist
+    m_waitingForLatency = true;
+    QTimer::singleShot(m_opt.latencyMs, m_socket, [this]() {
+      m_waitingForLatency = false;
+      finishMessage();
+      onReadyRead();
+    });
+  }
+
+  void finishMessage() {
+    m_counters.bytes += m_message.size();
+    if (m_opt.failRate > 0.0 && QRandomGenerator::global()->generateDouble() < m_opt.failRate) {
+      m_counters.rejected++;
+      reply(QByteArray::number(m_opt.failCode) + " Injected failure");
+      return;
+    }
+
+    m_counters.accepted++;
+    if (!m_opt.outDir.isEmpty()) {
+      QString name = QString("%1-%2.eml")
+                         .arg(QDateTime::currentMSecsSinceEpoch())
+                         .arg(m_counters.accepted);
+      QFile file(QDir(m_opt.outDir).filePath(name));
+      if (file.open(QIODevice::WriteOnly)) {
+        file.write("X-Fake-Mail-From: " + m_from + "\r\n");
+        file.write("X-Fake-Rcpt-To: " + m_rcpt.join(", ") + "\r\n");
+        file.write(m_message);
+      }
+    }
+    reply("250 2.0.0 Queued as " + QByteArray::number(m_counters.accepted));
+  }
+
+  QSslSocket *m_socket;
+  const Options &m_opt;
+  Counters &m_counters;
+  QByteArray m_buffer;
+  QByteArray m_message;
+  QByteArray m_from;
+  QByteArrayList m_rcpt;
+  bool m_inData = false;
+  bool m_waitingForLatency = false;
+  int m_authStep = 0;
+};
+
+// QTcpServer, der QSslSocket erzeugt (nötig für STARTTLS)
+class FakeSmtpServer : public QTcpServer {
+public:
+  FakeSmtpServer(const Options &opt, Counters &counters)
+      : m_opt(opt), m_counters(counters) {}
+
+protected:
+  void incomingConnection(qintptr descriptor) override {
+    auto *socket = new QSslSocket(this);
+    if (!socket->setSocketDescriptor(descriptor)) {
+      delete socket;
+      return;
+    }
+    m_counters.connections++;
+
+    auto session = std::make_shared<Session>(socket, m_opt, m_counters);
+    QObject::connect(socket, &QSslSocket::readyRead, socket,
+                     [session]() { session->onReadyRead(); });
+    // Die Session lebt über die Lambda-Verbindung genau so lange wie der Socket
+    QObject::connect(socket, &QSslSocket::disconnected, socket, &QObject::deleteLater);
+    session->start();
+  }
+
+private:
+  const Options &m_opt;
+  Counters &m_counters;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("cake_fake_smtp");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Local SMTP stand-in for CakePlanner tests and benchmarks");
+  parser.addHelpOption();
+  parser.addOptions({
+      {"port", "Listen port (default 2525).", "port", "2525"},
+      {"out-dir", "Write every accepted message as .eml into this directory.", "dir"},
+      {"latency-ms", "Delay before answering the end of DATA.", "ms", "0"},
+      {"fail-rate", "Fraction of messages rejected (0.0 - 1.0).", "rate", "0"},
+      {"fail-code", "SMTP code for injected failures (default 451).", "code", "451"},
+      {"tls-cert", "PEM certificate; enables STARTTLS.", "file"},
+      {"tls-key", "PEM private key for --tls-cert.", "file"},
+  });
+  parser.process(app);
+
+  Options opt;
+  opt.port = static_cast<quint16>(parser.value("port").toUInt());
+  opt.outDir = parser.value("out-dir");
+  opt.latencyMs = parser.value("latency-ms").toInt();
+  opt.failRate = parser.value("fail-rate").toDouble();
+  opt.failCode = parser.value("fail-code").toInt();
+
+  if (parser.isSet("tls-cert")) {
+    QFile certFile(parser.value("tls-cert"));
+    QFile keyFile(parser.value("tls-key"));
+    if (!certFile.open(QIODevice::ReadOnly) || !keyFile.open(QIODevice::ReadOnly)) {
+      qCritical() << "Zertifikat oder Schlüssel nicht lesbar";
+      return 1;
+    }
+    opt.tls = QSslConfiguration::defaultConfiguration();
+    opt.tls.setLocalCertificate(QSslCertificate(&certFile, QSsl::Pem));
+    opt.tls.setPrivateKey(QSslKey(&keyFile, QSsl::Rsa, QSsl::Pem));
+    opt.tls.setPeerVerifyMode(QSslSocket::VerifyNone);
+    opt.tlsEnabled = true;
+  }
+
+  if (!opt.outDir.isEmpty()) QDir().mkpath(opt.outDir);
+
+  Counters counters;
+  FakeSmtpServer server(opt, counters);
+  if (!server.listen(QHostAddress::LocalHost, opt.port)) {
+    qCritical() << "Listen fehlgeschlagen:" << server.errorString();
+    return 1;
+  }
+  qInfo() << "Fake-SMTP lauscht auf 127.0.0.1:" << opt.port
+          << (opt.tlsEnabled ? "(STARTTLS)" : "(plain)")
+          << "Latenz" << opt.latencyMs << "ms, Fehlerrate" << opt.failRate;
+
+  // Durchsatz alle 5 Sekunden ausgeben
+  QElapsedTimer clock;
+  clock.start();
+  quint64 lastAccepted = 0;
+  QTimer report;
+  QObject::connect(&report, &QTimer::timeout, [&]() {
+    double rate = (counters.accepted - lastAccepted) / 5.0;
+    lastAccepted = counters.accepted;
+    QTextStream(stdout) << "[" << clock.elapsed() / 1000 << "s] connections=" << counters.connections
+                        << " accepted=" << counters.accepted << " rejected=" << counters.rejected
+                        << " bytes=" << counters.bytes << " rate=" << rate << "/s\n";
+  });
+  report.start(5000);
+
+  return app.exec();
+}
@@ -0,0 +1,239 @@
+/**
+ * @file notification_bench.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief End-to-end throughput/latency benchmark for group notifications
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Measures NotificationService -> NotificationWorker -> outbox ->
+ * SendScheduler -> SmtpService -> SimpleMail against cake_fake_smtp:
+ *
+ *   cake_fake_smtp --port 2525 &
+ *   cake_notification_bench --smtp-port 2525 --sizes 10,100,1000,10000
+ *
+ * Uses a throw-away SQLite database. Send limits are disabled unless
+ * --keep-limits is given (then CAKE_SMTP_* from the environment apply).
+ */
+
+#include "database.hpp"
+#include "models/config_model.hpp"
+#include "services/notification_service.hpp"
+#include "services/notification_worker.hpp"
+#include "services/outbox_dispatcher.hpp"
+#include "services/smtp_service.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QUuid>
+#include <QVariant>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+struct RunResult {
+  int groupSize = 0;
+  double enqueueUs = 0;   // Request-Pfad: Job schreiben + Commit
+  double firstMailMs = 0; // bis zur ersten angenommenen Mail
+  double totalMs = 0;
+  double p50Ms = 0;
+  double p99Ms = 0;
+  int dead = 0;
+};
+
+// Gruppe mit 'size' Empfängern plus Bäcker anlegen (ohne Argon2)
+std::pair<QString, QString> seedGroup(int size, int run) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QString groupId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+  QString bakerId;
+
+  db.transaction();
+  QSqlQuery query(db);
+  query.prepare("INSERT INTO groups (id, name) VALUES (:id, :name)");
+  query.bindValue(":id", groupId);
+  query.bindValue(":name", QString("Bench %1").arg(size));
+  query.exec();
+
+  QSqlQuery user(db);
+  user.prepare("INSERT INTO users (id, full_name, email, password_hash, email_language, is_active) "
+               "VALUES (:id, :name, :email, 'bench', :lang, 1)");
+  QSqlQuery member(db);
+  member.prepare("INSERT INTO group_members (user_id, group_id) VALUES (:uid, :gid)");
+
+  for (int i = 0; i <= size; ++i) {
+    QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    if (i == 0) bakerId = id;
+    user.bindValue(":id", id);
+    user.bindValue(":name", QString("User %1").arg(i));
+    // Verschiedene Domains, damit die Domain-Buckets greifen
+    user.bindValue(":email", QString("u%1-r%2@bench%3.local").arg(i).arg(run).arg(i % 20));
+    user.bindValue(":lang", i % 2 ? "de" : "en");
+    user.exec();
+    member.bindValue(":uid", id);
+    member.bindValue(":gid", groupId);
+    member.exec();
+  }
+  db.commit();
+  return {groupId, bakerId};
+}
+
+int countStatus(const QString &status) {
+  auto db = DatabaseManager::instance().getDatabase();
+  QSqlQuery query(db);
+  query.prepare("SELECT COUNT(*) FROM email_outbox WHERE status = :status");
+  query.bindValue(":status", status);
+  return query.exec() && query.next() ? query.value(0).toInt() : 0;
+}
+
+double percentile(std::vector<double> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t idx = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+  return values[idx];
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("cake_notification_bench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Notification fan-out benchmark against a local SMTP server");
+  parser.addHelpOption();
+  parser.addOptions({
+      {"smtp-port", "Port of cake_fake_smtp (default 2525).", "port", "2525"},
+      {"sizes", "Comma separated group sizes.", "list", "10,100,1000,10000"},
+      {"pool", "SMTP connection pool size.", "n", "2"},
+      {"starttls", "Use STARTTLS towards the fake server."},
+      {"keep-limits", "Keep CAKE_SMTP_* send limits from the environment."},
+      {"timeout-sec", "Abort a run without progress after this many seconds.", "sec", "60"},
+  });
+  parser.process(app);
+
+  // Konfiguration für SmtpService/ConfigModel über die Umgebung
+  qputenv("SMTP_SERVER", "127.0.0.1");
+  qputenv("SMTP_PORT", parser.value("smtp-port").toUtf8());
+  qputenv("SMTP_USERNAME", "bench");
+  qputenv("SMTP_PASSWORD", "bench");
+  qputenv("SMTP_FROM", "bench@cakeplanner.local");
+  qputenv("SMTP_STARTTLS", parser.isSet("starttls") ? "true" : "false");
+  qputenv("SMTP_POOL_SIZE", parser.value("pool").toUtf8());
+  qputenv("CAKE_OUTBOX_POLL_MS", "50");
+  qputenv("CAKE_NOTIFY_POLL_MS", "50");
+  qputenv("CAKE_OUTBOX_BATCH", "200");
+  if (!parser.isSet("keep-limits")) {
+    qputenv("CAKE_SMTP_RATE_PER_MIN", "0");
+    qputenv("CAKE_SMTP_DOMAIN_RATE_PER_MIN", "0");
+  }
+
+  QTemporaryDir tmp;
+  DatabaseManager::instance().initialize(tmp.filePath("bench.db"));
+  if (!DatabaseManager::instance().migrate()) return 1;
+
+  rz::model::ConfigModel config;
+  config.loadEnv(tmp.filePath("none.env").toStdString());
+
+  rz::service::SmtpService smtp(config, &app);
+  rz::service::OutboxDispatcher outbox(&smtp, &app);
+  outbox.start();
+  rz::service::NotificationService notify(&outbox);
+  rz::service::NotificationWorker worker(&notify, &outbox, &app);
+  notify.setWorker(&worker);
+  worker.start();
+
+  std::vector<int> sizes;
+  for (const auto &s : parser.value("sizes").split(',', Qt::SkipEmptyParts)) sizes.push_back(s.toInt());
+  const int timeoutMs = parser.value("timeout-sec").toInt() * 1000;
+
+  std::vector<RunResult> results;
+  size_t runIndex = 0;
+
+  // Zustand des laufenden Durchgangs
+  RunResult current;
+  QElapsedTimer clock, sinceProgress;
+  int baselineSent = 0, lastSent = 0;
+  std::vector<double> completions;
+  QTimer poll;
+
+  auto startRun = [&]() {
+    int size = sizes[runIndex];
+    auto [groupId, bakerId] = seedGroup(size, static_cast<int>(runIndex));
+
+    current = RunResult{};
+    current.groupSize = size;
+    completions.clear();
+    baselineSent = lastSent = countStatus("sent");
+
+    // Gleicher Pfad wie POST /api/events: Job in einer Transaktion
+    auto db = DatabaseManager::instance().getDatabase();
+    clock.start();
+    db.transaction();
+    notify.notifyGroupNewEvent(QUuid::createUuid().toString(QUuid::WithoutBraces), groupId,
+                               QString("Bench %1").arg(size), bakerId, "Baker", "2026-10-18");
+    db.commit();
+    current.enqueueUs = clock.nsecsElapsed() / 1000.0;
+    notify.dispatch();
+    sinceProgress.start();
+    poll.start(5);
+  };
+
+  QObject::connect(&poll, &QTimer::timeout, [&]() {
+    int sent = countStatus("sent");
+    double nowMs = clock.nsecsElapsed() / 1e6;
+    if (sent > lastSent) {
+      if (lastSent == baselineSent) current.firstMailMs = nowMs;
+      // Auflösung = Poll-Intervall: alle neuen Mails bekommen diesen Zeitpunkt
+      completions.insert(completions.end(), sent - lastSent, nowMs);
+      lastSent = sent;
+      sinceProgress.restart();
+    }
+
+    int done = sent - baselineSent;
+    bool finished = done >= current.groupSize;
+    if (!finished && sinceProgress.elapsed() < timeoutMs) return;
+
+    poll.stop();
+    current.totalMs = nowMs;
+    current.p50Ms = percentile(completions, 0.50);
+    current.p99Ms = percentile(completions, 0.99);
+    current.dead = countStatus("dead");
+    if (!finished) {
+      QTextStream(stderr) << "Run " << current.groupSize << ": timeout after " << done
+                          << " mails\n";
+    }
+    results.push_back(current);
+
+    if (++runIndex < sizes.size()) {
+      startRun();
+      return;
+    }
+
+    QTextStream out(stdout);
+    out << "group_size  enqueue_us  first_ms  total_ms  msgs_per_s  p50_ms  p99_ms  dead\n";
+    for (const auto &r : results) {
+      double rate = r.totalMs > 0 ? r.groupSize / (r.totalMs / 1000.0) : 0;
+      out << qSetFieldWidth(10) << r.groupSize << qSetFieldWidth(12) << r.enqueueUs
+          << qSetFieldWidth(10) << r.firstMailMs << qSetFieldWidth(10) << r.totalMs
+          << qSetFieldWidth(12) << rate << qSetFieldWidth(8) << r.p50Ms
+          << qSetFieldWidth(8) << r.p99Ms << qSetFieldWidth(6) << r.dead
+          << qSetFieldWidth(0) << "\n";
+    }
+    out.flush();
+    QCoreApplication::quit();
+  });
+
+  if (sizes.empty()) return 1;
+  QTimer::singleShot(0, startRun);
+  return app.exec();
+}
@@ -0,0 +1,271 @@
+/**
+ * @file prefork_bench.cpp
+ * @author ZHENG Robert (robert@hase-zheng.net)
+ * @brief HTTP throughput benchmark: single process vs. prefork workers
+ * @version 0.1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 ZHENG Robert
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Starts the server once per worker count (1 = single process with Crow's
+ * multithreaded io loops, >1 = CAKE_WORKERS prefork mode), each time on a
+ * fresh database in a temporary directory, logs in as the seeded admin and
+ * drives keep-alive GET requests from N connections:
+ *
+ *   cake_prefork_bench --server ./CakePlanner --workers 1,2,4 \
+ *       --connections 64 --seconds 10
+ *
+ * Note: a CakePlanner.env next to the server binary overrides the
+ * variables set here (EnvLoader searches the binary directory first).
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include <asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct RunResult {
+  int workers = 0;
+  double requestsPerSec = 0;
+  double p50Ms = 0;
+  double p99Ms = 0;
+  uint64_t errors = 0;
+};
+
+struct HttpResponse {
+  int status = 0;
+  std::string body;
+};
+
+/**
+ * @brief Minimal blocking HTTP/1.1 keep-alive client (Crow always sends
+ *        Content-Length, so no chunked decoding is needed).
+ */
+class HttpClient {
+public:
+  explicit HttpClient(uint16_t port) : m_socket(m_io), m_port(port) {}
+
+  std::optional<HttpResponse> request(const std::string &method, const std::string &path,
+                                      const std::string &token, const std::string &body = {}) {
+    try {
+      if (!m_socket.is_open()) {
+        m_socket.connect({asio::ip::make_address("127.0.0.1"), m_port});
+        m_socket.set_option(asio::ip::tcp::no_delay(true));
+      }
+
+      std::string req = method + " " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+      if (!token.empty()) req += "Authorization: Bearer " + token + "\r\n";
+      if (!body.empty()) {
+        req += "Content-Type: application/json\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\n";
+      }
+      req += "Connection: keep-alive\r\n\r\n" + body;
+      asio::write(m_socket, asio::buffer(req));
+
+      size_t headerLen = asio::read_until(m_socket, m_buffer, "\r\n\r\n");
+      std::string header(asio::buffers_begin(m_buffer.data()),
+                         asio::buffers_begin(m_buffer.data()) + headerLen);
+      m_buffer.consume(headerLen);
+
+      HttpResponse res;
+      if (header.size() > 12) res.status = std::atoi(header.c_str() + 9);
+
+      size_t contentLength = 0;
+      std::string lower = header;
+      std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+      auto pos = lower.find("content-length:");
+      if (pos != std::string::npos) contentLength = std::stoul(lower.substr(pos + 15));
+
+      if (m_buffer.size() < contentLength) {
+        asio::read(m_socket, m_buffer, asio::transfer_exactly(contentLength - m_buffer.size()));
+      }
+      res.body.assign(asio::buffers_begin(m_buffer.data()),
+                      asio::buffers_begin(m_buffer.data()) + contentLength);
+      m_buffer.consume(contentLength);
+      return res;
+    } catch (const std::exception &) {
+      // Verbindung verworfen: beim nächsten Request neu aufbauen
+      asio::error_code ignored;
+      m_socket.close(ignored);
+      m_buffer.consume(m_buffer.size());
+      return std::nullopt;
+    }
+  }
+
+private:
+  asio::io_context m_io;
+  asio::ip::tcp::socket m_socket;
+  asio::streambuf m_buffer;
+  uint16_t m_port;
+};
+
+double percentile(std::vector<double> &values, double p) {
+  if (values.empty()) return 0;
+  size_t idx = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+  std::nth_element(values.begin(), values.begin() + idx, values.end());
+  return values[idx];
+}
+
+// Login, sobald der Server (alle Worker) angenommen hat; leer bei Timeout
+std::string waitForLogin(uint16_t port, const QString &password, int timeoutSec) {
+  QJsonObject credentials{{"email", "admin@cakeplanner.local"}, {"password", password}};
+  std::string body = QJsonDocument(credentials).toJson(QJsonDocument::Compact).toStdString();
+
+  auto deadline = Clock::now() + std::chrono::seconds(timeoutSec);
+  while (Clock::now() < deadline) {
+    HttpClient client(port);
+    auto res = client.request("POST", "/api/login", {}, body);
+    if (res && res->status == 200) {
+      auto json = QJsonDocument::fromJson(QByteArray::fromStdString(res->body)).object();
+      return json.value("token").toString().toStdString();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+  return {};
+}
+
+RunResult runLoad(uint16_t port, const std::string &path, const std::string &token,
+                  int connections, int warmupSec, int seconds) {
+  std::atomic<bool> measuring{false};
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> errors{0};
+  std::vector<std::vector<double>> latencies(static_cast<size_t>(connections));
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < connections; ++i) {
+    threads.emplace_back([&, i]() {
+      HttpClient client(port);
+      auto &mine = latencies[static_cast<size_t>(i)];
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto started = Clock::now();
+        auto res = client.request("GET", path, token);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        if (!measuring.load(std::memory_order_relaxed)) continue;
+        if (res && res->status == 200) {
+          mine.push_back(ms);
+        } else {
+          errors.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(warmupSec));
+  measuring = true;
+  auto started = Clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  measuring = false;
+  double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+  stop = true;
+  for (auto &t : threads) t.join();
+
+  std::vector<double> all;
+  for (const auto &l : latencies) all.insert(all.end(), l.begin(), l.end());
+
+  RunResult result;
+  result.requestsPerSec = all.size() / elapsed;
+  result.p50Ms = percentile(all, 0.50);
+  result.p99Ms = percentile(all, 0.99);
+  result.errors = errors.load();
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("cake_prefork_bench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("HTTP throughput: single process vs. prefork workers");
+  parser.addHelpOption();
+  parser.addOptions({
+      {"server", "Path of the CakePlanner binary.", "path",
+       QDir(QCoreApplication::applicationDirPath()).filePath("../CakePlanner")},
+      {"workers", "Comma separated worker counts (1 = single process).", "list", "1,2,4"},
+      {"connections", "Concurrent keep-alive connections.", "n", "64"},
+      {"seconds", "Measured duration per run.", "sec", "10"},
+      {"warmup", "Warm-up before measuring.", "sec", "2"},
+      {"port", "Port for the server under test.", "port", "18080"},
+      {"path", "Request path (GET, as admin).", "path",
+       "/api/events?start=2026-01-01&end=2026-12-31"},
+  });
+  parser.process(app);
+
+  const QString server = parser.value("server");
+  const uint16_t port = static_cast<uint16_t>(parser.value("port").toUInt());
+  const std::string path = parser.value("path").toStdString();
+  const int connections = std::max(1, parser.value("connections").toInt());
+  const int seconds = std::max(1, parser.value("seconds").toInt());
+  const int warmup = std::max(0, parser.value("warmup").toInt());
+  const QString password = "bench-secret";
+
+  std::vector<RunResult> results;
+  for (const auto &w : parser.value("workers").split(',', Qt::SkipEmptyParts)) {
+    int workers = std::max(1, w.toInt());
+
+    QTemporaryDir tmp;
+    QProcess process;
+    process.setWorkingDirectory(tmp.path());
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.setStandardOutputFile(QProcess::nullDevice());
+
+    auto env = QProcessEnvironment::systemEnvironment();
+    env.insert("CAKE_WORKERS", QString::number(workers));
+    env.insert("CAKE_SERVER_PORT", QString::number(port));
+    env.insert("CAKE_ADMIN_PASSWORD", password);
+    process.setProcessEnvironment(env);
+
+    process.start(server);
+    if (!process.waitForStarted()) {
+      QTextStream(stderr) << "Cannot start " << server << "\n";
+      return 1;
+    }
+
+    std::string token = waitForLogin(port, password, 60);
+    RunResult result;
+    if (token.empty()) {
+      QTextStream(stderr) << "Run " << workers << ": server did not accept the login\n";
+    } else {
+      result = runLoad(port, path, token, connections, warmup, seconds);
+    }
+    result.workers = workers;
+    results.push_back(result);
+
+    process.terminate(); // SIGTERM: Supervisor gibt es an die Worker weiter
+    if (!process.waitForFinished(20000)) process.kill();
+    process.waitForFinished();
+  }
+
+  QTextStream out(stdout);
+  out << "mode         workers  req_per_s  p50_ms  p99_ms  errors\n";
+  for (const auto &r : results) {
+    out << qSetFieldWidth(13) << Qt::left << (r.workers == 1 ? "multithreaded" : "prefork")
+        << Qt::right << qSetFieldWidth(7) << r.workers << qSetFieldWidth(11) << r.requestsPerSec
+        << qSetFieldWidth(8) << r.p50Ms << qSetFieldWidth(8) << r.p99Ms << qSetFieldWidth(8)
+        << r.errors << qSetFieldWidth(0) << "\n";
+  }
+  out.flush();
+  return 0;
+}